@@ -22,12 +22,23 @@
 
 
 #include "Chip8.h"
+#include "Chip8Threaded.h"
+#include "Chip8Jit.h"
+#include "Chip8Stats.h"
+#include "Chip8Profile.h"
+#include "Chip8CallGraph.h"
+#include "Chip8Trace.h"
+#include "Chip8Metrics.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 #include <sys/timeb.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 
 /**
 * Returns time millicount used for get milliSpan
@@ -58,9 +69,10 @@ unsigned long  Chip8getMilliSpan(unsigned long nTimeStart)
 
 /**********************************************************************************************
  * This is the Chip 8 font set. Each number or character is 4 pixels wide and 5 pixel high.
+ * It fills the start of page 0, which every instance shares until it writes there.
  **********************************************************************************************/
-unsigned char chip8_fontset[240] =
-{ 
+static Chip8Page Chip8FontPage =
+{{ 
     0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
     0x20, 0x60, 0x20, 0x20, 0x70, // 1
     0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
@@ -95,7 +107,10 @@ unsigned char chip8_fontset[240] =
     0xE0, 0xE0, 0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0xE0, 0xE0, //D
     0xF0, 0xF0, 0x80, 0x80, 0xF0, 0xF0, 0x80, 0x80, 0xF0, 0xF0, //E
     0xF0, 0xF0, 0x80, 0x80, 0xF0, 0xF0, 0x80, 0x80, 0x80, 0x80  //F
-};
+}, 1};
+
+//every page of memory that has not been written points here
+static Chip8Page Chip8ZeroPage = {{0}, 1};
 
 /**********************************************************************************************
  * CHIP-8 has 35 opcodes, which are all two bytes long and stored big-endian. 
@@ -191,8 +206,286 @@ void (*Chip8ArithmeticOpcodeTable[16])(Chip8CPU *Chip8) =
     Chip8OpCode8XYE,
     Chip8CPUNULL
 };
+
+//declares the handlers of the quirk profiles other than modern, they are defined at the end of this file
+#define CHIP8_QUIRK_DECLARE(name)                                               \
+    static void name##VIP(Chip8CPU *Chip8);                                     \
+    static void name##CHIP48(Chip8CPU *Chip8);                                  \
+    static void name##SCHIP(Chip8CPU *Chip8);
+
+CHIP8_QUIRK_DECLARE(Chip8OpCode8XY1)
+CHIP8_QUIRK_DECLARE(Chip8OpCode8XY2)
+CHIP8_QUIRK_DECLARE(Chip8OpCode8XY3)
+CHIP8_QUIRK_DECLARE(Chip8OpCode8XY6)
+CHIP8_QUIRK_DECLARE(Chip8OpCode8XYE)
+CHIP8_QUIRK_DECLARE(Chip8OpCodeBNNN)
+CHIP8_QUIRK_DECLARE(Chip8OpCodeDXYN)
+CHIP8_QUIRK_DECLARE(Chip8OpCodeFX55)
+CHIP8_QUIRK_DECLARE(Chip8OpCodeFX65)
+
+//every leaf handler in CHIP8_OP_* order, profile is pasted onto the handlers that have quirks (empty for modern)
+#define CHIP8_DECODED_OPCODE_TABLE(profile)                                    \
+{                                                                              \
+    Chip8CPUNULL,                       /* CHIP8_OP_UNDECODED, never called */ \
+    Chip8CPUNULL,                                                              \
+    Chip8OpCode00CN,                                                           \
+    Chip8OpCode00E0,                                                           \
+    Chip8OpCode00EE,                                                           \
+    Chip8OpCode00FB,                                                           \
+    Chip8OpCode00FC,                                                           \
+    Chip8OpCode00FD,                                                           \
+    Chip8OpCode00FE,                                                           \
+    Chip8OpCode00FF,                                                           \
+    Chip8OpCode1NNN,                                                           \
+    Chip8OpCode2NNN,                                                           \
+    Chip8OpCode3XNN,                                                           \
+    Chip8OpCode4XNN,                                                           \
+    Chip8OpCode5XY0,                                                           \
+    Chip8OpCode6XN0,                                                           \
+    Chip8OpCode7XNN,                                                           \
+    Chip8OpCode8XY0,                                                           \
+    Chip8OpCode8XY1##profile,                                                  \
+    Chip8OpCode8XY2##profile,                                                  \
+    Chip8OpCode8XY3##profile,                                                  \
+    Chip8OpCode8XY4,                                                           \
+    Chip8OpCode8XY5,                                                           \
+    Chip8OpCode8XY6##profile,                                                  \
+    Chip8OpCode8XY7,                                                           \
+    Chip8OpCode8XYE##profile,                                                  \
+    Chip8OpCode9XY0,                                                           \
+    Chip8OpCodeANNN,                                                           \
+    Chip8OpCodeBNNN##profile,                                                  \
+    Chip8OpCodeCXKK,                                                           \
+    Chip8OpCodeDXYN##profile,                                                  \
+    Chip8OpCodeEX9E,                                                           \
+    Chip8OpCodeEXA1,                                                           \
+    Chip8OpCodeFX07,                                                           \
+    Chip8OpCodeFX0A,                                                           \
+    Chip8OpCodeFX15,                                                           \
+    Chip8OpCodeFX18,                                                           \
+    Chip8OpCodeFX1E,                                                           \
+    Chip8OpCodeFX29,                                                           \
+    Chip8OpCodeFX30,                                                           \
+    Chip8OpCodeFX33,                                                           \
+    Chip8OpCodeFX55##profile,                                                  \
+    Chip8OpCodeFX65##profile,                                                  \
+    Chip8OpCodeFX75,                                                           \
+    Chip8OpCodeFX85,                                                           \
+    Chip8OpCodeFX07Idle,                                                       \
+    Chip8OpCode1NNNIdle                                                        \
+}
+
+//Array of function pointers to every leaf OpCode, indexed by CHIP8_QUIRKS_* and CHIP8_OP_*
+//Entries are filled in by Chip8DecodeOpcode so the nested tables above are only walked once per address
+void (*Chip8DecodedOpcodeTable[CHIP8_QUIRKS_COUNT][CHIP8_OP_COUNT])(Chip8CPU *Chip8) = 
+{
+    CHIP8_DECODED_OPCODE_TABLE(),
+    CHIP8_DECODED_OPCODE_TABLE(VIP),
+    CHIP8_DECODED_OPCODE_TABLE(CHIP48),
+    CHIP8_DECODED_OPCODE_TABLE(SCHIP)
+};
+
+//leaf handlers for the 8???? OpCodes, indexed the same as Chip8ArithmeticOpcodeTable
+const unsigned char Chip8ArithmeticDecodeTable[16] = 
+{
+    CHIP8_OP_8XY0, CHIP8_OP_8XY1, CHIP8_OP_8XY2, CHIP8_OP_8XY3,
+    CHIP8_OP_8XY4, CHIP8_OP_8XY5, CHIP8_OP_8XY6, CHIP8_OP_8XY7,
+    CHIP8_OP_NULL, CHIP8_OP_NULL, CHIP8_OP_NULL, CHIP8_OP_NULL,
+    CHIP8_OP_NULL, CHIP8_OP_NULL, CHIP8_OP_8XYE, CHIP8_OP_NULL
+};
     
 
+/**
+* Adds a holder to a page
+*
+* @param page Address of the Chip8Page object
+* @return the page.
+*/
+static Chip8Page *Chip8HoldPage(Chip8Page *page)
+{
+    __atomic_add_fetch(&page->refs, 1, __ATOMIC_RELAXED);
+    return page;
+}
+
+/**
+* Drops a holder from a page, and frees it once nothing holds it (the font and zero pages are never freed)
+*
+* @param page Address of the Chip8Page object, or NULL
+* @return Nothing.
+*/
+static void Chip8ReleasePage(Chip8Page *page)
+{
+    if (page != NULL && __atomic_sub_fetch(&page->refs, 1, __ATOMIC_ACQ_REL) == 0)
+        free(page);
+}
+
+/**
+* Points one page of a instance at a new page of its own holding the given bytes, or at the zero page if they are all 0
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param index page number
+* @param data CHIP8_PAGE_SIZE bytes for the page
+* @return false if there was no memory for the page.
+*/
+static bool Chip8SetPage(Chip8CPU *Chip8, int index, const unsigned char *data)
+{
+    Chip8Page *page = &Chip8ZeroPage;
+
+    if (memcmp(data, Chip8ZeroPage.data, CHIP8_PAGE_SIZE) != 0)
+    {
+        page = (Chip8Page *)malloc(sizeof(Chip8Page));
+        if (page == NULL)
+            return false;
+
+        memcpy(page->data, data, CHIP8_PAGE_SIZE);
+        page->refs = 0;
+    }
+
+    Chip8ReleasePage(Chip8->pages[index]);
+    Chip8->pages[index] = Chip8HoldPage(page);
+
+    return true;
+}
+
+/**
+* Gives a instance its own copy of one of its pages
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param index page number
+* @return the new page, or NULL if there was no memory for it.
+*/
+static Chip8Page *Chip8CopyPage(Chip8CPU *Chip8, int index)
+{
+    Chip8Page *page = (Chip8Page *)malloc(sizeof(Chip8Page));
+    if (page == NULL)
+        return NULL;
+
+    memcpy(page->data, Chip8->pages[index]->data, CHIP8_PAGE_SIZE);
+    page->refs = 1;
+
+    Chip8ReleasePage(Chip8->pages[index]);
+    Chip8->pages[index] = page;
+
+    return page;
+}
+
+/**
+* Frees the memory pages, JIT cache, opcode counts, profile and call graph of a Chip8CPU object that is no longer used
+* The object can be used again after a Chip8Reset.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8Free(Chip8CPU *Chip8)
+{
+    for (int i = 0; i < CHIP8_PAGE_COUNT; i++)
+    {
+        Chip8ReleasePage(Chip8->pages[i]);
+        Chip8->pages[i] = NULL;
+    }
+
+    Chip8JitFree(Chip8);
+
+    free(Chip8->stats);
+    Chip8->stats = NULL;
+    free(Chip8->profile);
+    Chip8->profile = NULL;
+    free(Chip8->callGraph);
+    Chip8->callGraph = NULL;
+}
+
+/**
+* Writes a byte of memory, copying the page first if it is shared with other instances
+* Does not drop the predecoded opcodes, see Chip8InvalidateDecodeCache.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address address to write, wrapped to 12 bits
+* @param value byte to write
+* @return Nothing.
+*/
+void Chip8Write(Chip8CPU *Chip8, unsigned short address, unsigned char value)
+{
+    address &= 0x0FFF;
+    Chip8Page *page = Chip8->pages[address / CHIP8_PAGE_SIZE];
+
+    //the first write to a shared page gives this instance its own copy
+    if (__atomic_load_n(&page->refs, __ATOMIC_ACQUIRE) != 1)
+    {
+        page = Chip8CopyPage(Chip8, address / CHIP8_PAGE_SIZE);
+        if (page == NULL)
+            return;
+    }
+
+    page->data[address % CHIP8_PAGE_SIZE] = value;
+}
+
+/**
+* Gives a instance the same memory as another one by sharing its pages, so starting many sessions of one game
+* costs no copies. Either instance copies a page the first time it writes to it.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param source Address of the Chip8CPU object to share the memory of
+* @return Nothing.
+*/
+void Chip8ShareMemory(Chip8CPU *Chip8, Chip8CPU *source)
+{
+    if (Chip8 == source)
+        return;
+
+    for (int i = 0; i < CHIP8_PAGE_COUNT; i++)
+    {
+        Chip8Page *page = Chip8HoldPage(source->pages[i]);
+
+        Chip8ReleasePage(Chip8->pages[i]);
+        Chip8->pages[i] = page;
+    }
+
+    //the source's predecoded opcodes are right for the same memory
+    memcpy(Chip8->decodeCache, source->decodeCache, 4096);
+    Chip8JitInvalidate(Chip8, 0, 4096);
+    Chip8->memoryWrites++;
+}
+
+/**
+* Sets the seed of the random numbers CXKK uses and restarts them from it
+* Every instance has its own generator, so the same seed, ROM and keys always give the same game.
+* A zeroed Chip8CPU uses seed 0, which is a fixed seed like any other.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param seed the seed
+* @return Nothing.
+*/
+void Chip8Seed(Chip8CPU *Chip8, uint64_t seed)
+{
+    Chip8->seed = seed;
+
+    //splitmix64 spreads the seed over all the bits, xorshift must not start at 0
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+
+    Chip8->random = z != 0 ? z : 1;
+}
+
+/**
+* Returns the next random byte of a instance, used by CXKK
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return a random number from 0 to 255.
+*/
+unsigned char Chip8Random(Chip8CPU *Chip8)
+{
+    //xorshift64*, the top bits are the best ones
+    uint64_t x = Chip8->random;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    Chip8->random = x;
+
+    return (x * 0x2545F4914F6CDD1DULL) >> 56;
+}
+
 /**
 * Resets the Chip8CPU to power on defaults
 * Loads the default font set into memory
@@ -209,20 +502,56 @@ void Chip8Reset(Chip8CPU *Chip8)
     Chip8->soundTimer = 0;
     Chip8->refreshScreen = false;
     Chip8->playBeep = false;
-    Chip8->lastTick = Chip8->lastTick2 = 0;
+    Chip8->lastTick = 0;
+    Chip8->cycles = 0;
+    Chip8->skippedCycles = 0;
+    Chip8->timerCycle = 0;
+    Chip8->runUntil = 0;
+    Chip8->waitingForKey = false;
+    Chip8->halted = false;
+
+    if (Chip8->cyclesPerFrame == 0)
+        Chip8->cyclesPerFrame = CHIP8_DEFAULT_CYCLES_PER_FRAME;
+
+    Chip8Seed(Chip8, Chip8->seed);
 
     memset(Chip8->V, 0, 16);
     memset(Chip8->R, 0, 8);
     memset(Chip8->key, 0, 16);
-    memset(Chip8->videoMemory, 0, 8192);
-    memset(Chip8->memory, 0, 4096);
-
+    memset(Chip8->videoMemory, 0, sizeof(Chip8->videoMemory));
+    memset(Chip8->decodeCache, CHIP8_OP_UNDECODED, 4096);
+    Chip8JitInvalidate(Chip8, 0, 4096);
+    Chip8->memoryWrites++;
 
     Chip8->refreshScreen = false;
+    Chip8->dirtyRows = ~0ULL;
 
-    for(int i = 0; i < 240; ++i)
-        Chip8->memory[i] = chip8_fontset[i];
+    //the font page and zero pages are shared, nothing is copied until the game writes to memory
+    for (int i = 0; i < CHIP8_PAGE_COUNT; i++)
+    {
+        Chip8ReleasePage(Chip8->pages[i]);
+        Chip8->pages[i] = Chip8HoldPage(i == 0 ? &Chip8FontPage : &Chip8ZeroPage);
+    }
 
+#ifdef CHIP8_STATS
+    //the counts are kept over resets, so they cover a whole session
+    if (Chip8->stats == NULL)
+        Chip8->stats = (Chip8Stats *)calloc(1, sizeof(Chip8Stats));
+#endif
+#ifdef CHIP8_PROFILE
+    if (Chip8->profile == NULL)
+    {
+        Chip8->profile = (Chip8Profile *)calloc(1, sizeof(Chip8Profile));
+        if (Chip8->profile != NULL)
+            Chip8->profile->countdown = CHIP8_PROFILE_INTERVAL;
+    }
+#endif
+#ifdef CHIP8_CALLGRAPH
+    //the calls are kept over resets, but the game starts again at the root
+    if (Chip8->callGraph == NULL)
+        Chip8->callGraph = (Chip8CallGraph *)calloc(1, sizeof(Chip8CallGraph));
+    Chip8CallGraphRestart(Chip8);
+#endif
 }
 
 /**
@@ -243,93 +572,726 @@ bool Chip8LoadRom(Chip8CPU *Chip8, char *filename)
     unsigned char b;
     int i = 0x200;
 
-    while (!feof(file))
+    //stop at the end of memory, a file too big for it is cut off
+    while (!feof(file) && i < 4096)
+    {
+        fread(&b, sizeof(char), 1, file);
+        //printf("%i", b);
+        Chip8Write(Chip8, i++, b);
+    }
+    
+    fclose(file);
+
+    Chip8InvalidateDecodeCache(Chip8, 0x200, i - 0x200);
+
+    return true;
+}
+
+//chunk tags of the save state format
+#define CHIP8_STATE_REGISTERS   'R'     //registers, timers, keys, flags and cycle counters
+#define CHIP8_STATE_STACK       'S'     //the used entries of the call stack
+#define CHIP8_STATE_DISPLAY     'D'     //a layout byte (0 64x32, 1 128x64) and the rows, 1 bit per pixel
+#define CHIP8_STATE_MEMORY      'M'     //a 2 byte mask of the stored pages, then those pages
+#define CHIP8_STATE_END         'E'     //Adler-32 of every byte before the chunk
+
+//bits of the flags byte in the registers chunk
+#define CHIP8_STATE_EXTENDED    1
+#define CHIP8_STATE_WAITING     2
+#define CHIP8_STATE_HALTED      4
+#define CHIP8_STATE_BEEP        8
+
+//size of the registers chunk data, version 1 states do not have the random number seed and state at the end
+#define CHIP8_STATE_REGISTERS_SIZE  74
+#define CHIP8_STATE_REGISTERS_V1    58
+
+/**
+* Computes the Adler-32 checksum of a buffer
+*
+* @param data the bytes
+* @param length number of bytes
+* @return the checksum.
+*/
+static uint32_t Chip8StateChecksum(const unsigned char *data, size_t length)
+{
+    uint32_t a = 1, b = 0;
+
+    while (length > 0)
+    {
+        //5552 bytes is the most that can be summed before b may overflow
+        size_t block = length < 5552 ? length : 5552;
+        length -= block;
+
+        //16 bytes at a time, b gets each byte times the number of sums it is still part of
+        for (; block >= 16; block -= 16, data += 16)
+        {
+            uint32_t sum = 0, weighted = 0;
+            for (int i = 0; i < 16; i++)
+            {
+                sum += data[i];
+                weighted += (16 - i) * data[i];
+            }
+
+            b += 16 * a + weighted;
+            a += sum;
+        }
+
+        while (block--)
+        {
+            a += *data++;
+            b += a;
+        }
+
+        a %= 65521;
+        b %= 65521;
+    }
+
+    return (b << 16) | a;
+}
+
+/**
+* Writes a little endian number of bytes to a buffer
+*
+* @param out where to write
+* @param value the number
+* @param bytes number of bytes to write
+* @return the byte after the number.
+*/
+static unsigned char *Chip8StatePut(unsigned char *out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        *out++ = (value >> (i * 8)) & 0xFF;
+
+    return out;
+}
+
+/**
+* Reads a little endian number of bytes from a buffer
+*
+* @param in where to read
+* @param bytes number of bytes to read
+* @return the number.
+*/
+static uint64_t Chip8StateGet(const unsigned char *in, int bytes)
+{
+    uint64_t value = 0;
+
+    for (int i = 0; i < bytes; i++)
+        value |= (uint64_t)in[i] << (i * 8);
+
+    return value;
+}
+
+/**
+* Writes 64 pixels of a display row, the left pixel (the top bit) first
+*
+* @param out where to write the 8 bytes
+* @param pixels the pixels
+* @return the byte after the pixels.
+*/
+static inline unsigned char *Chip8StatePutRow(unsigned char *out, unsigned long long pixels)
+{
+    out[0] = pixels >> 56;
+    out[1] = pixels >> 48;
+    out[2] = pixels >> 40;
+    out[3] = pixels >> 32;
+    out[4] = pixels >> 24;
+    out[5] = pixels >> 16;
+    out[6] = pixels >> 8;
+    out[7] = pixels;
+
+    return out + 8;
+}
+
+/**
+* Reads 64 pixels of a display row written by Chip8StatePutRow
+*
+* @param in where to read the 8 bytes
+* @return the pixels.
+*/
+static inline unsigned long long Chip8StateGetRow(const unsigned char *in)
+{
+    return (unsigned long long)in[0] << 56 | (unsigned long long)in[1] << 48 | (unsigned long long)in[2] << 40 |
+           (unsigned long long)in[3] << 32 | (unsigned long long)in[4] << 24 | (unsigned long long)in[5] << 16 |
+           (unsigned long long)in[6] << 8 | in[7];
+}
+
+/**
+* Writes the state of the machine to a buffer in the portable save state format, no files are used
+* The format is little endian and versioned: CHIP8_STATE_MAGIC, the version byte, then chunks of a tag byte, a 2 byte length
+* and the data, ending with a checksum. Only the used stack, the used part of the display (1 bit per pixel) and
+* the memory pages that are not all zeros are stored. The backend and the predecoded opcodes are not stored.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param buffer where to write the state
+* @param size size of the buffer, CHIP8_STATE_MAX_SIZE is always enough
+* @return number of bytes written, 0 if the buffer is too small.
+*/
+size_t Chip8SerializeState(Chip8CPU *Chip8, unsigned char *buffer, size_t size)
+{
+    //which pages are stored, and how much of the stack and display is used
+    unsigned short pageMask = 0;
+    int pages = 0;
+    for (int i = 0; i < CHIP8_PAGE_COUNT; i++)
+    {
+        if (Chip8->pages[i] != &Chip8ZeroPage && memcmp(Chip8->pages[i]->data, Chip8ZeroPage.data, CHIP8_PAGE_SIZE) != 0)
+        {
+            pageMask |= 1 << i;
+            pages++;
+        }
+    }
+
+    int depth = Chip8->sp < 16 ? Chip8->sp : 16;
+
+    //the 64x32 layout is enough unless a pixel outside of it is set
+    bool large = false;
+    for (int y = 0; y < 64; y++)
+    {
+        if (Chip8->videoMemory[y][1] != 0 || (y >= 32 && Chip8->videoMemory[y][0] != 0))
+            large = true;
+    }
+
+    size_t length = 5 + 3 + CHIP8_STATE_REGISTERS_SIZE + 3 + depth * 2 + 3 + 1 + (large ? 64 * 16 : 32 * 8) +
+        3 + 2 + pages * CHIP8_PAGE_SIZE + 3 + 4;
+    if (length > size)
+        return 0;
+
+    unsigned char *out = buffer;
+    memcpy(out, CHIP8_STATE_MAGIC, 4);
+    out += 4;
+    *out++ = CHIP8_STATE_VERSION;
+
+    *out++ = CHIP8_STATE_REGISTERS;
+    out = Chip8StatePut(out, CHIP8_STATE_REGISTERS_SIZE, 2);
+    out = Chip8StatePut(out, Chip8->pc, 2);
+    out = Chip8StatePut(out, Chip8->I, 2);
+    out = Chip8StatePut(out, Chip8->opcode, 2);
+    out = Chip8StatePut(out, Chip8->sp, 2);
+    memcpy(out, Chip8->V, 16);
+    out += 16;
+    memcpy(out, Chip8->R, 8);
+    out += 8;
+    *out++ = Chip8->delayTimer;
+    *out++ = Chip8->soundTimer;
+    *out++ = (Chip8->extendedGraphicsMode ? CHIP8_STATE_EXTENDED : 0) | (Chip8->waitingForKey ? CHIP8_STATE_WAITING : 0) |
+             (Chip8->halted ? CHIP8_STATE_HALTED : 0) | (Chip8->playBeep ? CHIP8_STATE_BEEP : 0);
+    *out++ = Chip8->quirks;
+    unsigned short keys = 0;
+    for (int i = 0; i < 16; i++)
+        keys |= (Chip8->key[i] != 0) << i;
+    out = Chip8StatePut(out, keys, 2);
+    out = Chip8StatePut(out, Chip8->cyclesPerFrame, 4);
+    out = Chip8StatePut(out, Chip8->cycles, 8);
+    out = Chip8StatePut(out, Chip8->timerCycle, 8);
+    out = Chip8StatePut(out, Chip8->seed, 8);
+    out = Chip8StatePut(out, Chip8->random, 8);
+
+    *out++ = CHIP8_STATE_STACK;
+    out = Chip8StatePut(out, depth * 2, 2);
+    for (int i = 0; i < depth; i++)
+        out = Chip8StatePut(out, Chip8->stack[i], 2);
+
+    //rows are stored from the left pixel, 8 pixels a byte with the left one in the top bit
+    *out++ = CHIP8_STATE_DISPLAY;
+    out = Chip8StatePut(out, 1 + (large ? 64 * 16 : 32 * 8), 2);
+    *out++ = large ? 1 : 0;
+    for (int y = 0; y < (large ? 64 : 32); y++)
+    {
+        for (int word = 0; word < (large ? 2 : 1); word++)
+        {
+            out = Chip8StatePutRow(out, Chip8->videoMemory[y][word]);
+        }
+    }
+
+    *out++ = CHIP8_STATE_MEMORY;
+    out = Chip8StatePut(out, 2 + pages * CHIP8_PAGE_SIZE, 2);
+    out = Chip8StatePut(out, pageMask, 2);
+    for (int i = 0; i < CHIP8_PAGE_COUNT; i++)
+    {
+        if (pageMask & (1 << i))
+        {
+            memcpy(out, Chip8->pages[i]->data, CHIP8_PAGE_SIZE);
+            out += CHIP8_PAGE_SIZE;
+        }
+    }
+
+    *out++ = CHIP8_STATE_END;
+    out = Chip8StatePut(out, 4, 2);
+    out = Chip8StatePut(out, Chip8StateChecksum(buffer, out - buffer - 3), 4);
+
+    return out - buffer;
+}
+
+/**
+* Loads a state written by Chip8SerializeState
+* The whole state is checked (version, checksum and chunk sizes) before the machine is changed, and only the memory
+* that differs is written, so loading the same game state again and again is cheap.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param buffer the state
+* @param size number of bytes in the buffer
+* @return false if the buffer does not hold a valid state, the machine is not changed.
+*/
+bool Chip8DeserializeState(Chip8CPU *Chip8, const unsigned char *buffer, size_t size)
+{
+    if (size < 5 || memcmp(buffer, CHIP8_STATE_MAGIC, 4) != 0 || buffer[4] == 0 || buffer[4] > CHIP8_STATE_VERSION)
+        return false;
+
+    //find the chunks, a chunk with a tag this version does not know is skipped
+    const unsigned char *registers = NULL, *stack = NULL, *display = NULL, *memory = NULL;
+    size_t registersLength = 0, stackLength = 0, displayLength = 0, memoryLength = 0;
+    size_t position = 5;
+    bool ended = false;
+
+    while (!ended && position + 3 <= size)
+    {
+        unsigned char tag = buffer[position];
+        size_t length = Chip8StateGet(buffer + position + 1, 2);
+        const unsigned char *data = buffer + position + 3;
+
+        if (position + 3 + length > size)
+            return false;
+
+        switch (tag)
+        {
+            case CHIP8_STATE_REGISTERS: registers = data; registersLength = length; break;
+            case CHIP8_STATE_STACK:     stack = data;     stackLength = length;     break;
+            case CHIP8_STATE_DISPLAY:   display = data;   displayLength = length;   break;
+            case CHIP8_STATE_MEMORY:    memory = data;    memoryLength = length;    break;
+            case CHIP8_STATE_END:
+                if (length != 4 || Chip8StateGet(data, 4) != Chip8StateChecksum(buffer, position))
+                    return false;
+                ended = true;
+                break;
+        }
+
+        position += 3 + length;
+    }
+
+    //every chunk must be there and hold what it says it does
+    if (!ended || registers == NULL || stack == NULL || display == NULL || memory == NULL)
+        return false;
+
+    if (registersLength < CHIP8_STATE_REGISTERS_V1 || stackLength > 32 || stackLength % 2 != 0 ||
+        displayLength < 1 || memoryLength < 2)
+        return false;
+
+    bool large = display[0] == 1;
+    if (display[0] > 1 || displayLength != 1 + (size_t)(large ? 64 * 16 : 32 * 8))
+        return false;
+
+    unsigned short pageMask = Chip8StateGet(memory, 2);
+    if (memoryLength != 2 + (size_t)__builtin_popcount(pageMask) * CHIP8_PAGE_SIZE)
+        return false;
+
+    //the state is good, change the machine
+    Chip8->pc = Chip8StateGet(registers, 2);
+    Chip8->I = Chip8StateGet(registers + 2, 2);
+    Chip8->opcode = Chip8StateGet(registers + 4, 2);
+    Chip8->sp = Chip8StateGet(registers + 6, 2);
+    memcpy(Chip8->V, registers + 8, 16);
+    memcpy(Chip8->R, registers + 24, 8);
+    Chip8->delayTimer = registers[32];
+    Chip8->soundTimer = registers[33];
+    Chip8->extendedGraphicsMode = (registers[34] & CHIP8_STATE_EXTENDED) != 0;
+    Chip8->waitingForKey = (registers[34] & CHIP8_STATE_WAITING) != 0;
+    Chip8->halted = (registers[34] & CHIP8_STATE_HALTED) != 0;
+    Chip8->playBeep = (registers[34] & CHIP8_STATE_BEEP) != 0;
+    Chip8->quirks = registers[35] < CHIP8_QUIRKS_COUNT ? registers[35] : CHIP8_QUIRKS_MODERN;
+    unsigned short keys = Chip8StateGet(registers + 36, 2);
+    for (int i = 0; i < 16; i++)
+        Chip8->key[i] = (keys >> i) & 1;
+    Chip8->cyclesPerFrame = Chip8StateGet(registers + 38, 4);
+    if (Chip8->cyclesPerFrame == 0)
+        Chip8->cyclesPerFrame = CHIP8_DEFAULT_CYCLES_PER_FRAME;
+    Chip8->cycles = Chip8StateGet(registers + 42, 8);
+    Chip8->timerCycle = Chip8StateGet(registers + 50, 8);
+    if (registersLength >= CHIP8_STATE_REGISTERS_SIZE)
+    {
+        Chip8->seed = Chip8StateGet(registers + 58, 8);
+        Chip8->random = Chip8StateGet(registers + 66, 8);
+        if (Chip8->random == 0)
+            Chip8Seed(Chip8, Chip8->seed);
+    }
+    Chip8->runUntil = Chip8->cycles;
+    Chip8CallGraphRestart(Chip8);
+
+    memset(Chip8->stack, 0, sizeof(Chip8->stack));
+    for (size_t i = 0; i < stackLength / 2; i++)
+        Chip8->stack[i] = Chip8StateGet(stack + i * 2, 2);
+
+    memset(Chip8->videoMemory, 0, sizeof(Chip8->videoMemory));
+    display++;
+    for (int y = 0; y < (large ? 64 : 32); y++)
+    {
+        for (int word = 0; word < (large ? 2 : 1); word++)
+        {
+            Chip8->videoMemory[y][word] = Chip8StateGetRow(display);
+            display += 8;
+        }
+    }
+
+    //pages that have not changed are kept (and stay shared), the predecoded opcodes of the others are dropped
+    memory += 2;
+    for (int i = 0; i < CHIP8_PAGE_COUNT; i++)
+    {
+        const unsigned char *data = Chip8ZeroPage.data;
+        if (pageMask & (1 << i))
+        {
+            data = memory;
+            memory += CHIP8_PAGE_SIZE;
+        }
+
+        if (memcmp(Chip8->pages[i]->data, data, CHIP8_PAGE_SIZE) == 0)
+            continue;
+
+        if (__atomic_load_n(&Chip8->pages[i]->refs, __ATOMIC_ACQUIRE) == 1 && data != Chip8ZeroPage.data)
+            memcpy(Chip8->pages[i]->data, data, CHIP8_PAGE_SIZE);
+        else
+            Chip8SetPage(Chip8, i, data);
+
+        Chip8InvalidateDecodeCache(Chip8, i * CHIP8_PAGE_SIZE, CHIP8_PAGE_SIZE);
+    }
+
+    //the whole screen has to be redrawn
+    Chip8->dirtyRows = ~0ULL;
+    Chip8->refreshScreen = true;
+
+    return true;
+}
+
+/**
+* Saves the emulator state to a file, in the format of Chip8SerializeState
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename filename to save state to
+* @return false if the file could not be saved.
+*/
+bool Chip8SaveState(Chip8CPU *Chip8, char *filename)
+{
+    CHIP8_METRICS_START(start);
+    unsigned char buffer[CHIP8_STATE_MAX_SIZE];
+    size_t length = Chip8SerializeState(Chip8, buffer, sizeof(buffer));
+
+    FILE *file;
+    file = fopen(filename,"wb");
+    
+    if (!file)
+        return false;
+    
+    bool written = fwrite(buffer, 1, length, file) == length;
+    
+    fclose(file);
+    CHIP8_METRICS_TIME(saveTime, start);
+
+    return written;
+}
+
+/**
+* Loads the emulator state to a file, see Chip8DeserializeState
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename filename to Load state from
+* @return false if the file could not be loaded.
+*/
+bool Chip8LoadState(Chip8CPU *Chip8, char *filename)
+{
+    CHIP8_METRICS_START(start);
+    FILE *file;
+    file = fopen(filename,"rb");
+    
+    if (!file)
+        return false;
+
+    unsigned char buffer[CHIP8_STATE_MAX_SIZE];
+    size_t length = fread(buffer, 1, sizeof(buffer), file);
+    
+    fclose(file);
+
+    bool loaded = Chip8DeserializeState(Chip8, buffer, length);
+    CHIP8_METRICS_TIME(loadTime, start);
+
+    return loaded;
+}
+
+/**
+* Runs opcodes through the handler tables
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+static void Chip8RunHandlers(Chip8CPU *Chip8, uint64_t cycles)
+{
+    //the quirk profile is picked once here, not for every opcode
+    void (**handlers)(Chip8CPU *Chip8) = Chip8DecodedOpcodeTable[Chip8->quirks];
+
+    Chip8->runUntil = Chip8->cycles + cycles;
+
+    //the idle handlers can move cycles forward, so count with it
+    while (Chip8->cycles < Chip8->runUntil)
+    {
+        unsigned short pc = Chip8->pc & 0x0FFF;
+        Chip8->opcode = Chip8ReadOpcode(Chip8, pc);
+        Chip8->pc += 2;
+        CHIP8_STATS_COUNT(Chip8, Chip8->opcode, 1);
+        CHIP8_PROFILE_RUN(Chip8, pc);
+
+        //decode each address once, after that go straight to the leaf handler
+        unsigned char op = Chip8->decodeCache[pc];
+        if (op == CHIP8_OP_UNDECODED)
+            op = Chip8->decodeCache[pc] = Chip8DecodeAddress(Chip8, pc);
+        
+        (*handlers[op])(Chip8);
+        CHIP8_TRACE_RUN(Chip8, Chip8->cycles, pc, Chip8->opcode, Chip8->I, Chip8->V);
+        Chip8->cycles++;
+    }
+}
+
+/**
+* Runs a fixed number of opcodes using the selected backend
+* This never looks at the host clock, the caller decides how fast the game runs.
+* The timers count down once every cyclesPerFrame opcodes, so the same opcodes always give the same result.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+void Chip8RunCycles(Chip8CPU *Chip8, uint64_t cycles)
+{
+#ifdef CHIP8_METRICS
+    uint64_t skipped = Chip8->skippedCycles;
+#endif
+
+    if (Chip8->backend == CHIP8_BACKEND_THREADED)
+        Chip8RunThreaded(Chip8, cycles);
+    else if (Chip8->backend == CHIP8_BACKEND_JIT)
+        Chip8RunJit(Chip8, cycles);
+    else
+        Chip8RunHandlers(Chip8, cycles);
+
+    CHIP8_PROFILE_STOP(Chip8);
+    //the cycles fast-forwarded by the idle handlers were not run
+    CHIP8_METRICS_ADD(instructions, cycles - (Chip8->skippedCycles - skipped));
+    Chip8UpdateTimers(Chip8);
+}
+
+/**
+* Runs opcodes up to the next frame boundary (every cyclesPerFrame opcodes),
+* the timers count down once at the boundary, so calling this 60 times a second runs the game at full speed.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8RunFrame(Chip8CPU *Chip8)
+{
+    Chip8RunCycles(Chip8, Chip8->cyclesPerFrame - Chip8->cycles % Chip8->cyclesPerFrame);
+}
+
+/**
+* Fetches and runs a opcode using the selected backend
+* Does nothing if less than 1ms has passed since the last call, use Chip8RunCycles to run without the host clock
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8EmulateCycle(Chip8CPU *Chip8)
+{
+    if (Chip8getMilliSpan(Chip8->lastTick) < 1)
+        return;
+    Chip8->lastTick = Chip8getMilliCount();
+
+    Chip8RunCycles(Chip8, 1);
+}
+
+/**
+* Brings the delay and sound timers up to date with Chip8->cycles
+* The timers are not ticked as opcodes run, instead this counts the frame boundaries passed since the last update
+* and takes them off both timers at once. It is called by the timer opcodes and at the end of Chip8RunCycles.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8UpdateTimers(Chip8CPU *Chip8)
+{
+    uint64_t frames = Chip8->cycles / Chip8->cyclesPerFrame - Chip8->timerCycle / Chip8->cyclesPerFrame;
+    Chip8->timerCycle = Chip8->cycles;
+
+    if (frames == 0)
+        return;
+
+    CHIP8_METRICS_ADD(timerTicks, frames);
+
+    if (Chip8->delayTimer > frames)
+        Chip8->delayTimer -= frames;
+    else
+        Chip8->delayTimer = 0;
+
+    if (Chip8->soundTimer > frames)
+        Chip8->soundTimer -= frames;
+    else if (Chip8->soundTimer > 0)
+    {
+        Chip8->playBeep = true;
+        Chip8->soundTimer = 0;
+    }
+}
+
+/**
+* Decodes a opcode down to the handler that will run it
+* This walks the same tables and switches the handlers use, so it only needs to run once per address
+*
+* @param opcode the opcode to decode
+* @return the CHIP8_OP_* index of the handler in Chip8DecodedOpcodeTable.
+*/
+unsigned char Chip8DecodeOpcode(unsigned short opcode)
+{
+    switch ((opcode & 0xF000) >> 12)
+    {
+        case 0x0:
+            if ((opcode & 0x00F0) == 0x00C0)
+                return CHIP8_OP_00CN;
+            switch (opcode & 0x00FF)
+            {
+                case 0x00E0: return CHIP8_OP_00E0;
+                case 0x00EE: return CHIP8_OP_00EE;
+                case 0x00FB: return CHIP8_OP_00FB;
+                case 0x00FC: return CHIP8_OP_00FC;
+                case 0x00FD: return CHIP8_OP_00FD;
+                case 0x00FE: return CHIP8_OP_00FE;
+                case 0x00FF: return CHIP8_OP_00FF;
+            }
+            return CHIP8_OP_NULL;
+        case 0x1: return CHIP8_OP_1NNN;
+        case 0x2: return CHIP8_OP_2NNN;
+        case 0x3: return CHIP8_OP_3XNN;
+        case 0x4: return CHIP8_OP_4XNN;
+        case 0x5: return CHIP8_OP_5XY0;
+        case 0x6: return CHIP8_OP_6XNN;
+        case 0x7: return CHIP8_OP_7XNN;
+        case 0x8: return Chip8ArithmeticDecodeTable[opcode & 0x000F];
+        case 0x9: return CHIP8_OP_9XY0;
+        case 0xA: return CHIP8_OP_ANNN;
+        case 0xB: return CHIP8_OP_BNNN;
+        case 0xC: return CHIP8_OP_CXKK;
+        case 0xD: return CHIP8_OP_DXYN;
+        case 0xE:
+            switch (opcode & 0x00FF)
+            {
+                case 0x009E: return CHIP8_OP_EX9E;
+                case 0x00A1: return CHIP8_OP_EXA1;
+            }
+            return CHIP8_OP_NULL;
+        default:
+            switch (opcode & 0x00FF)
+            {
+                case 0x0007: return CHIP8_OP_FX07;
+                case 0x000A: return CHIP8_OP_FX0A;
+                case 0x0015: return CHIP8_OP_FX15;
+                case 0x0018: return CHIP8_OP_FX18;
+                case 0x001E: return CHIP8_OP_FX1E;
+                case 0x0029: return CHIP8_OP_FX29;
+                case 0x0030: return CHIP8_OP_FX30;
+                case 0x0033: return CHIP8_OP_FX33;
+                case 0x0055: return CHIP8_OP_FX55;
+                case 0x0065: return CHIP8_OP_FX65;
+                case 0x0075: return CHIP8_OP_FX75;
+                case 0x0085: return CHIP8_OP_FX85;
+            }
+            return CHIP8_OP_NULL;
+    }
+}
+
+/**
+* Drops the predecoded opcodes that overlap a range of memory
+* Must be called whenever memory that may hold code is written
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address first address that was written
+* @param length number of bytes that were written
+* @return Nothing.
+*/
+void Chip8InvalidateDecodeCache(Chip8CPU *Chip8, int address, int length)
+{
+    //writes past 0xFFF wrap around to 0x000
+    address &= 0x0FFF;
+    if (address + length > 4096)
     {
-        fread(&b, sizeof(char), 1, file);
-        //printf("%i", b);
-        Chip8->memory[i++] = b;
+        Chip8InvalidateDecodeCache(Chip8, 0, address + length - 4096);
+        length = 4096 - address;
     }
-    
-    fclose(file);
 
-    return true;
+    //Chip8DecodeAddress reads up to 5 bytes past the address it decodes
+    int start = address - 5;
+    int end = address + length;
+
+    if (start < 0)
+        start = 0;
+    if (end > 4096)
+        end = 4096;
+
+    if (start < end)
+        memset(Chip8->decodeCache + start, CHIP8_OP_UNDECODED, end - start);
+
+    Chip8->memoryWrites++;
+
+    Chip8JitInvalidate(Chip8, address, length);
 }
 
 /**
-* Saves the emulator state to a file
+* Decodes the opcode at a address, like Chip8DecodeOpcode, but also looks at the opcodes after it
+* so loops that only wait for the delay timer, and jumps to themselves, get their own idle handlers.
+* The result depends on the 6 bytes starting at address.
 *
 * @param Chip8 Address of the Chip8CPU object
-* @param filename filename to save state to
-* @return false if the file could not be saved.
+* @param address address of the opcode
+* @return the CHIP8_OP_* index of the handler in Chip8DecodedOpcodeTable.
 */
-bool Chip8SaveState(Chip8CPU *Chip8, char *filename)
+unsigned char Chip8DecodeAddress(Chip8CPU *Chip8, unsigned short address)
 {
-    FILE *file;
-    file = fopen(filename,"wb");
-    
-    if (!file)
-        return false;
-    
-    fwrite(Chip8, sizeof(Chip8CPU), 1, file);
-    
-    fclose(file);
+    unsigned short opcode = Chip8ReadOpcode(Chip8, address);
+    unsigned char op = Chip8DecodeOpcode(opcode);
 
-    return true;
+    if (address > 0xFFA)
+        return op;
+
+    if (op == CHIP8_OP_1NNN && (opcode & 0x0FFF) == address)
+        return CHIP8_OP_1NNN_IDLE;
+
+    if (op == CHIP8_OP_FX07)
+    {
+        unsigned short skip = Chip8ReadOpcode(Chip8, address + 2);
+        unsigned short jump = Chip8ReadOpcode(Chip8, address + 4);
+
+        if (skip == (0x3000 | (opcode & 0x0F00)) && jump == (0x1000 | address))
+            return CHIP8_OP_FX07_IDLE;
+    }
+
+    return op;
 }
 
 /**
-* Loads the emulator state to a file
+* Reads a pixel from the display
 *
 * @param Chip8 Address of the Chip8CPU object
-* @param filename filename to Load state from
-* @return false if the file could not be loaded.
+* @param x column, 0 to 63 (0 to 127 in extended graphics mode)
+* @param y row, 0 to 31 (0 to 63 in extended graphics mode)
+* @return true if the pixel is on.
 */
-bool Chip8LoadState(Chip8CPU *Chip8, char *filename)
+bool Chip8GetPixel(Chip8CPU *Chip8, int x, int y)
 {
-    FILE *file;
-    file = fopen(filename,"rb");
-    
-    if (!file)
-        return false;
-    
-       fread(Chip8, sizeof(Chip8CPU), 1, file);
-    
-    fclose(file);
-
-    return true;
+    return (Chip8->videoMemory[y & 63][(x >> 6) & 1] >> (63 - (x & 63))) & 1;
 }
 
 /**
-* Fetches and runs a opcode
+* Returns the rows of the current display mode as a dirtyRows mask
 *
 * @param Chip8 Address of the Chip8CPU object
-* @return Nothing.
+* @return bit y is set for every row y on the screen.
 */
-void Chip8EmulateCycle(Chip8CPU *Chip8)
+static unsigned long long Chip8ScreenRows(Chip8CPU *Chip8)
 {
-    if (Chip8getMilliSpan(Chip8->lastTick) < 1)
-        return;
-    Chip8->lastTick = Chip8getMilliCount();
-
-    Chip8->opcode = Chip8->memory[Chip8->pc++] << 8 | Chip8->memory[Chip8->pc++];
-    
-    //printf("opcode: %04X\n", Chip8->opcode );
-    
-    (*Chip8OpcodeTable[(Chip8->opcode&0xF000)>>12])(Chip8);
-
-    if (Chip8getMilliSpan(Chip8->lastTick2) > 6)
-    {
-        Chip8->lastTick2 = Chip8getMilliCount();
-        if(Chip8->delayTimer > 0)
-            --Chip8->delayTimer;
- 
-        if(Chip8->soundTimer > 0)
-        {
-            if(Chip8->soundTimer == 1)
-                Chip8->playBeep = true;
-            --Chip8->soundTimer;
-        }
-    }
+    if (Chip8->extendedGraphicsMode == true)
+        return ~0ULL;
+    return (1ULL << 32) - 1;
 }
 
 /*************************************************************************************************
@@ -345,6 +1307,7 @@ void Chip8EmulateCycle(Chip8CPU *Chip8)
 */
 void Chip8CPUNULL(Chip8CPU *Chip8)
 {
+    CHIP8_METRICS_ADD(badOpcodes, 1);
     printf("bad opcode: %04X at: %04X \n", Chip8->opcode, Chip8->pc );
 }
 
@@ -407,41 +1370,33 @@ void Chip8OpCode00XX(Chip8CPU *Chip8)
 void Chip8OpCode00E0(Chip8CPU *Chip8)
 {
     
-    memset(Chip8->videoMemory, 0, 8192);
+    memset(Chip8->videoMemory, 0, sizeof(Chip8->videoMemory));
+    Chip8->dirtyRows = ~0ULL;
     //Chip8->refreshScreen = true;
 }
 
 /**
 * Scroll display N lines down
-* Moves the memory pointer
+* Moves the rows down with one memmove and clears the top N rows
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode00CN(Chip8CPU *Chip8)
 {
-    
-    int screenx = 64;
     int screeny = 32;
 
     if (Chip8->extendedGraphicsMode == true)
-    {
-        screenx = 128;
         screeny = 64;
-    }
 
     int n = (Chip8->opcode & 0x000F);
 
-    for (int i = screeny; i >= n; --i)
-    {
-        int start = i *screeny;
-        for (auto j = start; j < (start + screenx); ++j)
-        {
-            Chip8->videoMemory[j] = Chip8->videoMemory[j - (screenx * n)];
-        }
-    }
+    if (n > screeny)
+        n = screeny;
 
-    memset(Chip8->videoMemory, 0, (n) * screenx);
+    memmove(Chip8->videoMemory[n], Chip8->videoMemory[0], (screeny - n) * sizeof(Chip8->videoMemory[0]));
+    memset(Chip8->videoMemory, 0, n * sizeof(Chip8->videoMemory[0]));
+    Chip8->dirtyRows |= Chip8ScreenRows(Chip8);
     //Chip8->refreshScreen = true;
 }
 
@@ -449,90 +1404,85 @@ void Chip8OpCode00CN(Chip8CPU *Chip8)
 * 00EE - Return from a subroutine. 
 * The interpreter sets the program counter to the address at the top of the stack,
 * then subtracts 1 from the stack pointer.
+* The stack has 16 entries, the stack pointer wraps around instead of running off the end.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode00EE(Chip8CPU *Chip8)
 {
-    Chip8->pc = Chip8->stack[--Chip8->sp];
+    CHIP8_CALLGRAPH_RETURN(Chip8, Chip8->cycles);
+    Chip8->pc = Chip8->stack[--Chip8->sp & 0x0F];
 }
 
 /**
 * Scroll display 4 pixels right (Super Chip-8)
-* 
+* Each row is shifted as a whole, the 4 pixels on the left are cleared
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode00FB(Chip8CPU *Chip8)
 {
-
-    int screenx = 64;
-    int screeny = 32;
-
     if (Chip8->extendedGraphicsMode == true)
     {
-        screenx = 128;
-        screeny = 64;
-    }
-
-    for (int i = 0; i < screeny; ++i)
-    {
-        int start = i * screenx;
-        for (auto j = start + (screenx - 1); j >= (start + 4); --j)
+        for (int i = 0; i < 64; ++i)
         {
-            Chip8->videoMemory[j] = Chip8->videoMemory[j - 4];
+            Chip8->videoMemory[i][1] = (Chip8->videoMemory[i][1] >> 4) | (Chip8->videoMemory[i][0] << 60);
+            Chip8->videoMemory[i][0] >>= 4;
         }
-
-        memset(Chip8->videoMemory + start, 0, 4);
     }
+    else
+    {
+        for (int i = 0; i < 32; ++i)
+            Chip8->videoMemory[i][0] >>= 4;
+    }
+
+    Chip8->dirtyRows |= Chip8ScreenRows(Chip8);
     Chip8->refreshScreen = true;
 }
 
 /**
 * Scroll display 4 pixels left (Super Chip-8)
-* 
+* Each row is shifted as a whole, the 4 pixels on the right are cleared
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode00FC(Chip8CPU *Chip8)
 {
-
-    int screenx = 64;
-    int screeny = 32;
-
     if (Chip8->extendedGraphicsMode == true)
     {
-        screenx = 128;
-        screeny = 64;
-    }
-
-    for (auto i = 0; i < screeny; ++i)
-    {
-        auto start = i * screenx;
-        for (auto j = start; j < start + (screenx - 4); ++j)
+        for (int i = 0; i < 64; ++i)
         {
-            Chip8->videoMemory[j] = Chip8->videoMemory[j + 4];
+            Chip8->videoMemory[i][0] = (Chip8->videoMemory[i][0] << 4) | (Chip8->videoMemory[i][1] >> 60);
+            Chip8->videoMemory[i][1] <<= 4;
         }
-
-        memset(Chip8->videoMemory + start + (screenx - 5), 0, 4);
     }
+    else
+    {
+        for (int i = 0; i < 32; ++i)
+            Chip8->videoMemory[i][0] <<= 4;
+    }
+
+    Chip8->dirtyRows |= Chip8ScreenRows(Chip8);
     Chip8->refreshScreen = true;
 }
 
 /**
 * Exit CHIP interpreter (Super Chip-8)
-* 
+* Sets halted and keeps pc on the 00FD, so every later run fast-forwards to its end
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode00FD(Chip8CPU *Chip8)
 {
-    //dont really do anything hre, reset i guess
-    Chip8Reset(Chip8);
+    //stay on this opcode and skip the rest of the run, the program only starts again after a reset
+    Chip8->halted = true;
+    Chip8->pc -= 2;
+    Chip8->skippedCycles += Chip8->runUntil - 1 - Chip8->cycles;
+    Chip8->cycles = Chip8->runUntil - 1;
 }
 
 /**
@@ -545,6 +1495,7 @@ void Chip8OpCode00FD(Chip8CPU *Chip8)
 void Chip8OpCode00FE(Chip8CPU *Chip8)
 {
     Chip8->extendedGraphicsMode = false;
+    Chip8->dirtyRows = ~0ULL;
 }
 
 /**
@@ -557,6 +1508,7 @@ void Chip8OpCode00FE(Chip8CPU *Chip8)
 void Chip8OpCode00FF(Chip8CPU *Chip8)
 {
     Chip8->extendedGraphicsMode = true;
+    Chip8->dirtyRows = ~0ULL;
 }
 
 /**
@@ -582,7 +1534,8 @@ void Chip8OpCode1NNN(Chip8CPU *Chip8)
 */
 void Chip8OpCode2NNN(Chip8CPU *Chip8)
 {
-    Chip8->stack[Chip8->sp++] = Chip8->pc;
+    CHIP8_CALLGRAPH_CALL(Chip8, Chip8->opcode & 0x0FFF, Chip8->cycles);
+    Chip8->stack[Chip8->sp++ & 0x0F] = Chip8->pc;
     Chip8->pc = Chip8->opcode & 0x0FFF;
 }
 
@@ -597,7 +1550,10 @@ void Chip8OpCode2NNN(Chip8CPU *Chip8)
 void Chip8OpCode3XNN(Chip8CPU *Chip8)
 {
     if (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] == (Chip8->opcode & 0x00FF) )
+    {
         Chip8->pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_3XNN);
+    }
 }
 
 /**
@@ -611,7 +1567,10 @@ void Chip8OpCode3XNN(Chip8CPU *Chip8)
 void Chip8OpCode4XNN(Chip8CPU *Chip8)
 {
     if (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] != (Chip8->opcode & 0x00FF) )
+    {
         Chip8->pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_4XNN);
+    }
 }
 
 /**
@@ -625,7 +1584,10 @@ void Chip8OpCode4XNN(Chip8CPU *Chip8)
 void Chip8OpCode5XY0(Chip8CPU *Chip8)
 {
     if (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] == Chip8->V[(Chip8->opcode & 0x00F0) >> 4] )  
+    {
         Chip8->pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_5XY0);
+    }
 }
 
 /**
@@ -676,19 +1638,38 @@ void Chip8OpCode8XY0(Chip8CPU *Chip8)
     Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x00F0) >> 4]; 
 }
 
+//8XY1 for any CHIP8_QUIRKS_* profile, quirks is a constant in each caller
+static inline void Chip8OpCode8XY1Quirks(Chip8CPU *Chip8, const int quirks)
+{
+    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x0F00) >> 8] | Chip8->V[(Chip8->opcode & 0x00F0) >> 4];
+
+    if (CHIP8_QUIRK_VF_RESET(quirks))
+        Chip8->V[0xF] = 0;
+}
+
 /**
 * Set Vx = Vx OR Vy.
 * Performs a bitwise OR on the values of Vx and Vy, 
 * then stores the result in Vx. 
 * A bitwise OR compares the corrseponding bits from two values, 
 * and if either bit is 1, then the same bit in the result is also 1. Otherwise, it is 0. 
+* VF is set to 0 in the VIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode8XY1(Chip8CPU *Chip8)
 {
-    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x0F00) >> 8] | Chip8->V[(Chip8->opcode & 0x00F0) >> 4];  
+    Chip8OpCode8XY1Quirks(Chip8, CHIP8_QUIRKS_MODERN);
+}
+
+//8XY2 for any CHIP8_QUIRKS_* profile, quirks is a constant in each caller
+static inline void Chip8OpCode8XY2Quirks(Chip8CPU *Chip8, const int quirks)
+{
+    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x0F00) >> 8] & Chip8->V[(Chip8->opcode & 0x00F0) >> 4];
+
+    if (CHIP8_QUIRK_VF_RESET(quirks))
+        Chip8->V[0xF] = 0;
 }
 
 /**
@@ -697,13 +1678,23 @@ void Chip8OpCode8XY1(Chip8CPU *Chip8)
 * then stores the result in Vx.
 * A bitwise AND compares the corrseponding bits from two values,
 * and if both bits are 1, then the same bit in the result is also 1. Otherwise, it is 0. 
+* VF is set to 0 in the VIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode8XY2(Chip8CPU *Chip8)
 {
-    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x0F00) >> 8] & Chip8->V[(Chip8->opcode & 0x00F0) >> 4];
+    Chip8OpCode8XY2Quirks(Chip8, CHIP8_QUIRKS_MODERN);
+}
+
+//8XY3 for any CHIP8_QUIRKS_* profile, quirks is a constant in each caller
+static inline void Chip8OpCode8XY3Quirks(Chip8CPU *Chip8, const int quirks)
+{
+    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x0F00) >> 8] ^ Chip8->V[(Chip8->opcode & 0x00F0) >> 4];
+
+    if (CHIP8_QUIRK_VF_RESET(quirks))
+        Chip8->V[0xF] = 0;
 }
 
 /**
@@ -712,13 +1703,14 @@ void Chip8OpCode8XY2(Chip8CPU *Chip8)
 * then stores the result in Vx. 
 * An exclusive OR compares the corrseponding bits from two values, 
 * and if the bits are not both the same, then the corresponding bit in the result is set to 1. Otherwise, it is 0. 
+* VF is set to 0 in the VIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode8XY3(Chip8CPU *Chip8)
 {
-    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x0F00) >> 8] ^ Chip8->V[(Chip8->opcode & 0x00F0) >> 4];
+    Chip8OpCode8XY3Quirks(Chip8, CHIP8_QUIRKS_MODERN);
 }
 
 /**
@@ -758,18 +1750,28 @@ void Chip8OpCode8XY5(Chip8CPU *Chip8)
     Chip8->V[(Chip8->opcode & 0x0F00) >> 8] -= Chip8->V[(Chip8->opcode & 0x00F0) >> 4];
 }
 
+//8XY6 for any CHIP8_QUIRKS_* profile, quirks is a constant in each caller
+static inline void Chip8OpCode8XY6Quirks(Chip8CPU *Chip8, const int quirks)
+{
+    if (CHIP8_QUIRK_SHIFT_VY(quirks))
+        Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x00F0) >> 4];
+
+    Chip8->V[0xF] = (Chip8->V[(Chip8->opcode & 0x0F00) >> 8]) & 0x1;
+    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] >>= 1;
+}
+
 /**
 * Set Vx = Vx SHR 1.
 * If the least-significant bit of Vx is 1, then VF is set to 1, otherwise 0. 
 * Then Vx is divided by 2.
+* The VIP profile shifts Vy and stores the result in Vx.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode8XY6(Chip8CPU *Chip8)
 {
-    Chip8->V[0xF] = (Chip8->V[(Chip8->opcode & 0x0F00) >> 8]) & 0x1;
-    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] >>= 1;
+    Chip8OpCode8XY6Quirks(Chip8, CHIP8_QUIRKS_MODERN);
 }
 
 /**
@@ -790,18 +1792,28 @@ void Chip8OpCode8XY7(Chip8CPU *Chip8)
     Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x00F0) >> 4] - Chip8->V[(Chip8->opcode & 0x0F00) >> 8];                                    
 }
 
+//8XYE for any CHIP8_QUIRKS_* profile, quirks is a constant in each caller
+static inline void Chip8OpCode8XYEQuirks(Chip8CPU *Chip8, const int quirks)
+{
+    if (CHIP8_QUIRK_SHIFT_VY(quirks))
+        Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->V[(Chip8->opcode & 0x00F0) >> 4];
+
+    Chip8->V[0xF] = Chip8->V[(Chip8->opcode & 0x0F00) >> 8] >> 7;
+    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] <<= 1;
+}
+
 /**
 * Set Vx = Vx SHL 1.
 * If the most-significant bit of Vx is 1, then VF is set to 1, otherwise to 0. 
 * Then Vx is multiplied by 2.
+* The VIP profile shifts Vy and stores the result in Vx.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCode8XYE(Chip8CPU *Chip8)
 {
-    Chip8->V[0xF] = Chip8->V[(Chip8->opcode & 0x0F00) >> 8] >> 7;
-    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] <<= 1;
+    Chip8OpCode8XYEQuirks(Chip8, CHIP8_QUIRKS_MODERN);
 }
 
 /**
@@ -815,7 +1827,10 @@ void Chip8OpCode8XYE(Chip8CPU *Chip8)
 void Chip8OpCode9XY0(Chip8CPU *Chip8)
 {
     if (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] != Chip8->V[(Chip8->opcode & 0x00F0) >> 4])
+    {
         Chip8->pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_9XY0);
+    }
 }
 
 /**
@@ -830,16 +1845,26 @@ void Chip8OpCodeANNN(Chip8CPU *Chip8)
     Chip8->I = Chip8->opcode & 0x0FFF;
 }
 
+//BNNN for any CHIP8_QUIRKS_* profile, quirks is a constant in each caller
+static inline void Chip8OpCodeBNNNQuirks(Chip8CPU *Chip8, const int quirks)
+{
+    if (CHIP8_QUIRK_JUMP_VX(quirks))
+        Chip8->pc = (Chip8->opcode & 0x0FFF) + Chip8->V[(Chip8->opcode & 0x0F00) >> 8];
+    else
+        Chip8->pc = (Chip8->opcode & 0x0FFF) + Chip8->V[0];
+}
+
 /**
 * Jump to location nnn + V0.
 * The program counter is set to nnn plus the value of V0.
+* The CHIP-48 and SCHIP profiles jump to xnn + Vx (BXNN).
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCodeBNNN(Chip8CPU *Chip8)
 {
-    Chip8->pc = (Chip8->opcode & 0x0FFF) + Chip8->V[0];
+    Chip8OpCodeBNNNQuirks(Chip8, CHIP8_QUIRKS_MODERN);
 }
 
 /**
@@ -847,33 +1872,24 @@ void Chip8OpCodeBNNN(Chip8CPU *Chip8)
 * The interpreter generates a random number from 0 to 255, 
 * which is then ANDed with the value kk. 
 * The results are stored in Vx. 
+* The number comes from the instance's own generator (Chip8Random), so runs with the same seed are the same.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCodeCXKK(Chip8CPU *Chip8)
 {
-    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = (rand() % 0xFF) & (Chip8->opcode & 0x00FF);
+    Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8Random(Chip8) & (Chip8->opcode & 0x00FF);
 }
 
-/**
-* Display n-byte sprite starting at memory location I at (Vx, Vy), set VF = collision.
-* The interpreter reads n bytes from memory, starting at the address stored in I. 
-* These bytes are then displayed as sprites on screen at coordinates (Vx, Vy). 
-* Sprites are XORed onto the existing screen. If this causes any pixels to be erased, VF is set to 1, 
-* otherwise it is set to 0. If the sprite is positioned so part of it is outside the coordinates of the display, 
-* it wraps around to the opposite side of the screen.
-*
-* @param Chip8 Address of the Chip8CPU object
-* @return Nothing.
-*/
-void Chip8OpCodeDXYN(Chip8CPU *Chip8)
+//DXYN for any CHIP8_QUIRKS_* profile, quirks is a constant in each caller
+static inline void Chip8OpCodeDXYNQuirks(Chip8CPU *Chip8, const int quirks)
 {
     unsigned short x = Chip8->V[(Chip8->opcode & 0x0F00) >> 8];
     unsigned short y = Chip8->V[(Chip8->opcode & 0x00F0) >> 4];
     unsigned short height = Chip8->opcode & 0x000F;
-    unsigned short pixel;
-    Chip8->V[0xF] = 0;
+    unsigned short width = 8;
+    unsigned long long pixel;
 
     int screenx = 64;
     int screeny = 32;
@@ -884,49 +1900,107 @@ void Chip8OpCodeDXYN(Chip8CPU *Chip8)
         screeny = 64;
     }
 
-    //super Chip-8
+    //super Chip-8 16x16 sprite
     if (height == 0)
     {
-        height = 32;
-        for (int yline = 0; yline < height; yline += 2)
-        {
-            //pixel = Chip8->memory[Chip8->I + yline];
-            pixel = (Chip8->memory[Chip8->I + yline] << 8) | Chip8->memory[Chip8->I + yline + 1];
-            for (int xline = 0; xline < 16; xline++)
-            {
-                if ((pixel & (0x8000 >> xline)) != 0)
-                {
-                    if (Chip8->videoMemory[(x + xline + ((y + (yline / 2)) * screenx))] == 1)
-                    {
-                        Chip8->V[0xF] = 1;                                    
-                    }
-                    Chip8->videoMemory[(x + xline + ((y + (yline / 2)) * screenx))] ^= 1;
-                }
-            }
-        }
+        height = 16;
+        width = 16;
     }
-    //Chip-8
-    else
+
+    x &= screenx - 1;
+    y &= screeny - 1;
+
+#if defined(__SSE2__)
+    __m128i collision = _mm_setzero_si128();
+#else
+    unsigned long long collision = 0;
+#endif
+
+    //clipped sprites stop at the bottom edge
+    if (CHIP8_QUIRK_CLIP(quirks) && y + height > screeny)
+        height = screeny - y;
+
+    for (int yline = 0; yline < height; yline++)
     {
-        for (int yline = 0; yline < height; yline++)
+        //sprite row in the top bits, then rotated across the display row
+        if (width == 16)
+            pixel = (unsigned long long)Chip8ReadOpcode(Chip8, Chip8->I + yline * 2) << 48;
+        else
+            pixel = (unsigned long long)Chip8Read(Chip8, Chip8->I + yline) << 56;
+
+        unsigned long long *row = Chip8->videoMemory[(y + yline) & (screeny - 1)];
+        Chip8->dirtyRows |= 1ULL << ((y + yline) & (screeny - 1));
+
+        if (screenx == 64)
+        {
+            if (CHIP8_QUIRK_CLIP(quirks))
+                pixel >>= x;
+            else
+                pixel = (pixel >> x) | (pixel << ((64 - x) & 63));
+#if defined(__SSE2__)
+            collision = _mm_or_si128(collision, _mm_cvtsi64_si128(row[0] & pixel));
+#else
+            collision |= row[0] & pixel;
+#endif
+            row[0] ^= pixel;
+        }
+        else
         {
-            pixel = Chip8->memory[Chip8->I + yline];
-            for (int xline = 0; xline < 8; xline++)
+            //move the sprite row right by x across the 128 bit row, the part that goes past the right edge wraps (or is clipped)
+            unsigned long long left;
+            unsigned long long right;
+            int shift = x & 63;
+
+            if (x < 64)
+            {
+                left = pixel >> shift;
+                right = shift != 0 ? pixel << (64 - shift) : 0;
+            }
+            else
             {
-                if ((pixel & (0x80 >> xline)) != 0)
-                {
-                    if (Chip8->videoMemory[(x + xline + ((y + yline) * screenx))] == 1)
-                    {
-                        Chip8->V[0xF] = 1;                                    
-                    }
-                    Chip8->videoMemory[x + xline + ((y + yline) * screenx)] ^= 1;
-                }
+                right = pixel >> shift;
+                left = shift != 0 && !CHIP8_QUIRK_CLIP(quirks) ? pixel << (64 - shift) : 0;
             }
+
+#if defined(__SSE2__)
+            __m128i sprite = _mm_set_epi64x(right, left);
+            __m128i screen = _mm_loadu_si128((__m128i *)row);
+            collision = _mm_or_si128(collision, _mm_and_si128(screen, sprite));
+            _mm_storeu_si128((__m128i *)row, _mm_xor_si128(screen, sprite));
+#else
+            collision |= (row[0] & left) | (row[1] & right);
+            row[0] ^= left;
+            row[1] ^= right;
+#endif
         }
     }
+
+#if defined(__SSE2__)
+    Chip8->V[0xF] = _mm_movemask_epi8(_mm_cmpeq_epi8(collision, _mm_setzero_si128())) != 0xFFFF;
+#else
+    Chip8->V[0xF] = collision != 0;
+#endif
     Chip8->refreshScreen = true;
 }
 
+/**
+* Display n-byte sprite starting at memory location I at (Vx, Vy), set VF = collision.
+* The interpreter reads n bytes from memory, starting at the address stored in I. 
+* These bytes are then displayed as sprites on screen at coordinates (Vx, Vy). 
+* Sprites are XORed onto the existing screen. If this causes any pixels to be erased, VF is set to 1, 
+* otherwise it is set to 0. If the sprite is positioned so part of it is outside the coordinates of the display, 
+* it wraps around to the opposite side of the screen.
+* Each sprite row is rotated into place as a whole display row, then tested with one AND and drawn with one XOR.
+* The VIP, CHIP-48 and SCHIP profiles clip the sprite at the edges instead.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8OpCodeDXYN(Chip8CPU *Chip8)
+{
+    Chip8OpCodeDXYNQuirks(Chip8, CHIP8_QUIRKS_MODERN);
+}
+
 /**
 * Skip next instruction if key with the value of Vx is pressed.
 * Checks the keyboard, and if the key corresponding to the value of Vx is currently in the down position, 
@@ -944,18 +2018,50 @@ void Chip8OpCodeEXXX(Chip8CPU *Chip8)
     switch(Chip8->opcode & 0x00FF)
     {
         case 0x009E: // EX9E     Skips the next instruction if the key stored in VX is pressed.
-            if(Chip8->key[Chip8->V[(Chip8->opcode & 0x0F00) >> 8]] != 0)
-                Chip8->pc += 2;
+            Chip8OpCodeEX9E(Chip8);
             break;
         case 0x0A1: // EXA1     Skips the next instruction if the key stored in VX isn't pressed.
-            if(Chip8->key[Chip8->V[(Chip8->opcode & 0x0F00) >> 8]] == 0)
-                Chip8->pc += 2;
+            Chip8OpCodeEXA1(Chip8);
             break;
         default:
             Chip8CPUNULL(Chip8);     
     }    
 }
 
+/**
+* Skip next instruction if key with the value of Vx is pressed.
+* Checks the keyboard, and if the key corresponding to the value of Vx is currently in the down position, 
+* PC is increased by 2.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8OpCodeEX9E(Chip8CPU *Chip8)
+{
+    if(Chip8->key[Chip8->V[(Chip8->opcode & 0x0F00) >> 8]] != 0)
+    {
+        Chip8->pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_EX9E);
+    }
+}
+
+/**
+* Skip next instruction if key with the value of Vx is not pressed.
+* Checks the keyboard, and if the key corresponding to the value of Vx is currently in the up position, 
+* PC is increased by 2.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8OpCodeEXA1(Chip8CPU *Chip8)
+{
+    if(Chip8->key[Chip8->V[(Chip8->opcode & 0x0F00) >> 8]] == 0)
+    {
+        Chip8->pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_EXA1);
+    }
+}
+
 /**
 * A Switch to call the FXXX OpCodes
 * I dont really see a better way to seperate them out.
@@ -1029,12 +2135,14 @@ void Chip8OpCodeFXXX(Chip8CPU *Chip8)
 */
 void Chip8OpCodeFX07(Chip8CPU *Chip8)
 {
+    Chip8UpdateTimers(Chip8);
     Chip8->V[(Chip8->opcode & 0x0F00) >> 8] = Chip8->delayTimer;
 }
 
 /**
 * Wait for a key press, store the value of the key in Vx.
 * All execution stops until a key is pressed, then the value of that key is stored in Vx.
+* While no key is down the rest of the Chip8RunCycles call is skipped and waitingForKey is set.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -1052,8 +2160,14 @@ void Chip8OpCodeFX0A(Chip8CPU *Chip8)
         }
     }
     // If we didn't received a keypress, skip this cycle and try again.
-    if(!keyPress)                        
+    // The keys can not change until the next Chip8RunCycles call, so skip to the end of this one.
+    Chip8->waitingForKey = !keyPress;
+    if(!keyPress)
+    {
+        Chip8->skippedCycles += Chip8->runUntil - 1 - Chip8->cycles;
+        Chip8->cycles = Chip8->runUntil - 1;
         Chip8->pc -= 2;
+    }
 }
 
 /**
@@ -1065,6 +2179,7 @@ void Chip8OpCodeFX0A(Chip8CPU *Chip8)
 */
 void Chip8OpCodeFX15(Chip8CPU *Chip8)
 {
+    Chip8UpdateTimers(Chip8);
     Chip8->delayTimer = Chip8->V[(Chip8->opcode & 0x0F00) >> 8];
 }
 
@@ -1077,6 +2192,7 @@ void Chip8OpCodeFX15(Chip8CPU *Chip8)
 */
 void Chip8OpCodeFX18(Chip8CPU *Chip8)
 {
+    Chip8UpdateTimers(Chip8);
     Chip8->soundTimer = Chip8->V[(Chip8->opcode & 0x0F00) >> 8];
 }
 
@@ -1132,39 +2248,57 @@ void Chip8OpCodeFX30(Chip8CPU *Chip8)
 */
 void Chip8OpCodeFX33(Chip8CPU *Chip8)
 {
-    Chip8->memory[Chip8->I]     = (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] / 100);
-    Chip8->memory[Chip8->I + 1] = (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] / 10) % 10;
-    Chip8->memory[Chip8->I + 2] = (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] % 100) % 10;
+    Chip8Write(Chip8, Chip8->I,     (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] / 100));
+    Chip8Write(Chip8, Chip8->I + 1, (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] / 10) % 10);
+    Chip8Write(Chip8, Chip8->I + 2, (Chip8->V[(Chip8->opcode & 0x0F00) >> 8] % 100) % 10);
+
+    Chip8InvalidateDecodeCache(Chip8, Chip8->I, 3);
+}
+
+//FX55 for any CHIP8_QUIRKS_* profile, quirks is a constant in each caller
+static inline void Chip8OpCodeFX55Quirks(Chip8CPU *Chip8, const int quirks)
+{
+    for (int i = 0; i <= (Chip8->opcode & 0x0F00) >> 8; ++i)
+        Chip8Write(Chip8, Chip8->I + i, Chip8->V[i]);
+
+    Chip8InvalidateDecodeCache(Chip8, Chip8->I, ((Chip8->opcode & 0x0F00) >> 8) + 1);
+    
+    Chip8->I += CHIP8_QUIRK_I_STEP(quirks, (Chip8->opcode & 0x0F00) >> 8);
 }
 
 /**
 * Store registers V0 through Vx in memory starting at location I.
 * The interpreter copies the values of registers V0 through Vx into memory, starting at the address in I.
+* I is moved past the registers (x + 1), by x in the CHIP-48 profile and not at all in the SCHIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCodeFX55(Chip8CPU *Chip8)
+{
+    Chip8OpCodeFX55Quirks(Chip8, CHIP8_QUIRKS_MODERN);
+}
+
+//FX65 for any CHIP8_QUIRKS_* profile, quirks is a constant in each caller
+static inline void Chip8OpCodeFX65Quirks(Chip8CPU *Chip8, const int quirks)
 {
     for (int i = 0; i <= (Chip8->opcode & 0x0F00) >> 8; ++i)
-        Chip8->memory[Chip8->I + i] = Chip8->V[i];
+        Chip8->V[i] = Chip8Read(Chip8, Chip8->I + i);
     
-    Chip8->I += ((Chip8->opcode & 0x0F00) >> 8) + 1;
+    Chip8->I += CHIP8_QUIRK_I_STEP(quirks, (Chip8->opcode & 0x0F00) >> 8);
 }
 
 /**
 * Read registers V0 through Vx from memory starting at location I.
 * The interpreter reads values from memory starting at location I into registers V0 through Vx.
+* I is moved past the registers (x + 1), by x in the CHIP-48 profile and not at all in the SCHIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8OpCodeFX65(Chip8CPU *Chip8)
 {
-    for (int i = 0; i <= (Chip8->opcode & 0x0F00) >> 8; ++i)
-        Chip8->V[i] = Chip8->memory[Chip8->I + i];
-    
-    Chip8->I += ((Chip8->opcode & 0x0F00) >> 8) + 1;
+    Chip8OpCodeFX65Quirks(Chip8, CHIP8_QUIRKS_MODERN);
 }
 
 /**
@@ -1194,3 +2328,88 @@ void Chip8OpCodeFX85(Chip8CPU *Chip8)
         Chip8->V[i] = Chip8->R[i];
     }
 }
+
+/**
+* Set Vx = delay timer value, at the start of a loop that waits for the delay timer:
+*   FX07    LD Vx, DT
+*   3X00    SE Vx, 0
+*   1NNN    JP back to the FX07
+* Every time round the loop is the same until DT reaches 0, so the loops that would still read a non zero DT
+* are skipped by moving Chip8->cycles forward (no further than Chip8->runUntil), then FX07 is run.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8OpCodeFX07Idle(Chip8CPU *Chip8)
+{
+    Chip8UpdateTimers(Chip8);
+
+    if (Chip8->delayTimer > 0)
+    {
+        //first opcode that will read DT as 0, the loop is 3 opcodes long
+        uint64_t expires = (Chip8->cycles / Chip8->cyclesPerFrame + Chip8->delayTimer) * Chip8->cyclesPerFrame;
+        uint64_t loops = (expires - Chip8->cycles + 2) / 3;
+        uint64_t loopsLeft = (Chip8->runUntil - Chip8->cycles - 1) / 3;
+
+        if (loops > loopsLeft)
+            loops = loopsLeft;
+
+        Chip8->cycles += loops * 3;
+        Chip8->skippedCycles += loops * 3;
+
+        //the skipped loops count as run, the SE never skips while DT is not 0
+        CHIP8_STATS_COUNT(Chip8, Chip8->opcode, loops);
+        CHIP8_STATS_COUNT(Chip8, Chip8ReadOpcode(Chip8, Chip8->pc), loops);
+        CHIP8_STATS_COUNT(Chip8, Chip8ReadOpcode(Chip8, Chip8->pc + 2), loops);
+        CHIP8_PROFILE_ADD(Chip8, Chip8->pc - 2, loops);
+        CHIP8_PROFILE_ADD(Chip8, Chip8->pc, loops);
+        CHIP8_PROFILE_ADD(Chip8, Chip8->pc + 2, loops);
+    }
+
+    Chip8OpCodeFX07(Chip8);
+}
+
+/**
+* Jump to location nnn, where nnn is the address of this opcode.
+* Nothing can change until the next Chip8RunCycles call, so Chip8->cycles is moved forward to Chip8->runUntil.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8OpCode1NNNIdle(Chip8CPU *Chip8)
+{
+    CHIP8_STATS_COUNT(Chip8, Chip8->opcode, Chip8->runUntil - 1 - Chip8->cycles);
+    CHIP8_PROFILE_ADD(Chip8, Chip8->pc - 2, Chip8->runUntil - 1 - Chip8->cycles);
+    Chip8->skippedCycles += Chip8->runUntil - 1 - Chip8->cycles;
+    Chip8->cycles = Chip8->runUntil - 1;
+    Chip8OpCode1NNN(Chip8);
+}
+
+/*************************************************************************************************
+ * Handlers of the quirk profiles
+*************************************************************************************************/
+
+//defines the handlers declared by CHIP8_QUIRK_DECLARE, each runs the shared code with its profile as a constant
+#define CHIP8_QUIRK_DEFINE(name)                                                \
+    static void name##VIP(Chip8CPU *Chip8)                                      \
+    {                                                                           \
+        name##Quirks(Chip8, CHIP8_QUIRKS_VIP);                                  \
+    }                                                                           \
+    static void name##CHIP48(Chip8CPU *Chip8)                                   \
+    {                                                                           \
+        name##Quirks(Chip8, CHIP8_QUIRKS_CHIP48);                               \
+    }                                                                           \
+    static void name##SCHIP(Chip8CPU *Chip8)                                    \
+    {                                                                           \
+        name##Quirks(Chip8, CHIP8_QUIRKS_SCHIP);                                \
+    }
+
+CHIP8_QUIRK_DEFINE(Chip8OpCode8XY1)
+CHIP8_QUIRK_DEFINE(Chip8OpCode8XY2)
+CHIP8_QUIRK_DEFINE(Chip8OpCode8XY3)
+CHIP8_QUIRK_DEFINE(Chip8OpCode8XY6)
+CHIP8_QUIRK_DEFINE(Chip8OpCode8XYE)
+CHIP8_QUIRK_DEFINE(Chip8OpCodeBNNN)
+CHIP8_QUIRK_DEFINE(Chip8OpCodeDXYN)
+CHIP8_QUIRK_DEFINE(Chip8OpCodeFX55)
+CHIP8_QUIRK_DEFINE(Chip8OpCodeFX65)
@@ -24,6 +24,116 @@
 #define CHIP8_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+//leaf handler possitions in Chip8DecodedOpcodeTable
+//CHIP8_OP_UNDECODED marks a decodeCache entry that has not been decoded yet
+#define CHIP8_OP_UNDECODED  0
+#define CHIP8_OP_NULL       1
+#define CHIP8_OP_00CN       2
+#define CHIP8_OP_00E0       3
+#define CHIP8_OP_00EE       4
+#define CHIP8_OP_00FB       5
+#define CHIP8_OP_00FC       6
+#define CHIP8_OP_00FD       7
+#define CHIP8_OP_00FE       8
+#define CHIP8_OP_00FF       9
+#define CHIP8_OP_1NNN       10
+#define CHIP8_OP_2NNN       11
+#define CHIP8_OP_3XNN       12
+#define CHIP8_OP_4XNN       13
+#define CHIP8_OP_5XY0       14
+#define CHIP8_OP_6XNN       15
+#define CHIP8_OP_7XNN       16
+#define CHIP8_OP_8XY0       17
+#define CHIP8_OP_8XY1       18
+#define CHIP8_OP_8XY2       19
+#define CHIP8_OP_8XY3       20
+#define CHIP8_OP_8XY4       21
+#define CHIP8_OP_8XY5       22
+#define CHIP8_OP_8XY6       23
+#define CHIP8_OP_8XY7       24
+#define CHIP8_OP_8XYE       25
+#define CHIP8_OP_9XY0       26
+#define CHIP8_OP_ANNN       27
+#define CHIP8_OP_BNNN       28
+#define CHIP8_OP_CXKK       29
+#define CHIP8_OP_DXYN       30
+#define CHIP8_OP_EX9E       31
+#define CHIP8_OP_EXA1       32
+#define CHIP8_OP_FX07       33
+#define CHIP8_OP_FX0A       34
+#define CHIP8_OP_FX15       35
+#define CHIP8_OP_FX18       36
+#define CHIP8_OP_FX1E       37
+#define CHIP8_OP_FX29       38
+#define CHIP8_OP_FX30       39
+#define CHIP8_OP_FX33       40
+#define CHIP8_OP_FX55       41
+#define CHIP8_OP_FX65       42
+#define CHIP8_OP_FX75       43
+#define CHIP8_OP_FX85       44
+#define CHIP8_OP_FX07_IDLE  45  //FX07 starting a LD Vx, DT / SE Vx, 0 / JP back loop
+#define CHIP8_OP_1NNN_IDLE  46  //1NNN that jumps to itself
+#define CHIP8_OP_COUNT      47
+
+//interpreter backends that can run the opcodes
+#define CHIP8_BACKEND_HANDLERS  0   //function pointer tables (Chip8DecodedOpcodeTable)
+#define CHIP8_BACKEND_THREADED  1   //direct threaded loop (Chip8RunThreaded)
+#define CHIP8_BACKEND_JIT       2   //x86-64 translated blocks (Chip8RunJit)
+
+//quirk profiles, the way different interpreters run a few of the opcodes
+#define CHIP8_QUIRKS_MODERN     0   //this emulator's own behaviour, used by most current emulators
+#define CHIP8_QUIRKS_VIP        1   //original COSMAC VIP interpreter
+#define CHIP8_QUIRKS_CHIP48     2   //CHIP-48 on the HP48
+#define CHIP8_QUIRKS_SCHIP      3   //Super Chip-48 1.1
+#define CHIP8_QUIRKS_COUNT      4
+
+//the quirks of each profile, q should be a constant so the tests are compiled out
+#define CHIP8_QUIRK_SHIFT_VY(q)     ((q) == CHIP8_QUIRKS_VIP)                               //8XY6/8XYE shift VY into VX, not VX in place
+#define CHIP8_QUIRK_VF_RESET(q)     ((q) == CHIP8_QUIRKS_VIP)                               //8XY1/8XY2/8XY3 set VF to 0
+#define CHIP8_QUIRK_JUMP_VX(q)      ((q) == CHIP8_QUIRKS_CHIP48 || (q) == CHIP8_QUIRKS_SCHIP)   //BXNN jumps to XNN + VX, not NNN + V0
+#define CHIP8_QUIRK_CLIP(q)         ((q) != CHIP8_QUIRKS_MODERN)                            //DXYN clips sprites at the edges, not wrap
+#define CHIP8_QUIRK_I_STEP(q, x)    ((q) == CHIP8_QUIRKS_SCHIP ? 0 : (q) == CHIP8_QUIRKS_CHIP48 ? (x) : (x) + 1)    //added to I by FX55/FX65
+
+//opcodes run per 60Hz frame (one tick of the timers) unless cyclesPerFrame is set
+#define CHIP8_DEFAULT_CYCLES_PER_FRAME  16
+
+//memory is split into pages, instances share the pages they have not written and copy a page the first time they write it
+#define CHIP8_PAGE_SIZE     256
+#define CHIP8_PAGE_COUNT    16
+
+//save states (Chip8SerializeState) start with these 4 bytes and a version byte, followed by tagged chunks
+#define CHIP8_STATE_MAGIC       "C8ST"
+#define CHIP8_STATE_VERSION     2
+
+//largest serialized state in bytes, a buffer this big always holds one
+#define CHIP8_STATE_MAX_SIZE    5376
+
+//translation cache used by the JIT backend, see Chip8Jit.c
+struct Chip8Jit;
+
+//opcode counts kept when built with CHIP8_STATS, see Chip8Stats.h
+struct Chip8Stats;
+
+//time spent at each address, kept when built with CHIP8_PROFILE, see Chip8Profile.h
+struct Chip8Profile;
+
+//subroutine calls and their cycles, kept when built with CHIP8_CALLGRAPH, see Chip8CallGraph.h
+struct Chip8CallGraph;
+
+//ring of the last opcodes run, used when built with CHIP8_TRACE, see Chip8Trace.h
+struct Chip8Trace;
+
+//one page of memory, shared by every instance that points at it
+typedef struct
+{
+    unsigned char data[CHIP8_PAGE_SIZE];
+
+    //number of instances holding the page, it is only written in place while this is 1
+    int refs;
+} Chip8Page;
 
 typedef struct
 {
@@ -50,7 +160,8 @@ typedef struct
      |  interpreter  |
      +---------------+= 0x000 (0) Start of Chip-8 RAM
     */
-    unsigned char memory[4096];
+    //read with Chip8Read and written with Chip8Write, pages start out shared (the font page and a page of zeros)
+    Chip8Page *pages[CHIP8_PAGE_COUNT];
 
     //16 general purpose 8-bit registers.
     //The VF register should not be used by any program, as it is used as a flag by some instructions.
@@ -72,8 +183,10 @@ typedef struct
      *                   *
      *(0,31)      (63,31)*
      *********************
+     One bit per pixel, each row is 128 pixels in 2 words with pixel 0 in the top bit of videoMemory[y][0].
+     In Chip-8 mode only videoMemory[0..31][0] is used. Use Chip8GetPixel to read a pixel.
     */
-    unsigned char videoMemory[128 * 64];
+    unsigned long long videoMemory[64][2];
 
     //Super Chip-8 extended graphics enabled
     bool extendedGraphicsMode;
@@ -105,17 +218,100 @@ typedef struct
     //Should be set to false once the screen has been redrawn
     bool refreshScreen;
 
+    //Bit y is set when row y of the display has changed (DXYN, 00E0, the scrolls and the mode switches set it)
+    //The renderer should clear the bits of the rows it has redrawn
+    unsigned long long dirtyRows;
+
     //Set to true if a beep needs to be played
     bool playBeep;
 
     //used for chip-8 timing, please do not touch
     long lastTick;
 
-    //used for chip-8 timing, please do not touch
-    long lastTick2;
+    //Predecoded leaf handler (CHIP8_OP_*) for the opcode starting at each memory address.
+    //Filled in lazily by Chip8RunCycles, cleared by Chip8InvalidateDecodeCache when memory is written
+    unsigned char decodeCache[4096];
+
+    //counted up every time memory is written (Chip8InvalidateDecodeCache, Chip8Reset, Chip8LoadState)
+    unsigned int memoryWrites;
+
+    //CHIP8_BACKEND_* used by Chip8RunCycles, this is kept by Chip8Reset
+    unsigned char backend;
+
+    //CHIP8_QUIRKS_* profile the opcodes are run with, this is kept by Chip8Reset
+    unsigned char quirks;
+
+    //number of opcodes run since the last reset, while a opcode handler runs this is the number of the opcode being run
+    uint64_t cycles;
+
+    //cycles the idle handlers (FX07 and 1NNN loops, FX0A and 00FD) moved past without running them, since the last reset
+    //cycles - skippedCycles is the number of opcodes that were really run (the lockstep lanes of Chip8Lanes.h do not count it)
+    uint64_t skippedCycles;
+
+    //value of cycles when delayTimer and soundTimer were last brought up to date by Chip8UpdateTimers
+    uint64_t timerCycle;
+
+    //value of cycles the running Chip8RunCycles call stops at, idle loops are fast-forwarded no further than this
+    uint64_t runUntil;
+
+    //set while FX0A is waiting for a key
+    bool waitingForKey;
+
+    //set by 00FD, the program has exited and stays stopped until Chip8Reset
+    bool halted;
+
+    //opcodes in each 60Hz frame, this is kept by Chip8Reset (set to CHIP8_DEFAULT_CYCLES_PER_FRAME if 0)
+    unsigned int cyclesPerFrame;
+
+    //seed of the random numbers CXKK uses, set with Chip8Seed, this is kept by Chip8Reset
+    uint64_t seed;
+
+    //state of the xorshift generator CXKK takes its random numbers from, Chip8Reset starts it from seed
+    uint64_t random;
+
+    //JIT translation cache, created by Chip8RunJit and freed by Chip8JitFree
+    //Must be NULL before the first Chip8Reset, so start with a zeroed Chip8CPU
+    struct Chip8Jit *jit;
+
+    //opcode counts, created by Chip8Reset when built with CHIP8_STATS and freed by Chip8Free, NULL otherwise
+    struct Chip8Stats *stats;
+
+    //runs and host time of each address, created by Chip8Reset when built with CHIP8_PROFILE and freed by Chip8Free, NULL otherwise
+    struct Chip8Profile *profile;
+
+    //call tree of the subroutines, created by Chip8Reset when built with CHIP8_CALLGRAPH and freed by Chip8Free, NULL otherwise
+    struct Chip8CallGraph *callGraph;
+
+    //trace of the opcodes run, set by Chip8TraceStart and freed by Chip8TraceStop, NULL when not tracing
+    struct Chip8Trace *trace;
 
 } Chip8CPU;
 
+/**
+* Reads a byte of memory
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address address to read, wrapped to 12 bits
+* @return the byte.
+*/
+static inline unsigned char Chip8Read(Chip8CPU *Chip8, unsigned short address)
+{
+    address &= 0x0FFF;
+    return Chip8->pages[address / CHIP8_PAGE_SIZE]->data[address % CHIP8_PAGE_SIZE];
+}
+
+/**
+* Reads the opcode starting at a address
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address address of the opcode, wrapped to 12 bits
+* @return the opcode.
+*/
+static inline unsigned short Chip8ReadOpcode(Chip8CPU *Chip8, unsigned short address)
+{
+    return Chip8Read(Chip8, address) << 8 | Chip8Read(Chip8, address + 1);
+}
+
 /**
 * Returns time millicount used for get milliSpan
 *
@@ -140,6 +336,36 @@ unsigned long  Chip8getMilliSpan(unsigned long nTimeStart);
 */
 void Chip8Reset(Chip8CPU *Chip8);
 
+/**
+* Frees the memory pages, JIT cache, opcode counts, profile and call graph of a Chip8CPU object that is no longer used
+* The object can be used again after a Chip8Reset.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8Free(Chip8CPU *Chip8);
+
+/**
+* Writes a byte of memory, copying the page first if it is shared with other instances
+* Does not drop the predecoded opcodes, see Chip8InvalidateDecodeCache.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address address to write, wrapped to 12 bits
+* @param value byte to write
+* @return Nothing.
+*/
+void Chip8Write(Chip8CPU *Chip8, unsigned short address, unsigned char value);
+
+/**
+* Gives a instance the same memory as another one by sharing its pages, so starting many sessions of one game
+* costs no copies. Either instance copies a page the first time it writes to it.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param source Address of the Chip8CPU object to share the memory of
+* @return Nothing.
+*/
+void Chip8ShareMemory(Chip8CPU *Chip8, Chip8CPU *source);
+
 /**
 * Loads the Chip8 ROM into memory starting at 0x200
 *
@@ -150,7 +376,32 @@ void Chip8Reset(Chip8CPU *Chip8);
 bool Chip8LoadRom(Chip8CPU *Chip8, char *filename);
 
 /**
-* Saves the emulator state to a file
+* Writes the state of the machine to a buffer in the portable save state format, no files are used
+* The format is little endian and versioned: CHIP8_STATE_MAGIC, the version byte, then chunks of a tag byte, a 2 byte length
+* and the data, ending with a checksum. Only the used stack, the used part of the display (1 bit per pixel) and
+* the memory pages that are not all zeros are stored. The backend and the predecoded opcodes are not stored.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param buffer where to write the state
+* @param size size of the buffer, CHIP8_STATE_MAX_SIZE is always enough
+* @return number of bytes written, 0 if the buffer is too small.
+*/
+size_t Chip8SerializeState(Chip8CPU *Chip8, unsigned char *buffer, size_t size);
+
+/**
+* Loads a state written by Chip8SerializeState
+* The whole state is checked (version, checksum and chunk sizes) before the machine is changed, and only the memory
+* that differs is written, so loading the same game state again and again is cheap.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param buffer the state
+* @param size number of bytes in the buffer
+* @return false if the buffer does not hold a valid state, the machine is not changed.
+*/
+bool Chip8DeserializeState(Chip8CPU *Chip8, const unsigned char *buffer, size_t size);
+
+/**
+* Saves the emulator state to a file, in the format of Chip8SerializeState
 *
 * @param Chip8 Address of the Chip8CPU object
 * @param filename filename to save state to
@@ -159,7 +410,7 @@ bool Chip8LoadRom(Chip8CPU *Chip8, char *filename);
 bool Chip8SaveState(Chip8CPU *Chip8, char *filename);
 
 /**
-* Loads the emulator state to a file
+* Loads the emulator state to a file, see Chip8DeserializeState
 *
 * @param Chip8 Address of the Chip8CPU object
 * @param filename filename to Load state from
@@ -168,13 +419,104 @@ bool Chip8SaveState(Chip8CPU *Chip8, char *filename);
 bool Chip8LoadState(Chip8CPU *Chip8, char *filename);
 
 /**
-* Fetches and runs a opcode
+* Fetches and runs a opcode using the selected backend
+* Does nothing if less than 1ms has passed since the last call, use Chip8RunCycles to run without the host clock
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
 */
 void Chip8EmulateCycle(Chip8CPU *Chip8);
 
+/**
+* Runs a fixed number of opcodes using the selected backend
+* This never looks at the host clock, the caller decides how fast the game runs.
+* The timers count down once every cyclesPerFrame opcodes, so the same opcodes always give the same result.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+void Chip8RunCycles(Chip8CPU *Chip8, uint64_t cycles);
+
+/**
+* Runs opcodes up to the next frame boundary (every cyclesPerFrame opcodes),
+* the timers count down once at the boundary, so calling this 60 times a second runs the game at full speed.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8RunFrame(Chip8CPU *Chip8);
+
+/**
+* Sets the seed of the random numbers CXKK uses and restarts them from it
+* Every instance has its own generator, so the same seed, ROM and keys always give the same game.
+* A zeroed Chip8CPU uses seed 0, which is a fixed seed like any other.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param seed the seed
+* @return Nothing.
+*/
+void Chip8Seed(Chip8CPU *Chip8, uint64_t seed);
+
+/**
+* Returns the next random byte of a instance, used by CXKK
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return a random number from 0 to 255.
+*/
+unsigned char Chip8Random(Chip8CPU *Chip8);
+
+/**
+* Brings the delay and sound timers up to date with Chip8->cycles
+* The timers are not ticked as opcodes run, instead this counts the frame boundaries passed since the last update
+* and takes them off both timers at once. It is called by the timer opcodes and at the end of Chip8RunCycles.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8UpdateTimers(Chip8CPU *Chip8);
+
+/**
+* Decodes a opcode down to the handler that will run it
+* This walks the same tables and switches the handlers use, so it only needs to run once per address
+*
+* @param opcode the opcode to decode
+* @return the CHIP8_OP_* index of the handler in Chip8DecodedOpcodeTable.
+*/
+unsigned char Chip8DecodeOpcode(unsigned short opcode);
+
+/**
+* Drops the predecoded opcodes that overlap a range of memory
+* Must be called whenever memory that may hold code is written
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address first address that was written
+* @param length number of bytes that were written
+* @return Nothing.
+*/
+void Chip8InvalidateDecodeCache(Chip8CPU *Chip8, int address, int length);
+
+/**
+* Decodes the opcode at a address, like Chip8DecodeOpcode, but also looks at the opcodes after it
+* so loops that only wait for the delay timer, and jumps to themselves, get their own idle handlers.
+* The result depends on the 6 bytes starting at address.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address address of the opcode
+* @return the CHIP8_OP_* index of the handler in Chip8DecodedOpcodeTable.
+*/
+unsigned char Chip8DecodeAddress(Chip8CPU *Chip8, unsigned short address);
+
+/**
+* Reads a pixel from the display
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param x column, 0 to 63 (0 to 127 in extended graphics mode)
+* @param y row, 0 to 31 (0 to 63 in extended graphics mode)
+* @return true if the pixel is on.
+*/
+bool Chip8GetPixel(Chip8CPU *Chip8, int x, int y);
+
 
 /**********************************************************************************************
  * CHIP-8 has 35 opcodes, which are all two bytes long and stored big-endian. 
@@ -235,6 +577,10 @@ void Chip8EmulateCycle(Chip8CPU *Chip8);
 //Array of Function pointers to the 8???? OpCodes
 //void (*Chip8ArithmeticOpcodeTable[16])(Chip8CPU *Chip8);
 
+//Array of function pointers to every leaf OpCode, indexed by CHIP8_QUIRKS_* and CHIP8_OP_*
+//Each quirk profile has its own handlers for the opcodes it runs differently
+extern void (*Chip8DecodedOpcodeTable[CHIP8_QUIRKS_COUNT][CHIP8_OP_COUNT])(Chip8CPU *Chip8);
+
 /**
 * If this OPCODE is called then something went wrong
 * or the opcode was not finished
@@ -254,7 +600,7 @@ void Chip8OpCode00XX(Chip8CPU *Chip8);
 
 /**
 * Scroll display N lines down (Super Chip-8)
-* Moves the memory pointer
+* Moves the rows down with one memmove and clears the top N rows
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -281,7 +627,7 @@ void Chip8OpCode00EE(Chip8CPU *Chip8);
 
 /**
 * Scroll display 4 pixels right (Super Chip-8)
-* 
+* Each row is shifted as a whole, the 4 pixels on the left are cleared
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -290,7 +636,7 @@ void Chip8OpCode00FB(Chip8CPU *Chip8);
 
 /**
 * Scroll display 4 pixels left (Super Chip-8)
-* 
+* Each row is shifted as a whole, the 4 pixels on the right are cleared
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -299,7 +645,7 @@ void Chip8OpCode00FC(Chip8CPU *Chip8);
 
 /**
 * Exit CHIP interpreter (Super Chip-8)
-* 
+* Sets halted and keeps pc on the 00FD, so every later run fast-forwards to its end
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -416,6 +762,7 @@ void Chip8OpCode8XY0(Chip8CPU *Chip8);
 * then stores the result in Vx. 
 * A bitwise OR compares the corrseponding bits from two values, 
 * and if either bit is 1, then the same bit in the result is also 1. Otherwise, it is 0. 
+* VF is set to 0 in the VIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -428,6 +775,7 @@ void Chip8OpCode8XY1(Chip8CPU *Chip8);
 * then stores the result in Vx.
 * A bitwise AND compares the corrseponding bits from two values,
 * and if both bits are 1, then the same bit in the result is also 1. Otherwise, it is 0. 
+* VF is set to 0 in the VIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -440,6 +788,7 @@ void Chip8OpCode8XY2(Chip8CPU *Chip8);
 * then stores the result in Vx. 
 * An exclusive OR compares the corrseponding bits from two values, 
 * and if the bits are not both the same, then the corresponding bit in the result is set to 1. Otherwise, it is 0. 
+* VF is set to 0 in the VIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -471,6 +820,7 @@ void Chip8OpCode8XY5(Chip8CPU *Chip8);
 * Set Vx = Vx SHR 1.
 * If the least-significant bit of Vx is 1, then VF is set to 1, otherwise 0. 
 * Then Vx is divided by 2.
+* The VIP profile shifts Vy and stores the result in Vx.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -491,6 +841,7 @@ void Chip8OpCode8XY7(Chip8CPU *Chip8);
 * Set Vx = Vx SHL 1.
 * If the most-significant bit of Vx is 1, then VF is set to 1, otherwise to 0. 
 * Then Vx is multiplied by 2.
+* The VIP profile shifts Vy and stores the result in Vx.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -519,6 +870,7 @@ void Chip8OpCodeANNN(Chip8CPU *Chip8);
 /**
 * Jump to location nnn + V0.
 * The program counter is set to nnn plus the value of V0.
+* The CHIP-48 and SCHIP profiles jump to xnn + Vx (BXNN).
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -543,6 +895,8 @@ void Chip8OpCodeCXKK(Chip8CPU *Chip8);
 * Sprites are XORed onto the existing screen. If this causes any pixels to be erased, VF is set to 1, 
 * otherwise it is set to 0. If the sprite is positioned so part of it is outside the coordinates of the display, 
 * it wraps around to the opposite side of the screen.
+* Each sprite row is rotated into place as a whole display row, then tested with one AND and drawn with one XOR.
+* The VIP, CHIP-48 and SCHIP profiles clip the sprite at the edges instead.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -563,6 +917,26 @@ void Chip8OpCodeDXYN(Chip8CPU *Chip8);
 */
 void Chip8OpCodeEXXX(Chip8CPU *Chip8);
 
+/**
+* Skip next instruction if key with the value of Vx is pressed.
+* Checks the keyboard, and if the key corresponding to the value of Vx is currently in the down position, 
+* PC is increased by 2.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8OpCodeEX9E(Chip8CPU *Chip8);
+
+/**
+* Skip next instruction if key with the value of Vx is not pressed.
+* Checks the keyboard, and if the key corresponding to the value of Vx is currently in the up position, 
+* PC is increased by 2.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8OpCodeEXA1(Chip8CPU *Chip8);
+
 
 /**
 * A Switch to call the FXXX OpCodes
@@ -585,6 +959,7 @@ void Chip8OpCodeFX07(Chip8CPU *Chip8);
 /**
 * Wait for a key press, store the value of the key in Vx.
 * All execution stops until a key is pressed, then the value of that key is stored in Vx.
+* While no key is down the rest of the Chip8RunCycles call is skipped and waitingForKey is set.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -650,6 +1025,7 @@ void Chip8OpCodeFX33(Chip8CPU *Chip8);
 /**
 * Store registers V0 through Vx in memory starting at location I.
 * The interpreter copies the values of registers V0 through Vx into memory, starting at the address in I.
+* I is moved past the registers (x + 1), by x in the CHIP-48 profile and not at all in the SCHIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -659,6 +1035,7 @@ void Chip8OpCodeFX55(Chip8CPU *Chip8);
 /**
 * Read registers V0 through Vx from memory starting at location I.
 * The interpreter reads values from memory starting at location I into registers V0 through Vx.
+* I is moved past the registers (x + 1), by x in the CHIP-48 profile and not at all in the SCHIP profile.
 *
 * @param Chip8 Address of the Chip8CPU object
 * @return Nothing.
@@ -681,6 +1058,28 @@ void Chip8OpCodeFX75(Chip8CPU *Chip8);
 */
 void Chip8OpCodeFX85(Chip8CPU *Chip8);
 
+/**
+* Set Vx = delay timer value, at the start of a loop that waits for the delay timer:
+*   FX07    LD Vx, DT
+*   3X00    SE Vx, 0
+*   1NNN    JP back to the FX07
+* Every time round the loop is the same until DT reaches 0, so the loops that would still read a non zero DT
+* are skipped by moving Chip8->cycles forward (no further than Chip8->runUntil), then FX07 is run.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8OpCodeFX07Idle(Chip8CPU *Chip8);
+
+/**
+* Jump to location nnn, where nnn is the address of this opcode.
+* Nothing can change until the next Chip8RunCycles call, so Chip8->cycles is moved forward to Chip8->runUntil.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8OpCode1NNNIdle(Chip8CPU *Chip8);
+
 
 
 #endif //header guard CHIP8_H
\ No newline at end of file
@@ -6,14 +6,6 @@
 
 #include "Chip8Assembler.h"
 
-//address lables and pointer
-Chip8AssAddressPointer addressPointers[256];
-int addressPointersCount = 0;
-
-//working memory
-unsigned char memory[4096];
-int pc = 0x200;
-
 //possable opcides and count
 const int opcodeCount = 28;
 const char *opcodes[] = {
@@ -77,6 +69,20 @@ const char *opcodePerams[] = {
     "F"
 };
 
+/**
+* Clears a context so a new file can be assembled with it
+*
+* @param context Address of the Chip8AssContext object
+* @param verbose print errors and the program size to stdout
+* @return None
+*/
+void Chip8AssInit(Chip8AssContext *context, bool verbose)
+{
+    memset(context, 0, sizeof(Chip8AssContext));
+    context->pc = 0x200;
+    context->verbose = verbose;
+}
+
 /**
 * Process a file
 *
@@ -85,6 +91,29 @@ const char *opcodePerams[] = {
 * @return false if the file could not be opened
 */
 bool Chip8AssProcessFile (char* filenamein, char* filenameout)
+{
+    Chip8AssContext *context = (Chip8AssContext *)malloc(sizeof(Chip8AssContext));
+
+    if (context == NULL)
+        return false;
+
+    Chip8AssInit(context, true);
+    bool ok = Chip8AssAssembleFile(context, filenamein, filenameout);
+    free(context);
+
+    return ok;
+}
+
+/**
+* Process a file with the given context, so several files can be assembled at once on different threads
+* Lines that could not be assembled are counted in context->errorCount and the first one is kept in context->error.
+*
+* @param context Address of a Chip8AssContext object set up by Chip8AssInit
+* @param filenamein file to read and assemble
+* @param filenameout file to save the assembled code to
+* @return false if the file could not be opened
+*/
+bool Chip8AssAssembleFile(Chip8AssContext *context, char *filenamein, char *filenameout)
 {
     FILE *fp;
 
@@ -105,20 +134,29 @@ bool Chip8AssProcessFile (char* filenamein, char* filenameout)
     while (fgets(line, len, fp) != NULL) 
     {
         lineNumber++;   
-        if (!Chip8AssProcessLine(line, true))
-            printf("Error line %i: \'%s\'\n", lineNumber, line);
+        if (!Chip8AssProcessLine(context, line, true))
+        {
+            //keep the first error without the line's new line
+            int length = strlen(line);
+            while (length > 0 && isspace(line[length - 1]))
+                length--;
+            if (context->errorCount++ == 0)
+                snprintf(context->error, sizeof(context->error), "Error line %i: \'%.*s\'", lineNumber, length, line);
+            if (context->verbose)
+                printf("Error line %i: \'%s\'\n", lineNumber, line);
+        }
     }
 
     //this does not seem like a very good way to do this but it works for now
     //rewind and run it again so the correct lable address are used
     rewind(fp);
-    pc = 0x200;
+    context->pc = 0x200;
 
     //process the file line by line again to resolve address lables(no need to print errors twice)
     while (fgets(line, len, fp) != NULL) 
     {
         lineNumber++;   
-        Chip8AssProcessLine(line, false);
+        Chip8AssProcessLine(context, line, false);
     }
 
     fclose(fp);
@@ -130,25 +168,51 @@ bool Chip8AssProcessFile (char* filenamein, char* filenameout)
         return false;
 
     //write memory to file
-    fwrite(&memory[0x200], sizeof(char) * (pc - 0x200), 1, fp);
+    fwrite(&context->memory[0x200], sizeof(char) * (context->pc - 0x200), 1, fp);
     
     //close the file
     fclose(fp);
 
-    printf("Complete, program size: %i bytes\n", pc - 0x200);
+    if (context->verbose)
+        printf("Complete, program size: %i bytes\n", context->pc - 0x200);
 
     return true;
     
 }
 
+/**
+* Reads the lables of a file and the addresses they are at, without writing anything
+* Used to name addresses in reports, such as the profile written by Chip8WriteProfile.
+*
+* @param context Address of a Chip8AssContext object set up by Chip8AssInit
+* @param filenamein file to read the lables from
+* @return false if the file could not be opened
+*/
+bool Chip8AssReadLables(Chip8AssContext *context, char *filenamein)
+{
+    char line[256];
+    FILE *fp = fopen(filenamein, "r");
+
+    if (fp == NULL)
+        return false;
+
+    //the first pass of Chip8AssAssembleFile finds the lables
+    while (fgets(line, sizeof(line), fp) != NULL)
+        Chip8AssProcessLine(context, line, true);
+
+    fclose(fp);
+    return true;
+}
+
 /**
 * Process a line from the assembly file
 *
+* @param context Address of the Chip8AssContext object
 * @param line pointer to the string
 * @param lables, weather or not to process lables, this sould be false on secodn run
 * @return false if the line is not parsed
 */
-bool Chip8AssProcessLine(char *line, bool lables)
+bool Chip8AssProcessLine(Chip8AssContext *context, char *line, bool lables)
 {
     //convert line to Chip8AssUppercase we will work all in Chip8AssUppercase
     Chip8AssUppercase(line);
@@ -169,18 +233,22 @@ bool Chip8AssProcessLine(char *line, bool lables)
     //check if this line hase a lbl
     if (lbl)
     {                 
+        //no room for another lable
+        if (lables && context->addressPointersCount >= 256)
+            return false;
+
         for (int i = 0; i < 25 && *line != ':'; i++)
         {
             if (lables)
-                addressPointers[addressPointersCount].name[i] = *line;
+                context->addressPointers[context->addressPointersCount].name[i] = *line;
             ++line;
         }
         //move past the ':'
         ++line;
         if (lables)
         {
-            addressPointers[addressPointersCount].address = pc;
-            addressPointersCount++;
+            context->addressPointers[context->addressPointersCount].address = context->pc;
+            context->addressPointersCount++;
         }
     }
 
@@ -206,6 +274,10 @@ bool Chip8AssProcessLine(char *line, bool lables)
     if (opcode == -1)
         return false;
 
+    //the program has filled the memory
+    if (context->pc > 4094)
+        return false;
+
     //movepast the opcode
     while (*line != '\0' && !isspace(*line))
         ++line;
@@ -218,12 +290,12 @@ bool Chip8AssProcessLine(char *line, bool lables)
     if (opcode == OPCODE_DA)
     {
         int p = 1;
-        while (line[p] != '\'')
+        while (line[p] != '\'' && line[p] != '\0' && context->pc < 4096)
         {
-            memory[pc++] = (unsigned char)line[p++];
+            context->memory[context->pc++] = (unsigned char)line[p++];
         }
         if (!(p % 2))
-            memory[pc++] == 0x00;
+            context->memory[context->pc++] == 0x00;
         
         return true;
     }
@@ -231,22 +303,22 @@ bool Chip8AssProcessLine(char *line, bool lables)
     else if (opcode == OPCODE_DW)
     {
         int value = Chip8AssParseInt(line);
-        memory[pc++] = (unsigned char)((0xFF00 & value) >> 8);
-        memory[pc++] = (unsigned char)(0x00FF & value);
+        context->memory[context->pc++] = (unsigned char)((0xFF00 & value) >> 8);
+        context->memory[context->pc++] = (unsigned char)(0x00FF & value);
         return true;
     }
     //if it is a data type write the data
     else if (opcode == OPCODE_DB)
     {
-        memory[pc++] = (unsigned char)Chip8AssParseInt(line);
+        context->memory[context->pc++] = (unsigned char)Chip8AssParseInt(line);
         return true;
     }
     //process other opcodes
     else
     {
-        int builtOpcode = Chip8AssBuildCode(opcode, line);
-        memory[pc++] = (unsigned char)((0xFF00 & builtOpcode) >> 8);
-        memory[pc++] = (unsigned char)(0x00FF & builtOpcode);
+        int builtOpcode = Chip8AssBuildCode(context, opcode, line);
+        context->memory[context->pc++] = (unsigned char)((0xFF00 & builtOpcode) >> 8);
+        context->memory[context->pc++] = (unsigned char)(0x00FF & builtOpcode);
         return true;
     }
 
@@ -256,11 +328,12 @@ bool Chip8AssProcessLine(char *line, bool lables)
 /**
 * Converts a string to the correct hex value based on the opcode
 *
+* @param context Address of the Chip8AssContext object
 * @param opcode index of the current opcide
 * @param line the currnet line in the file
 * @return None
 */
-int Chip8AssBuildCode(int opcode, char *line)
+int Chip8AssBuildCode(Chip8AssContext *context, int opcode, char *line)
 {
     //used for param checking below
     int paramCheck1 = OPCODE_PARAM_NULL;
@@ -279,16 +352,16 @@ int Chip8AssBuildCode(int opcode, char *line)
 
         case OPCODE_JP: //JP 1nnn
             //using paramCheck2 for address only for this opcode
-            address = Chip8AssGetAddress(line);
+            address = Chip8AssGetAddress(context, line);
             paramCheck1 = Chip8AssGetV(&line);
             if (paramCheck1 == OPCODE_PARAM_V0)
-                return 0xB000 | Chip8AssGetAddress(line);
+                return 0xB000 | Chip8AssGetAddress(context, line);
             else
                 return 0x1000 | address;
             break;
 
         case OPCODE_CALL: //CALL 2nnn
-            return 0x2000 | Chip8AssGetAddress(line);
+            return 0x2000 | Chip8AssGetAddress(context, line);
             break;
 
         case OPCODE_SE: //SE 3xkk
@@ -313,7 +386,7 @@ int Chip8AssBuildCode(int opcode, char *line)
         
         case OPCODE_LD: //LD
             paramCheck1 = Chip8AssGetV(&line);
-            address = Chip8AssGetAddress(line);
+            address = Chip8AssGetAddress(context, line);
             paramCheck2 = Chip8AssGetV(&line);
 
             //LD vx vy 8xy0
@@ -477,19 +550,20 @@ int Chip8AssGetV(char **line)
 * attempts to find a matching lable
 * if a lable is not found, it assumes it is a number and converts it
 *
+* @param context Address of the Chip8AssContext object
 * @param line the current string of the line
 * @return the parsed address
 */
-int Chip8AssGetAddress(char *line)
+int Chip8AssGetAddress(Chip8AssContext *context, char *line)
 {
     //check if it is a lable
     while (*line != '\0' && isspace(*line))
         ++line;
 
-    for (int i = 0; i < addressPointersCount; i++)
+    for (int i = 0; i < context->addressPointersCount; i++)
     {
-        if (strncmp(addressPointers[i].name, line, strlen(addressPointers[i].name)) == 0)
-            return addressPointers[i].address;
+        if (strncmp(context->addressPointers[i].name, line, strlen(context->addressPointers[i].name)) == 0)
+            return context->addressPointers[i].address;
     }
 
     //not in the lable list so we assume it is a number
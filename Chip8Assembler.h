@@ -95,6 +95,34 @@ typedef struct
     int address;
 } Chip8AssAddressPointer;
 
+//everything the assembler works on for one file, each thread assembling files needs its own
+typedef struct
+{
+    //address lables and pointer
+    Chip8AssAddressPointer addressPointers[256];
+    int addressPointersCount;
+
+    //working memory
+    unsigned char memory[4096];
+    int pc;
+
+    //number of lines that could not be assembled, and the message for the first one
+    int errorCount;
+    char error[300];
+
+    //print errors and the program size to stdout
+    bool verbose;
+} Chip8AssContext;
+
+/**
+* Clears a context so a new file can be assembled with it
+*
+* @param context Address of the Chip8AssContext object
+* @param verbose print errors and the program size to stdout
+* @return None
+*/
+void Chip8AssInit(Chip8AssContext *context, bool verbose);
+
 /**
 * Process a file
 *
@@ -104,23 +132,46 @@ typedef struct
 */
 bool Chip8AssProcessFile (char* filenamein, char* filenameout);
 
+/**
+* Process a file with the given context, so several files can be assembled at once on different threads
+* Lines that could not be assembled are counted in context->errorCount and the first one is kept in context->error.
+*
+* @param context Address of a Chip8AssContext object set up by Chip8AssInit
+* @param filenamein file to read and assemble
+* @param filenameout file to save the assembled code to
+* @return false if the file could not be opened
+*/
+bool Chip8AssAssembleFile(Chip8AssContext *context, char *filenamein, char *filenameout);
+
+/**
+* Reads the lables of a file and the addresses they are at, without writing anything
+* Used to name addresses in reports, such as the profile written by Chip8WriteProfile.
+*
+* @param context Address of a Chip8AssContext object set up by Chip8AssInit
+* @param filenamein file to read the lables from
+* @return false if the file could not be opened
+*/
+bool Chip8AssReadLables(Chip8AssContext *context, char *filenamein);
+
 /**
 * Process a line from the assembly file
 *
+* @param context Address of the Chip8AssContext object
 * @param line pointer to the string
 * @param lables, weather or not to process lables, this sould be false on secodn run
 * @return false if the line is not parsed
 */
-bool Chip8AssProcessLine(char *line, bool lables);
+bool Chip8AssProcessLine(Chip8AssContext *context, char *line, bool lables);
 
 /**
 * Converts a string to the correct hex value based on the opcode
 *
+* @param context Address of the Chip8AssContext object
 * @param opcode index of the current opcide
 * @param line the currnet line in the file
 * @return None
 */
-int Chip8AssBuildCode(int opcode, char *line);
+int Chip8AssBuildCode(Chip8AssContext *context, int opcode, char *line);
 
 /**
 * tries to match a opcode param,
@@ -136,10 +187,11 @@ int Chip8AssGetV(char **line);
 * attempts to find a matching lable
 * if a lable is not found, it assumes it is a number and converts it
 *
+* @param context Address of the Chip8AssContext object
 * @param line the current string of the line
 * @return the parsed address
 */
-int Chip8AssGetAddress(char *line);
+int Chip8AssGetAddress(Chip8AssContext *context, char *line);
 
 /**
 * using some basic rules formats a string as a int
@@ -0,0 +1,614 @@
+/**
+* Chip-8 Batch
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Batch.h"
+#include "Chip8.h"
+#include "Chip8Assembler.h"
+#include "Chip8Disassembler.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct
+{
+    struct Chip8Batch *batch;
+
+    //files next to end - 1 are still queued on this worker, the worker takes them from the front
+    //and other workers steal from the back
+    pthread_mutex_t lock;
+    int next;
+    int end;
+
+    //position of the worker, it steals from the workers after it first
+    int number;
+
+    pthread_t thread;
+} Chip8BatchWorker;
+
+struct Chip8Batch
+{
+    //CHIP8_BATCH_* job, where its files are written and how long ROMs are run for
+    int job;
+    char output[CHIP8_BATCH_PATH];
+    int frames;
+
+    //one result for each file added, count of capacity are used
+    Chip8BatchResult *results;
+    int count;
+    int capacity;
+
+    //set for the files that are not processed because another file has the same output
+    unsigned char *skip;
+
+    Chip8BatchWorker *workers;
+    int workerCount;
+};
+
+/**
+* Adds a single file to the batch and works out the file it is written to
+*
+* @param batch Address of the Chip8Batch object
+* @param path file to add
+* @return false if the path is too long or there is no memory for it.
+*/
+static bool Chip8BatchAddFile(Chip8Batch *batch, const char *path)
+{
+    if (strlen(path) >= CHIP8_BATCH_PATH)
+        return false;
+
+    if (batch->count == batch->capacity)
+    {
+        int capacity = batch->capacity ? batch->capacity * 2 : 64;
+        Chip8BatchResult *results = (Chip8BatchResult *)realloc(batch->results, capacity * sizeof(Chip8BatchResult));
+
+        if (!results)
+            return false;
+
+        batch->results = results;
+        batch->capacity = capacity;
+    }
+
+    Chip8BatchResult *result = &batch->results[batch->count];
+    memset(result, 0, sizeof(Chip8BatchResult));
+    strcpy(result->input, path);
+
+    if (batch->job != CHIP8_BATCH_RUN)
+    {
+        //output/name.ch8 for a assembled file, output/name.asm for a disassembled one
+        const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+        int length = strlen(name);
+        const char *dot = strrchr(name, '.');
+
+        if (batch->job == CHIP8_BATCH_ASSEMBLE && dot && dot != name)
+            length = dot - name;
+
+        int written = snprintf(result->output, CHIP8_BATCH_PATH, "%s/%.*s%s", batch->output, length, name,
+                               batch->job == CHIP8_BATCH_ASSEMBLE ? ".ch8" : ".asm");
+        if (written >= CHIP8_BATCH_PATH)
+            return false;
+    }
+
+    batch->count++;
+    return true;
+}
+
+/**
+* Compares two strings for qsort
+*
+* @param a Address of the first char pointer
+* @param b Address of the second char pointer
+* @return <0, 0 or >0 like strcmp.
+*/
+static int Chip8BatchCompareNames(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+* Adds every file in a directory to the batch, sorted by name so batches always run in the same order
+*
+* @param batch Address of the Chip8Batch object
+* @param path directory to add
+* @return false if the directory could not be read.
+*/
+static bool Chip8BatchAddDirectory(Chip8Batch *batch, const char *path)
+{
+    DIR *dir = opendir(path);
+    if (!dir)
+        return false;
+
+    char **names = NULL;
+    int count = 0;
+    int capacity = 0;
+    bool ok = true;
+    char file[CHIP8_BATCH_PATH];
+    struct dirent *entry;
+    struct stat info;
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        //skip . and .. and hidden files
+        if (entry->d_name[0] == '.')
+            continue;
+
+        if (snprintf(file, sizeof(file), "%s/%s", path, entry->d_name) >= (int)sizeof(file))
+            continue;
+        if (stat(file, &info) != 0 || !S_ISREG(info.st_mode))
+            continue;
+
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            char **grown = (char **)realloc(names, capacity * sizeof(char *));
+            if (!grown)
+            {
+                ok = false;
+                break;
+            }
+            names = grown;
+        }
+
+        names[count] = strdup(file);
+        if (names[count])
+            count++;
+    }
+    closedir(dir);
+
+    qsort(names, count, sizeof(char *), Chip8BatchCompareNames);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (ok && !Chip8BatchAddFile(batch, names[i]))
+            ok = false;
+        free(names[i]);
+    }
+    free(names);
+
+    return ok;
+}
+
+/**
+* Adds a file or every file in a directory to the batch
+*
+* @param batch Address of the Chip8Batch object
+* @param path file or directory
+* @return false if the directory could not be read.
+*/
+static bool Chip8BatchAddPath(Chip8Batch *batch, const char *path)
+{
+    struct stat info;
+
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode))
+        return Chip8BatchAddDirectory(batch, path);
+
+    //a file that does not exist is still added, so it shows up as a error in the results
+    return Chip8BatchAddFile(batch, path);
+}
+
+/**
+* Creates a empty batch
+*
+* @param job CHIP8_BATCH_* job to do on every file
+* @param output directory the assembled or disassembled files are written to, created if it does not exist
+* @param frames number of frames to run each ROM for CHIP8_BATCH_RUN
+* @return the batch, or NULL if it could not be created.
+*/
+Chip8Batch *Chip8BatchCreate(int job, const char *output, int frames)
+{
+    if (job != CHIP8_BATCH_RUN && (!output || strlen(output) >= CHIP8_BATCH_PATH))
+        return NULL;
+
+    Chip8Batch *batch = (Chip8Batch *)calloc(1, sizeof(Chip8Batch));
+    if (!batch)
+        return NULL;
+
+    batch->job = job;
+    batch->frames = frames;
+    if (output)
+        strcpy(batch->output, output);
+
+    return batch;
+}
+
+/**
+* Frees the batch and its results
+*
+* @param batch Address of the Chip8Batch object
+* @return Nothing.
+*/
+void Chip8BatchFree(Chip8Batch *batch)
+{
+    free(batch->results);
+    free(batch);
+}
+
+/**
+* Adds files to the batch
+* A directory adds every file in it (sorted by name, sub directories are skipped), a path starting with @ is
+* a manifest file that lists one path per line, anything else is added as a single file.
+*
+* @param batch Address of the Chip8Batch object
+* @param path file, directory or @manifest
+* @return false if the directory or manifest could not be read.
+*/
+bool Chip8BatchAdd(Chip8Batch *batch, const char *path)
+{
+    if (path[0] != '@')
+        return Chip8BatchAddPath(batch, path);
+
+    FILE *manifest = fopen(path + 1, "r");
+    if (!manifest)
+        return false;
+
+    //one file or directory on each line, blank lines and lines starting with # are skipped
+    char line[CHIP8_BATCH_PATH];
+    bool ok = true;
+
+    while (fgets(line, sizeof(line), manifest) != NULL)
+    {
+        int length = strlen(line);
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' ' || line[length - 1] == '\t'))
+            line[--length] = '\0';
+
+        if (length > 0 && line[0] != '#' && !Chip8BatchAddPath(batch, line))
+            ok = false;
+    }
+
+    fclose(manifest);
+    return ok;
+}
+
+/**
+* Takes the next file for a worker, from its own queue or else by stealing half of another worker's queue
+*
+* @param worker Address of the Chip8BatchWorker object
+* @param index set to the file to process
+* @return false if every queue is empty.
+*/
+static bool Chip8BatchTake(Chip8BatchWorker *worker, int *index)
+{
+    Chip8Batch *batch = worker->batch;
+
+    pthread_mutex_lock(&worker->lock);
+    if (worker->next < worker->end)
+    {
+        *index = worker->next++;
+        pthread_mutex_unlock(&worker->lock);
+        return true;
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    for (int i = 1; i < batch->workerCount; i++)
+    {
+        Chip8BatchWorker *victim = &batch->workers[(worker->number + i) % batch->workerCount];
+
+        //take the back half, rounded up so the last file can be stolen
+        pthread_mutex_lock(&victim->lock);
+        int left = victim->end - victim->next;
+        int end = victim->end;
+        int first = end - (left + 1) / 2;
+        if (left > 0)
+            victim->end = first;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (left <= 0)
+            continue;
+
+        pthread_mutex_lock(&worker->lock);
+        worker->next = first + 1;
+        worker->end = end;
+        pthread_mutex_unlock(&worker->lock);
+
+        *index = first;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+* Runs a ROM for the batch's number of frames, or until it halts, and sums up where it ended
+*
+* @param batch Address of the Chip8Batch object
+* @param Chip8 Address of the Chip8CPU object to run it on
+* @param result Address of the Chip8BatchResult object of the file
+* @return Nothing.
+*/
+static void Chip8BatchRunRom(Chip8Batch *batch, Chip8CPU *Chip8, Chip8BatchResult *result)
+{
+    Chip8Free(Chip8);
+    memset(Chip8, 0, sizeof(Chip8CPU));
+    Chip8Reset(Chip8);
+
+    if (!Chip8LoadRom(Chip8, result->input))
+    {
+        snprintf(result->message, CHIP8_BATCH_MESSAGE, "could not open file");
+        return;
+    }
+
+    int frame = 0;
+    while (frame < batch->frames && !Chip8->halted)
+    {
+        Chip8RunFrame(Chip8);
+        frame++;
+    }
+
+    //a hash of the display, so runs can be compared
+    unsigned int screen = 2166136261u;
+    for (int row = 0; row < 64; row++)
+    {
+        for (int half = 0; half < 2; half++)
+        {
+            screen = (screen ^ (unsigned int)Chip8->videoMemory[row][half]) * 16777619u;
+            screen = (screen ^ (unsigned int)(Chip8->videoMemory[row][half] >> 32)) * 16777619u;
+        }
+    }
+
+    result->ok = true;
+    snprintf(result->message, CHIP8_BATCH_MESSAGE, "%s %i frames%s, pc %03X, screen %08X",
+             Chip8->halted ? "halted after" : "ran", frame, Chip8->waitingForKey ? ", waiting for a key" : "",
+             Chip8->pc, screen);
+}
+
+/**
+* Worker thread, processes files until every queue is empty
+* Each worker has its own assembler context or Chip8CPU, so nothing is shared between files.
+*
+* @param arg Address of the Chip8BatchWorker object
+* @return NULL.
+*/
+static void *Chip8BatchWorkerMain(void *arg)
+{
+    Chip8BatchWorker *worker = (Chip8BatchWorker *)arg;
+    Chip8Batch *batch = worker->batch;
+    Chip8AssContext *context = NULL;
+    Chip8CPU *Chip8 = NULL;
+    int index;
+
+    if (batch->job == CHIP8_BATCH_ASSEMBLE)
+        context = (Chip8AssContext *)malloc(sizeof(Chip8AssContext));
+    else if (batch->job == CHIP8_BATCH_RUN)
+        Chip8 = (Chip8CPU *)calloc(1, sizeof(Chip8CPU));
+
+    while (Chip8BatchTake(worker, &index))
+    {
+        Chip8BatchResult *result = &batch->results[index];
+        struct stat info;
+
+        if (batch->skip[index])
+            continue;
+
+        if (batch->job == CHIP8_BATCH_ASSEMBLE)
+        {
+            if (!context)
+                snprintf(result->message, CHIP8_BATCH_MESSAGE, "out of memory");
+            else
+            {
+                Chip8AssInit(context, false);
+                if (!Chip8AssAssembleFile(context, result->input, result->output))
+                    snprintf(result->message, CHIP8_BATCH_MESSAGE, "could not open file");
+                else if (context->errorCount > 0)
+                    snprintf(result->message, CHIP8_BATCH_MESSAGE, "%i errors, %s", context->errorCount, context->error);
+                else
+                {
+                    result->ok = true;
+                    snprintf(result->message, CHIP8_BATCH_MESSAGE, "program size: %i bytes", context->pc - 0x200);
+                }
+            }
+        }
+        else if (batch->job == CHIP8_BATCH_DISASSEMBLE)
+        {
+            if (stat(result->input, &info) != 0 || !Chip8DisProcessFile(result->input, result->output))
+                snprintf(result->message, CHIP8_BATCH_MESSAGE, "could not open file");
+            else
+            {
+                result->ok = true;
+                snprintf(result->message, CHIP8_BATCH_MESSAGE, "%lld bytes", (long long)info.st_size);
+            }
+        }
+        else
+        {
+            if (!Chip8)
+                snprintf(result->message, CHIP8_BATCH_MESSAGE, "out of memory");
+            else
+                Chip8BatchRunRom(batch, Chip8, result);
+        }
+    }
+
+    if (Chip8)
+        Chip8Free(Chip8);
+    free(Chip8);
+    free(context);
+
+    return NULL;
+}
+
+/**
+* Compares the outputs of two results for qsort, results with the same output stay in the order they were added
+*
+* @param a Address of the first Chip8BatchResult pointer
+* @param b Address of the second Chip8BatchResult pointer
+* @return <0, 0 or >0 like strcmp.
+*/
+static int Chip8BatchCompareOutputs(const void *a, const void *b)
+{
+    const Chip8BatchResult *x = *(const Chip8BatchResult * const *)a;
+    const Chip8BatchResult *y = *(const Chip8BatchResult * const *)b;
+    int compare = strcmp(x->output, y->output);
+
+    if (compare != 0)
+        return compare;
+    return x < y ? -1 : x > y;
+}
+
+/**
+* Marks the files that would be written to the same output as a earlier file, they are not processed
+*
+* @param batch Address of the Chip8Batch object
+* @return Nothing.
+*/
+static void Chip8BatchFindClashes(Chip8Batch *batch)
+{
+    if (batch->job == CHIP8_BATCH_RUN)
+        return;
+
+    Chip8BatchResult **order = (Chip8BatchResult **)malloc(batch->count * sizeof(Chip8BatchResult *));
+    if (!order)
+        return;
+
+    for (int i = 0; i < batch->count; i++)
+        order[i] = &batch->results[i];
+
+    qsort(order, batch->count, sizeof(Chip8BatchResult *), Chip8BatchCompareOutputs);
+
+    //the first file of each run of files with the same output is the one processed
+    Chip8BatchResult *kept = order[0];
+    for (int i = 1; i < batch->count; i++)
+    {
+        if (strcmp(kept->output, order[i]->output) != 0)
+        {
+            kept = order[i];
+            continue;
+        }
+
+        batch->skip[order[i] - batch->results] = 1;
+        snprintf(order[i]->message, CHIP8_BATCH_MESSAGE, "same output file as %.200s", kept->input);
+    }
+
+    free(order);
+}
+
+/**
+* Processes every file of the batch on a work stealing thread pool, and waits for all of them to finish
+* Each worker starts with a even share of the files and steals half of what is left from another worker when
+* it runs out, so a few slow files do not hold up the rest.
+*
+* @param batch Address of the Chip8Batch object
+* @param threads number of worker threads, 0 for one per online core
+* @return number of files that failed.
+*/
+int Chip8BatchRun(Chip8Batch *batch, int threads)
+{
+    if (batch->count == 0)
+        return 0;
+
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0)
+        threads = 1;
+    if (threads > batch->count)
+        threads = batch->count;
+
+    batch->skip = (unsigned char *)calloc(batch->count, 1);
+    batch->workers = (Chip8BatchWorker *)calloc(threads, sizeof(Chip8BatchWorker));
+    if (!batch->skip || !batch->workers)
+    {
+        free(batch->skip);
+        free(batch->workers);
+        batch->skip = NULL;
+        batch->workers = NULL;
+        return batch->count;
+    }
+    batch->workerCount = threads;
+
+    for (int i = 0; i < batch->count; i++)
+    {
+        batch->results[i].ok = false;
+        batch->results[i].message[0] = '\0';
+    }
+
+    if (batch->job != CHIP8_BATCH_RUN)
+        mkdir(batch->output, 0777);
+
+    Chip8BatchFindClashes(batch);
+
+    for (int i = 0; i < threads; i++)
+    {
+        Chip8BatchWorker *worker = &batch->workers[i];
+
+        worker->batch = batch;
+        worker->number = i;
+        worker->next = (int)((long long)batch->count * i / threads);
+        worker->end = (int)((long long)batch->count * (i + 1) / threads);
+        pthread_mutex_init(&worker->lock, NULL);
+    }
+
+    //the calling thread is the first worker, the files of a worker that could not be started are stolen by the others
+    bool *started = (bool *)calloc(threads, sizeof(bool));
+    for (int i = 1; i < threads && started; i++)
+        started[i] = pthread_create(&batch->workers[i].thread, NULL, Chip8BatchWorkerMain, &batch->workers[i]) == 0;
+
+    Chip8BatchWorkerMain(&batch->workers[0]);
+
+    for (int i = 1; i < threads && started; i++)
+    {
+        if (started[i])
+            pthread_join(batch->workers[i].thread, NULL);
+    }
+
+    for (int i = 0; i < threads; i++)
+        pthread_mutex_destroy(&batch->workers[i].lock);
+
+    free(started);
+    free(batch->workers);
+    free(batch->skip);
+    batch->workers = NULL;
+    batch->skip = NULL;
+    batch->workerCount = 0;
+
+    int failed = 0;
+    for (int i = 0; i < batch->count; i++)
+    {
+        if (!batch->results[i].ok)
+            failed++;
+    }
+
+    return failed;
+}
+
+/**
+* Returns the number of files in the batch
+*
+* @param batch Address of the Chip8Batch object
+* @return number of files.
+*/
+int Chip8BatchCount(Chip8Batch *batch)
+{
+    return batch->count;
+}
+
+/**
+* Returns the result of one of the files, in the order they were added
+*
+* @param batch Address of the Chip8Batch object
+* @param index file number, 0 to count - 1
+* @return Address of the Chip8BatchResult object.
+*/
+const Chip8BatchResult *Chip8BatchGet(Chip8Batch *batch, int index)
+{
+    return &batch->results[index];
+}
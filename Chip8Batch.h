@@ -0,0 +1,112 @@
+/**
+* Chip-8 Batch
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_BATCH_H
+#define CHIP8_BATCH_H
+
+#include <stdbool.h>
+
+//what a batch does with each of its files
+#define CHIP8_BATCH_ASSEMBLE    0   //assemble a source file into a ROM
+#define CHIP8_BATCH_DISASSEMBLE 1   //disassemble a ROM
+#define CHIP8_BATCH_RUN         2   //run a ROM for a number of frames without a window
+
+//longest path and result message kept for a file
+#define CHIP8_BATCH_PATH        1024
+#define CHIP8_BATCH_MESSAGE     320
+
+//what happened to one file of a batch
+typedef struct
+{
+    //the file read, and the file written (empty for CHIP8_BATCH_RUN)
+    char input[CHIP8_BATCH_PATH];
+    char output[CHIP8_BATCH_PATH];
+
+    //false if the file could not be read or written, or had errors
+    bool ok;
+
+    //the first error, or a summary of the file
+    char message[CHIP8_BATCH_MESSAGE];
+} Chip8BatchResult;
+
+//a list of files and the worker threads that process them, see Chip8Batch.c
+typedef struct Chip8Batch Chip8Batch;
+
+/**
+* Creates a empty batch
+*
+* @param job CHIP8_BATCH_* job to do on every file
+* @param output directory the assembled or disassembled files are written to, created if it does not exist
+* @param frames number of frames to run each ROM for CHIP8_BATCH_RUN
+* @return the batch, or NULL if it could not be created.
+*/
+Chip8Batch *Chip8BatchCreate(int job, const char *output, int frames);
+
+/**
+* Frees the batch and its results
+*
+* @param batch Address of the Chip8Batch object
+* @return Nothing.
+*/
+void Chip8BatchFree(Chip8Batch *batch);
+
+/**
+* Adds files to the batch
+* A directory adds every file in it (sorted by name, sub directories are skipped), a path starting with @ is
+* a manifest file that lists one path per line, anything else is added as a single file.
+*
+* @param batch Address of the Chip8Batch object
+* @param path file, directory or @manifest
+* @return false if the directory or manifest could not be read.
+*/
+bool Chip8BatchAdd(Chip8Batch *batch, const char *path);
+
+/**
+* Processes every file of the batch on a work stealing thread pool, and waits for all of them to finish
+* Each worker starts with a even share of the files and steals half of what is left from another worker when
+* it runs out, so a few slow files do not hold up the rest.
+*
+* @param batch Address of the Chip8Batch object
+* @param threads number of worker threads, 0 for one per online core
+* @return number of files that failed.
+*/
+int Chip8BatchRun(Chip8Batch *batch, int threads);
+
+/**
+* Returns the number of files in the batch
+*
+* @param batch Address of the Chip8Batch object
+* @return number of files.
+*/
+int Chip8BatchCount(Chip8Batch *batch);
+
+/**
+* Returns the result of one of the files, in the order they were added
+*
+* @param batch Address of the Chip8Batch object
+* @param index file number, 0 to count - 1
+* @return Address of the Chip8BatchResult object.
+*/
+const Chip8BatchResult *Chip8BatchGet(Chip8Batch *batch, int index);
+
+#endif //header guard CHIP8_BATCH_H
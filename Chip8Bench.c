@@ -0,0 +1,604 @@
+/**
+* Chip-8 Benchmark
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8.h"
+#include "Chip8Batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//defaults for the command line options
+#define CHIP8_BENCH_FRAMES      3000    //frames each ROM runs for
+#define CHIP8_BENCH_CYCLES      1000    //opcodes per frame, far more than the games need so the interpreter is measured
+#define CHIP8_BENCH_REPEATS     5       //runs of each ROM and backend, the fastest one is kept
+#define CHIP8_BENCH_THRESHOLD   15      //percent a result may be slower than the baseline before the run fails
+
+//most ROMs and results the benchmark keeps
+#define CHIP8_BENCH_MAX         1024
+
+//opcode micro benchmark (-u): opcodes run between two reads of the clock, timed samples, and untimed samples run first
+#define CHIP8_BENCH_OP_RUNS     10000
+#define CHIP8_BENCH_OP_SAMPLES  41
+#define CHIP8_BENCH_OP_WARMUP   5
+
+//memory FX33 and FX55 store to in the micro benchmark, on the page of the sprite data so it is never shared
+#define CHIP8_BENCH_OP_SCRATCH  0x380
+
+//one ROM on one backend
+typedef struct
+{
+    char rom[CHIP8_BATCH_PATH];
+    int backend;
+
+    //opcodes per second, nanoseconds per frame and frames per second of the fastest run
+    double ips;
+    double nsPerFrame;
+    double fps;
+} Chip8BenchResult;
+
+static const char *Chip8BenchBackends[] = {"handlers", "threaded", "jit"};
+
+//one opcode of the micro benchmark, run on the state made by Chip8BenchOpcodeState
+typedef struct
+{
+    const char *name;
+    unsigned short opcode;
+
+    //run with the Super Chip-8 128x64 display on
+    bool extended;
+
+    //the time of each run of the opcode in the fastest samples
+    double median;
+    double fastest;
+    double spread;
+} Chip8BenchOpcode;
+
+static Chip8BenchOpcode Chip8BenchOpcodes[] =
+{
+    {"00E0 clear the screen", 0x00E0, false, 0, 0, 0},
+    {"00E0 clear the screen (hires)", 0x00E0, true, 0, 0, 0},
+    {"00EE return", 0x00EE, false, 0, 0, 0},
+    {"00CN scroll down 4", 0x00C4, false, 0, 0, 0},
+    {"00CN scroll down 4 (hires)", 0x00C4, true, 0, 0, 0},
+    {"00FB scroll right (hires)", 0x00FB, true, 0, 0, 0},
+    {"00FC scroll left (hires)", 0x00FC, true, 0, 0, 0},
+    {"00FE low resolution", 0x00FE, false, 0, 0, 0},
+    {"00FF high resolution", 0x00FF, true, 0, 0, 0},
+    {"1NNN jump", 0x1246, false, 0, 0, 0},
+    {"2NNN call", 0x2246, false, 0, 0, 0},
+    {"3XNN skip if VX == NN", 0x3130, false, 0, 0, 0},
+    {"4XNN skip if VX != NN", 0x4130, false, 0, 0, 0},
+    {"5XY0 skip if VX == VY", 0x5120, false, 0, 0, 0},
+    {"6XNN VX = NN", 0x6155, false, 0, 0, 0},
+    {"7XNN VX += NN", 0x7105, false, 0, 0, 0},
+    {"8XY0 VX = VY", 0x8120, false, 0, 0, 0},
+    {"8XY1 VX |= VY", 0x8121, false, 0, 0, 0},
+    {"8XY2 VX &= VY", 0x8122, false, 0, 0, 0},
+    {"8XY3 VX ^= VY", 0x8123, false, 0, 0, 0},
+    {"8XY4 VX += VY", 0x8124, false, 0, 0, 0},
+    {"8XY5 VX -= VY", 0x8125, false, 0, 0, 0},
+    {"8XY6 VX >>= 1", 0x8126, false, 0, 0, 0},
+    {"8XY7 VX = VY - VX", 0x8127, false, 0, 0, 0},
+    {"8XYE VX <<= 1", 0x812E, false, 0, 0, 0},
+    {"9XY0 skip if VX != VY", 0x9120, false, 0, 0, 0},
+    {"ANNN I = NNN", 0xA300, false, 0, 0, 0},
+    {"BNNN jump to NNN + V0", 0xB300, false, 0, 0, 0},
+    {"CXKK VX = random & KK", 0xC1FF, false, 0, 0, 0},
+    {"DXYN 8x5 sprite", 0xD125, false, 0, 0, 0},
+    {"DXYN 8x15 sprite", 0xD12F, false, 0, 0, 0},
+    {"DXYN 8x5 sprite (hires)", 0xD125, true, 0, 0, 0},
+    {"DXY0 16x16 sprite (hires)", 0xD120, true, 0, 0, 0},
+    {"EX9E skip if key VX down", 0xE19E, false, 0, 0, 0},
+    {"EXA1 skip if key VX up", 0xE1A1, false, 0, 0, 0},
+    {"FX07 VX = delay timer", 0xF107, false, 0, 0, 0},
+    {"FX0A wait for a key (key down)", 0xF10A, false, 0, 0, 0},
+    {"FX15 delay timer = VX", 0xF115, false, 0, 0, 0},
+    {"FX18 sound timer = VX", 0xF118, false, 0, 0, 0},
+    {"FX1E I += VX", 0xF11E, false, 0, 0, 0},
+    {"FX29 I = font digit VX", 0xF129, false, 0, 0, 0},
+    {"FX30 I = big font digit VX", 0xF130, false, 0, 0, 0},
+    {"FX33 BCD of VX", 0xF133, false, 0, 0, 0},
+    {"FX55 store V0..VF", 0xFF55, false, 0, 0, 0},
+    {"FX65 load V0..VF", 0xFF65, false, 0, 0, 0},
+    {"FX75 store V0..V7 in R", 0xF775, false, 0, 0, 0},
+    {"FX85 load V0..V7 from R", 0xF785, false, 0, 0, 0},
+};
+
+/**
+* Sets the keys for a frame from a fixed script, so games that wait for a key or need one to start keep moving
+* A key is held for 4 frames out of every 8, a different key each time.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param frame the frame number
+* @return Nothing.
+*/
+static void Chip8BenchKeys(Chip8CPU *Chip8, int frame)
+{
+    memset(Chip8->key, 0, 16);
+
+    if (frame % 8 < 4)
+        Chip8->key[(frame / 8 * 5 + 7) % 16] = 1;
+}
+
+/**
+* Runs a ROM on a backend and times it
+*
+* @param result Address of the result, rom and backend must be set
+* @param frames number of frames to run
+* @param cycles opcodes per frame
+* @param repeats number of runs, the fastest is kept
+* @return false if the ROM could not be loaded.
+*/
+static bool Chip8BenchRun(Chip8BenchResult *result, int frames, int cycles, int repeats)
+{
+    Chip8CPU *Chip8 = (Chip8CPU *)calloc(1, sizeof(Chip8CPU));
+    if (Chip8 == NULL)
+        return false;
+
+    double best = 0;
+    uint64_t ran = 0;
+
+    for (int r = 0; r < repeats; r++)
+    {
+        Chip8->backend = result->backend;
+        Chip8->cyclesPerFrame = cycles;
+        Chip8Seed(Chip8, 0);
+        Chip8Reset(Chip8);
+
+        if (!Chip8LoadRom(Chip8, result->rom))
+        {
+            Chip8Free(Chip8);
+            free(Chip8);
+            return false;
+        }
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        for (int f = 0; f < frames; f++)
+        {
+            Chip8BenchKeys(Chip8, f);
+            Chip8RunFrame(Chip8);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        if (r == 0 || seconds < best)
+            best = seconds;
+        //the idle loops that were fast-forwarded did not run, they are left out of the opcodes per second
+        ran = Chip8->cycles - Chip8->skippedCycles;
+    }
+
+    Chip8Free(Chip8);
+    free(Chip8);
+
+    //a run too fast for the clock counts as 1ns
+    if (best <= 0)
+        best = 1e-9;
+
+    result->ips = ran / best;
+    result->nsPerFrame = best * 1e9 / frames;
+    result->fps = frames / best;
+
+    return true;
+}
+
+/**
+* Puts a machine in the fixed state a opcode of the micro benchmark starts from
+* The registers have set values, I points at sprite data (at scratch memory for the opcodes that store at I),
+* the stack is half full and key 3 is down.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param quirks CHIP8_QUIRKS_* profile
+* @param extended true for the 128x64 display
+* @param opcode the opcode that will be timed
+* @return Nothing.
+*/
+static void Chip8BenchOpcodeState(Chip8CPU *Chip8, int quirks, bool extended, unsigned short opcode)
+{
+    Chip8->quirks = quirks;
+    Chip8Seed(Chip8, 0);
+    Chip8Reset(Chip8);
+
+    for (int i = 0; i < 16; i++)
+        Chip8->V[i] = (i * 37 + 11) & 0xFF;
+    Chip8->V[1] = 10;
+    Chip8->V[2] = 5;
+
+    Chip8->I = 0x300;
+    for (int i = 0; i < 32; i++)
+        Chip8Write(Chip8, 0x300 + i, i % 2 ? 0xA5 : 0x3C);
+
+    //FX33 and FX55 write to memory of their own, not over the sprites or code
+    for (int i = 0; i < 16; i++)
+        Chip8Write(Chip8, CHIP8_BENCH_OP_SCRATCH + i, 0);
+    if ((opcode & 0xF0FF) == 0xF033 || (opcode & 0xF0FF) == 0xF055)
+        Chip8->I = CHIP8_BENCH_OP_SCRATCH;
+
+    for (int i = 0; i < 8; i++)
+        Chip8->stack[i] = 0x200 + i * 2;
+    Chip8->sp = 8;
+
+    Chip8->key[3] = 1;
+    Chip8->delayTimer = 200;
+    Chip8->extendedGraphicsMode = extended;
+    Chip8->runUntil = Chip8->cycles + CHIP8_BENCH_OP_RUNS;
+
+    //a screen that is not empty, so scrolls and sprites have pixels to move and hit
+    for (int y = 0; y < 64; y++)
+    {
+        Chip8->videoMemory[y][0] = 0xF0F0F0F00F0F0F0FULL >> (y % 8);
+        Chip8->videoMemory[y][1] = extended ? 0x00FF00FF00FF00FFULL << (y % 8) : 0;
+    }
+}
+
+/**
+* Sorts doubles from smallest to largest for qsort
+*
+* @param a first number
+* @param b second number
+* @return -1, 0 or 1.
+*/
+static int Chip8BenchCompare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+* Times every opcode handler on its own and prints them from slowest to fastest
+* Each sample runs the opcode CHIP8_BENCH_OP_RUNS times on a fresh copy of its state, after some untimed samples
+* to warm the caches. The slowest quarter of the samples are dropped (they were interrupted), the time is the
+* median of the rest.
+*
+* @param quirks CHIP8_QUIRKS_* profile of the handlers to time
+* @return Nothing.
+*/
+static void Chip8BenchOpcodeTable(int quirks)
+{
+    const int count = sizeof(Chip8BenchOpcodes) / sizeof(Chip8BenchOpcodes[0]);
+    Chip8CPU *Chip8 = (Chip8CPU *)calloc(1, sizeof(Chip8CPU));
+    if (Chip8 == NULL)
+        return;
+
+    for (int i = 0; i < count; i++)
+    {
+        Chip8BenchOpcode *op = &Chip8BenchOpcodes[i];
+        void (*handler)(Chip8CPU *) = Chip8DecodedOpcodeTable[quirks][Chip8DecodeOpcode(op->opcode)];
+        double samples[CHIP8_BENCH_OP_SAMPLES];
+
+        for (int s = -CHIP8_BENCH_OP_WARMUP; s < CHIP8_BENCH_OP_SAMPLES; s++)
+        {
+            Chip8BenchOpcodeState(Chip8, quirks, op->extended, op->opcode);
+            unsigned short pc = Chip8->pc;
+            unsigned short sp = Chip8->sp;
+            unsigned short I = Chip8->I;
+
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+
+            //pc, the stack pointer and I are put back before each run, so 2NNN always calls from and 00EE
+            //always returns to the same place, and FX1E, FX55 and FX65 do not walk I through memory
+            for (int r = 0; r < CHIP8_BENCH_OP_RUNS; r++)
+            {
+                Chip8->pc = pc;
+                Chip8->sp = sp;
+                Chip8->I = I;
+                Chip8->opcode = op->opcode;
+                handler(Chip8);
+            }
+
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            if (s >= 0)
+                samples[s] = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / CHIP8_BENCH_OP_RUNS;
+        }
+
+        qsort(samples, CHIP8_BENCH_OP_SAMPLES, sizeof(double), Chip8BenchCompare);
+
+        //the slowest quarter is dropped, the spread is between the 1st and 3rd quarter of what is left
+        int kept = CHIP8_BENCH_OP_SAMPLES - CHIP8_BENCH_OP_SAMPLES / 4;
+        op->fastest = samples[0];
+        op->median = samples[kept / 2];
+        op->spread = op->median > 0 ? (samples[kept * 3 / 4] - samples[kept / 4]) / op->median * 100 : 0;
+    }
+
+    Chip8Free(Chip8);
+    free(Chip8);
+
+    //slowest first
+    Chip8BenchOpcode *ranked[sizeof(Chip8BenchOpcodes) / sizeof(Chip8BenchOpcodes[0])];
+    for (int i = 0; i < count; i++)
+        ranked[i] = &Chip8BenchOpcodes[i];
+
+    for (int i = 1; i < count; i++)
+    {
+        for (int j = i; j > 0 && ranked[j]->median > ranked[j - 1]->median; j--)
+        {
+            Chip8BenchOpcode *swap = ranked[j];
+            ranked[j] = ranked[j - 1];
+            ranked[j - 1] = swap;
+        }
+    }
+
+    printf("%4s  %-34s %10s %10s %8s\n", "rank", "opcode", "ns/op", "fastest", "spread");
+    for (int i = 0; i < count; i++)
+    {
+        printf("%4d  %-34s %10.2f %10.2f %7.1f%%\n", i + 1, ranked[i]->name, ranked[i]->median, ranked[i]->fastest, ranked[i]->spread);
+    }
+}
+
+/**
+* Reads a baseline written with -o
+*
+* @param filename the baseline file
+* @param results where to store the results
+* @param count where to store the number of results
+* @return false if the file could not be read.
+*/
+static bool Chip8BenchReadBaseline(const char *filename, Chip8BenchResult *results, int *count)
+{
+    FILE *file;
+    file = fopen(filename, "r");
+
+    if (!file)
+        return false;
+
+    char line[CHIP8_BATCH_PATH + 128];
+    char backend[32];
+    *count = 0;
+
+    while (*count < CHIP8_BENCH_MAX && fgets(line, sizeof(line), file))
+    {
+        Chip8BenchResult *result = &results[*count];
+
+        //lines starting with # are comments
+        if (line[0] == '#')
+            continue;
+
+        if (sscanf(line, "%1023s %31s %lf %lf %lf", result->rom, backend, &result->ips, &result->nsPerFrame, &result->fps) != 5)
+            continue;
+
+        result->backend = -1;
+        for (int i = 0; i < 3; i++)
+        {
+            if (strcmp(backend, Chip8BenchBackends[i]) == 0)
+                result->backend = i;
+        }
+
+        if (result->backend >= 0)
+            (*count)++;
+    }
+
+    fclose(file);
+    return true;
+}
+
+/**
+* prints out how to use the benchmark
+*
+* @return none
+*/
+static void Chip8BenchHelp()
+{
+    printf("usage: Chip8Bench [options] [ROM files, directories or @manifests, default Games Games/Super]\n");
+    printf("  -f frames      frames to run each ROM for (default %d)\n", CHIP8_BENCH_FRAMES);
+    printf("  -c cycles      opcodes per frame (default %d)\n", CHIP8_BENCH_CYCLES);
+    printf("  -r repeats     runs of each ROM, the fastest is kept (default %d)\n", CHIP8_BENCH_REPEATS);
+    printf("  -b backend     only run one backend: handlers, threaded or jit\n");
+    printf("  -o file        write the results to a baseline file\n");
+    printf("  -x file        compare with a baseline file, and fail if a result is slower than it allows\n");
+    printf("  -t percent     how much slower than the baseline a result may be (default %d)\n", CHIP8_BENCH_THRESHOLD);
+    printf("  -u quirks      time each opcode handler on its own instead: modern, vip, chip48 or schip\n");
+}
+
+int main(int argc, char **argv)
+{
+    int frames = CHIP8_BENCH_FRAMES;
+    int cycles = CHIP8_BENCH_CYCLES;
+    int repeats = CHIP8_BENCH_REPEATS;
+    int threshold = CHIP8_BENCH_THRESHOLD;
+    int onlyBackend = -1;
+    char *output = NULL;
+    char *baseline = NULL;
+
+    //every file is only listed by the batch, it is not run by it
+    Chip8Batch *batch = Chip8BatchCreate(CHIP8_BATCH_RUN, NULL, 0);
+    if (batch == NULL)
+        return 1;
+
+    bool paths = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-' && argv[i][1] != '\0' && argv[i][2] == '\0' && i + 1 < argc)
+        {
+            char option = argv[i][1];
+            char *value = argv[++i];
+
+            if (option == 'f' && atoi(value) > 0)
+                frames = atoi(value);
+            else if (option == 'c' && atoi(value) > 0)
+                cycles = atoi(value);
+            else if (option == 'r' && atoi(value) > 0)
+                repeats = atoi(value);
+            else if (option == 't' && atoi(value) >= 0)
+                threshold = atoi(value);
+            else if (option == 'o')
+                output = value;
+            else if (option == 'x')
+                baseline = value;
+            else if (option == 'b' && strcmp(value, "handlers") == 0)
+                onlyBackend = CHIP8_BACKEND_HANDLERS;
+            else if (option == 'b' && strcmp(value, "threaded") == 0)
+                onlyBackend = CHIP8_BACKEND_THREADED;
+            else if (option == 'b' && strcmp(value, "jit") == 0)
+                onlyBackend = CHIP8_BACKEND_JIT;
+            else if (option == 'u' && (strcmp(value, "modern") == 0 || strcmp(value, "vip") == 0 ||
+                                       strcmp(value, "chip48") == 0 || strcmp(value, "schip") == 0))
+            {
+                Chip8BenchOpcodeTable(strcmp(value, "modern") == 0 ? CHIP8_QUIRKS_MODERN : strcmp(value, "vip") == 0 ?
+                    CHIP8_QUIRKS_VIP : strcmp(value, "chip48") == 0 ? CHIP8_QUIRKS_CHIP48 : CHIP8_QUIRKS_SCHIP);
+                Chip8BatchFree(batch);
+                return 0;
+            }
+            else
+            {
+                Chip8BenchHelp();
+                Chip8BatchFree(batch);
+                return 1;
+            }
+        }
+        else if (argv[i][0] == '-')
+        {
+            //--help, a option without a value and anything else that is not a option
+            Chip8BenchHelp();
+            Chip8BatchFree(batch);
+            return 1;
+        }
+        else
+        {
+            if (!Chip8BatchAdd(batch, argv[i]))
+                printf("Error reading %s\n", argv[i]);
+            paths = true;
+        }
+    }
+
+    if (!paths)
+    {
+        Chip8BatchAdd(batch, "Games");
+        Chip8BatchAdd(batch, "Games/Super");
+    }
+
+    static Chip8BenchResult results[CHIP8_BENCH_MAX];
+    static Chip8BenchResult baselines[CHIP8_BENCH_MAX];
+    int count = 0;
+    int baselineCount = 0;
+
+    if (baseline != NULL && !Chip8BenchReadBaseline(baseline, baselines, &baselineCount))
+    {
+        printf("Error reading baseline %s\n", baseline);
+        Chip8BatchFree(batch);
+        return 1;
+    }
+
+    printf("%-24s %-9s %14s %12s %10s\n", "ROM", "backend", "opcodes/s", "ns/frame", "frames/s");
+
+    int failed = 0;
+    for (int i = 0; i < Chip8BatchCount(batch); i++)
+    {
+        const char *rom = Chip8BatchGet(batch, i)->input;
+
+        //the .DOC files next to some games are not ROMs
+        const char *name = strrchr(rom, '/') ? strrchr(rom, '/') + 1 : rom;
+        if (strchr(name, '.') != NULL)
+            continue;
+
+        for (int backend = 0; backend < 3 && count < CHIP8_BENCH_MAX; backend++)
+        {
+            if (onlyBackend >= 0 && backend != onlyBackend)
+                continue;
+
+            Chip8BenchResult *result = &results[count];
+            snprintf(result->rom, sizeof(result->rom), "%s", rom);
+            result->backend = backend;
+
+            if (!Chip8BenchRun(result, frames, cycles, repeats))
+            {
+                printf("Error loading %s\n", rom);
+                failed++;
+                break;
+            }
+            count++;
+
+            printf("%-24s %-9s %14.0f %12.0f %10.0f", rom, Chip8BenchBackends[backend], result->ips, result->nsPerFrame, result->fps);
+
+            //slower than the baseline allows
+            for (int b = 0; b < baselineCount; b++)
+            {
+                if (baselines[b].backend == backend && strcmp(baselines[b].rom, rom) == 0)
+                {
+                    double change = (result->ips / baselines[b].ips - 1) * 100;
+                    printf("  %+6.1f%%", change);
+
+                    if (change < -threshold)
+                    {
+                        printf("  SLOWER");
+                        failed++;
+                    }
+                }
+            }
+            printf("\n");
+        }
+    }
+
+    //the totals of each backend
+    for (int backend = 0; backend < 3; backend++)
+    {
+        double ips = 0, nsPerFrame = 0;
+        int roms = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            if (results[i].backend == backend)
+            {
+                ips += results[i].ips;
+                nsPerFrame += results[i].nsPerFrame;
+                roms++;
+            }
+        }
+
+        if (roms > 0)
+            printf("%-24s %-9s %14.0f %12.0f %10.0f\n", "average", Chip8BenchBackends[backend], ips / roms, nsPerFrame / roms, 1e9 / (nsPerFrame / roms));
+    }
+
+    if (output != NULL)
+    {
+        FILE *file;
+        file = fopen(output, "w");
+
+        if (!file)
+        {
+            printf("Error writing %s\n", output);
+            failed++;
+        }
+        else
+        {
+            fprintf(file, "# Chip8Bench baseline: %d frames, %d opcodes per frame\n", frames, cycles);
+            fprintf(file, "# rom backend opcodes/s ns/frame frames/s\n");
+            for (int i = 0; i < count; i++)
+            {
+                fprintf(file, "%s %s %.0f %.0f %.0f\n", results[i].rom, Chip8BenchBackends[results[i].backend],
+                        results[i].ips, results[i].nsPerFrame, results[i].fps);
+            }
+            fclose(file);
+        }
+    }
+
+    if (baseline != NULL)
+        printf("%s\n", failed ? "FAILED, slower than the baseline" : "ok, no slower than the baseline");
+
+    Chip8BatchFree(batch);
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,321 @@
+/**
+* Chip-8 Call Graph Profiler
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8CallGraph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//the calls, cycles and callers of one subroutine, added up over every node it has in the call tree
+typedef struct
+{
+    int address;
+    uint64_t calls;
+    uint64_t inclusive;
+    uint64_t exclusive;
+} Chip8CallGraphSubroutine;
+
+//the calls from one subroutine to another, the caller is -1 for the program itself
+typedef struct
+{
+    int caller;
+    int callee;
+    uint64_t calls;
+} Chip8CallGraphEdge;
+
+/**
+* Returns the call graph of a instance, with the cycles since the last call or return given to the subroutine running now
+* The call graph is kept from the first Chip8Reset until Chip8ClearCallGraph or Chip8Free.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return the call graph, NULL if the emulator was built without CHIP8_CALLGRAPH.
+*/
+Chip8CallGraph *Chip8GetCallGraph(Chip8CPU *Chip8)
+{
+    if (Chip8->callGraph == NULL)
+        return NULL;
+
+    Chip8CallGraphTick(Chip8->callGraph, Chip8->cycles);
+
+    return Chip8->callGraph;
+}
+
+/**
+* Drops the call graph of a instance, the calls open now are left out from here on
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8ClearCallGraph(Chip8CPU *Chip8)
+{
+    if (Chip8->callGraph == NULL)
+        return;
+
+    memset(Chip8->callGraph, 0, sizeof(Chip8CallGraph));
+    Chip8CallGraphRestart(Chip8);
+}
+
+/**
+* Writes the name of a subroutine, its lable or sub_NNN, the program itself is main
+*
+* @param lables lables read by Chip8AssReadLables, or NULL
+* @param address entry address of the subroutine, -1 for the program itself
+* @param buffer at least 40 bytes for the name
+* @return Nothing.
+*/
+static void Chip8CallGraphName(Chip8AssContext *lables, int address, char *buffer)
+{
+    if (address < 0)
+    {
+        strcpy(buffer, "main");
+        return;
+    }
+
+    if (lables != NULL)
+    {
+        for (int i = 0; i < lables->addressPointersCount; i++)
+        {
+            if (lables->addressPointers[i].address == address)
+            {
+                snprintf(buffer, 40, "%.30s", lables->addressPointers[i].name);
+                return;
+            }
+        }
+    }
+
+    snprintf(buffer, 40, "sub_%03X", address);
+}
+
+/**
+* Orders subroutines from the most inclusive cycles to the least, for qsort
+*
+* @param a first Chip8CallGraphSubroutine
+* @param b second Chip8CallGraphSubroutine
+* @return less than 0 if a goes first.
+*/
+static int Chip8CallGraphCompareSubroutines(const void *a, const void *b)
+{
+    const Chip8CallGraphSubroutine *first = (const Chip8CallGraphSubroutine *)a;
+    const Chip8CallGraphSubroutine *second = (const Chip8CallGraphSubroutine *)b;
+
+    if (first->inclusive != second->inclusive)
+        return first->inclusive < second->inclusive ? 1 : -1;
+    if (first->calls != second->calls)
+        return first->calls < second->calls ? 1 : -1;
+    return first->address - second->address;
+}
+
+/**
+* Orders caller/callee edges from the most calls to the least, for qsort
+*
+* @param a first Chip8CallGraphEdge
+* @param b second Chip8CallGraphEdge
+* @return less than 0 if a goes first.
+*/
+static int Chip8CallGraphCompareEdges(const void *a, const void *b)
+{
+    const Chip8CallGraphEdge *first = (const Chip8CallGraphEdge *)a;
+    const Chip8CallGraphEdge *second = (const Chip8CallGraphEdge *)b;
+
+    if (first->calls != second->calls)
+        return first->calls < second->calls ? 1 : -1;
+    if (first->caller != second->caller)
+        return first->caller - second->caller;
+    return first->callee - second->callee;
+}
+
+/**
+* Writes each path of calls that ran any cycles as a line of collapsed stacks: main;name;name cycles
+*
+* @param graph the call graph
+* @param file file to write to
+* @param lables lables read by Chip8AssReadLables, or NULL
+* @return Nothing.
+*/
+static void Chip8CallGraphWriteFolded(Chip8CallGraph *graph, FILE *file, Chip8AssContext *lables)
+{
+    for (int node = 0; node < graph->count; node++)
+    {
+        if (graph->nodes[node].exclusive == 0)
+            continue;
+
+        //the path is found from the node up to the root, so it is written backwards
+        unsigned short path[17];
+        int depth = 0;
+        for (int at = node; at != 0; at = graph->nodes[at].parent)
+            path[depth++] = at;
+
+        char name[40];
+        Chip8CallGraphName(lables, -1, name);
+        fputs(name, file);
+
+        while (depth > 0)
+        {
+            Chip8CallGraphName(lables, graph->nodes[path[--depth]].address, name);
+            fprintf(file, ";%s", name);
+        }
+
+        fprintf(file, " %llu\n", (unsigned long long)graph->nodes[node].exclusive);
+    }
+}
+
+/**
+* Writes the calls and cycles of each subroutine and the calls of each caller/callee edge, the most first
+*
+* @param graph the call graph
+* @param file file to write to
+* @param lables lables read by Chip8AssReadLables, or NULL
+* @return false if there was no memory for the table.
+*/
+static bool Chip8CallGraphWriteTable(Chip8CallGraph *graph, FILE *file, Chip8AssContext *lables)
+{
+    Chip8CallGraphSubroutine *subroutines = (Chip8CallGraphSubroutine *)calloc(4096, sizeof(Chip8CallGraphSubroutine));
+    uint64_t *totals = (uint64_t *)calloc(graph->count, sizeof(uint64_t));
+    Chip8CallGraphEdge *edges = (Chip8CallGraphEdge *)calloc(graph->count, sizeof(Chip8CallGraphEdge));
+
+    if (subroutines == NULL || totals == NULL || edges == NULL)
+    {
+        free(subroutines);
+        free(totals);
+        free(edges);
+        return false;
+    }
+
+    //a node is always added after its caller, so going backwards adds up the cycles of each path and the paths under it
+    for (int node = graph->count - 1; node >= 0; node--)
+    {
+        totals[node] += graph->nodes[node].exclusive;
+        if (node != 0)
+            totals[graph->nodes[node].parent] += totals[node];
+    }
+
+    uint64_t calls = 0;
+    int edgeCount = 0;
+
+    for (int node = 1; node < graph->count; node++)
+    {
+        Chip8CallNode *called = &graph->nodes[node];
+        Chip8CallGraphSubroutine *subroutine = &subroutines[called->address];
+
+        subroutine->address = called->address;
+        subroutine->calls += called->calls;
+        subroutine->exclusive += called->exclusive;
+        calls += called->calls;
+
+        //the cycles of a recursive call are already in the inclusive cycles of the call above it
+        int at = called->parent;
+        while (at != 0 && graph->nodes[at].address != called->address)
+            at = graph->nodes[at].parent;
+        if (at == 0)
+            subroutine->inclusive += totals[node];
+
+        int caller = called->parent == 0 ? -1 : graph->nodes[called->parent].address;
+        int edge = 0;
+        while (edge < edgeCount && (edges[edge].caller != caller || edges[edge].callee != called->address))
+            edge++;
+        if (edge == edgeCount)
+        {
+            edges[edgeCount].caller = caller;
+            edges[edgeCount].callee = called->address;
+            edgeCount++;
+        }
+        edges[edge].calls += called->calls;
+    }
+
+    double total = totals[0] > 0 ? (double)totals[0] : 1;
+
+    fprintf(file, "cycles: %llu\n", (unsigned long long)totals[0]);
+    fprintf(file, "calls: %llu\n", (unsigned long long)calls);
+    fprintf(file, "paths: %d of %d\n\n", graph->count, CHIP8_CALLGRAPH_MAX_NODES);
+
+    fprintf(file, "%-32s %16s %16s %8s %16s %8s\n", "subroutine", "calls", "inclusive", "", "exclusive", "");
+
+    char name[40];
+    Chip8CallGraphName(lables, -1, name);
+    fprintf(file, "%-32s %16s %16llu %7.2f%% %16llu %7.2f%%\n", name, "", (unsigned long long)totals[0], 100.0,
+        (unsigned long long)graph->nodes[0].exclusive, graph->nodes[0].exclusive * 100 / total);
+
+    qsort(subroutines, 4096, sizeof(Chip8CallGraphSubroutine), Chip8CallGraphCompareSubroutines);
+    for (int i = 0; i < CHIP8_CALLGRAPH_TOP && subroutines[i].calls > 0; i++)
+    {
+        Chip8CallGraphName(lables, subroutines[i].address, name);
+        fprintf(file, "%-32s %16llu %16llu %7.2f%% %16llu %7.2f%%\n", name, (unsigned long long)subroutines[i].calls,
+            (unsigned long long)subroutines[i].inclusive, subroutines[i].inclusive * 100 / total,
+            (unsigned long long)subroutines[i].exclusive, subroutines[i].exclusive * 100 / total);
+    }
+
+    fprintf(file, "\n%-32s %-32s %16s\n", "caller", "callee", "calls");
+
+    qsort(edges, edgeCount, sizeof(Chip8CallGraphEdge), Chip8CallGraphCompareEdges);
+    for (int i = 0; i < CHIP8_CALLGRAPH_TOP && i < edgeCount; i++)
+    {
+        char callee[40];
+        Chip8CallGraphName(lables, edges[i].caller, name);
+        Chip8CallGraphName(lables, edges[i].callee, callee);
+        fprintf(file, "%-32s %-32s %16llu\n", name, callee, (unsigned long long)edges[i].calls);
+    }
+
+    free(subroutines);
+    free(totals);
+    free(edges);
+    return true;
+}
+
+/**
+* Writes the call graph of a instance as collapsed stacks, one line for each path of calls with the names of
+* the subroutines split by ';' and the cycles run in the last one, the format flame graph tools read.
+* Subroutines are named by their lable when the lables of the assembler source are given, sub_NNN otherwise.
+* A table of the calls, inclusive and exclusive cycles of each subroutine and the calls of each caller/callee
+* edge can also be written. The inclusive cycles of a subroutine that calls itself are only counted once.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write the collapsed stacks to
+* @param table file to write the table to, or NULL
+* @param lables lables read by Chip8AssReadLables, or NULL
+* @return false if there is no call graph (built without CHIP8_CALLGRAPH) or a file could not be written.
+*/
+bool Chip8WriteCallGraph(Chip8CPU *Chip8, char *filename, char *table, Chip8AssContext *lables)
+{
+    Chip8CallGraph *graph = Chip8GetCallGraph(Chip8);
+
+    if (graph == NULL)
+        return false;
+
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+        return false;
+
+    Chip8CallGraphWriteFolded(graph, file, lables);
+    if (fclose(file) != 0)
+        return false;
+
+    if (table == NULL)
+        return true;
+
+    file = fopen(table, "w");
+    if (file == NULL)
+        return false;
+
+    bool written = Chip8CallGraphWriteTable(graph, file, lables);
+    return fclose(file) == 0 && written;
+}
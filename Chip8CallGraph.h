@@ -0,0 +1,245 @@
+/**
+* Chip-8 Call Graph Profiler
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_CALLGRAPH_H
+#define CHIP8_CALLGRAPH_H
+
+#include "Chip8.h"
+#include "Chip8Assembler.h"
+
+//most nodes in the call tree (different paths of calls), calls that would need more are counted in the caller
+#define CHIP8_CALLGRAPH_MAX_NODES   4096
+
+//most subroutines and caller/callee edges listed by Chip8WriteCallGraph in the table
+#define CHIP8_CALLGRAPH_TOP         40
+
+//no node, used for the links of the call tree
+#define CHIP8_CALLGRAPH_NONE        0xFFFF
+
+//one path of calls from the start of the program to a subroutine
+typedef struct
+{
+    //entry address of the subroutine, the root is the program itself
+    unsigned short address;
+
+    //node of the caller, the first node it calls and the next node its caller calls
+    unsigned short parent;
+    unsigned short firstChild;
+    unsigned short nextSibling;
+
+    //times the subroutine was called on this path
+    uint64_t calls;
+
+    //emulated cycles run in the subroutine itself, the cycles of the subroutines it calls are in their own nodes
+    uint64_t exclusive;
+} Chip8CallNode;
+
+//the calls a instance has made, kept in Chip8->callGraph when built with CHIP8_CALLGRAPH
+//2NNN and 00EE move through a tree with a node for each path of calls, node 0 is the root
+typedef struct Chip8CallGraph
+{
+    Chip8CallNode nodes[CHIP8_CALLGRAPH_MAX_NODES];
+    int count;
+
+    //shadow of the call stack: the node running now and the callers of the calls still open
+    unsigned short current;
+    int depth;
+    unsigned short callers[16];
+
+    //calls made past the 16 entries of callers that have not returned, they are counted in the node running
+    int overflow;
+
+    //value of Chip8->cycles when the cycles before it were given to the current node
+    uint64_t lastCycle;
+} Chip8CallGraph;
+
+/**
+* Gives the cycles run since the last call or return to the node running now
+*
+* @param graph the call graph
+* @param now the cycle the call or return is at
+* @return Nothing.
+*/
+static inline void Chip8CallGraphTick(Chip8CallGraph *graph, uint64_t now)
+{
+    //a state that was loaded can move the cycles back
+    if (now > graph->lastCycle)
+        graph->nodes[graph->current].exclusive += now - graph->lastCycle;
+    graph->lastCycle = now;
+}
+
+/**
+* Follows a call (2NNN) in the call tree, adding a node the first time a path is called
+* A call deeper than the 16 entry stack, or a new path once the tree is full, is counted in the caller:
+* the caller stays the node running, and the 00EE of the call returns to it.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address address being called
+* @param now the cycle the call is at
+* @return Nothing.
+*/
+static inline void Chip8CallGraphCall(Chip8CPU *Chip8, unsigned short address, uint64_t now)
+{
+    Chip8CallGraph *graph = Chip8->callGraph;
+
+    Chip8CallGraphTick(graph, now);
+
+    //past the 16 entries of the stack the calls stay in the caller, their returns are matched by the count
+    if (graph->depth == 16)
+    {
+        graph->overflow++;
+        return;
+    }
+
+    unsigned short node = graph->nodes[graph->current].firstChild;
+    while (node != CHIP8_CALLGRAPH_NONE && graph->nodes[node].address != address)
+        node = graph->nodes[node].nextSibling;
+
+    if (node == CHIP8_CALLGRAPH_NONE)
+    {
+        if (graph->count == CHIP8_CALLGRAPH_MAX_NODES)
+        {
+            graph->callers[graph->depth++] = graph->current;
+            return;
+        }
+
+        node = graph->count++;
+        Chip8CallNode *added = &graph->nodes[node];
+        added->address = address;
+        added->calls = 0;
+        added->exclusive = 0;
+        added->parent = graph->current;
+        added->firstChild = CHIP8_CALLGRAPH_NONE;
+        added->nextSibling = graph->nodes[graph->current].firstChild;
+        graph->nodes[graph->current].firstChild = node;
+    }
+
+    graph->nodes[node].calls++;
+    graph->callers[graph->depth++] = graph->current;
+    graph->current = node;
+}
+
+/**
+* Follows a return (00EE) in the call tree, a return with no call open is left out
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param now the cycle the return is at
+* @return Nothing.
+*/
+static inline void Chip8CallGraphReturn(Chip8CPU *Chip8, uint64_t now)
+{
+    Chip8CallGraph *graph = Chip8->callGraph;
+
+    Chip8CallGraphTick(graph, now);
+    if (graph->overflow > 0)
+    {
+        graph->overflow--;
+        return;
+    }
+    if (graph->depth == 0)
+        return;
+
+    graph->current = graph->callers[--graph->depth];
+}
+
+//the call graph is only compiled in when built with -DCHIP8_CALLGRAPH, otherwise these are empty
+#ifdef CHIP8_CALLGRAPH
+#define CHIP8_CALLGRAPH_CALL(Chip8, address, now)                               \
+    do                                                                          \
+    {                                                                           \
+        if ((Chip8)->callGraph != NULL)                                         \
+            Chip8CallGraphCall((Chip8), (address), (now));                      \
+    } while (0)
+#define CHIP8_CALLGRAPH_RETURN(Chip8, now)                                      \
+    do                                                                          \
+    {                                                                           \
+        if ((Chip8)->callGraph != NULL)                                         \
+            Chip8CallGraphReturn((Chip8), (now));                               \
+    } while (0)
+#else
+#define CHIP8_CALLGRAPH_CALL(Chip8, address, now)   do { } while (0)
+#define CHIP8_CALLGRAPH_RETURN(Chip8, now)          do { } while (0)
+#endif
+
+/**
+* Starts the shadow call stack over at the root, the calls counted so far are kept
+* Called by Chip8Reset and Chip8DeserializeState, the calls on the stack of a loaded state are not known.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+static inline void Chip8CallGraphRestart(Chip8CPU *Chip8)
+{
+    Chip8CallGraph *graph = Chip8->callGraph;
+
+    if (graph == NULL)
+        return;
+
+    if (graph->count == 0)
+    {
+        graph->nodes[0].address = 0x200;
+        graph->nodes[0].parent = CHIP8_CALLGRAPH_NONE;
+        graph->nodes[0].firstChild = CHIP8_CALLGRAPH_NONE;
+        graph->nodes[0].nextSibling = CHIP8_CALLGRAPH_NONE;
+        graph->count = 1;
+    }
+
+    graph->current = 0;
+    graph->depth = 0;
+    graph->overflow = 0;
+    graph->lastCycle = Chip8->cycles;
+}
+
+/**
+* Returns the call graph of a instance, with the cycles since the last call or return given to the subroutine running now
+* The call graph is kept from the first Chip8Reset until Chip8ClearCallGraph or Chip8Free.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return the call graph, NULL if the emulator was built without CHIP8_CALLGRAPH.
+*/
+Chip8CallGraph *Chip8GetCallGraph(Chip8CPU *Chip8);
+
+/**
+* Drops the call graph of a instance, the calls open now are left out from here on
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8ClearCallGraph(Chip8CPU *Chip8);
+
+/**
+* Writes the call graph of a instance as collapsed stacks, one line for each path of calls with the names of
+* the subroutines split by ';' and the cycles run in the last one, the format flame graph tools read.
+* Subroutines are named by their lable when the lables of the assembler source are given, sub_NNN otherwise.
+* A table of the calls, inclusive and exclusive cycles of each subroutine and the calls of each caller/callee
+* edge can also be written. The inclusive cycles of a subroutine that calls itself are only counted once.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write the collapsed stacks to
+* @param table file to write the table to, or NULL
+* @param lables lables read by Chip8AssReadLables, or NULL
+* @return false if there is no call graph (built without CHIP8_CALLGRAPH) or a file could not be written.
+*/
+bool Chip8WriteCallGraph(Chip8CPU *Chip8, char *filename, char *table, Chip8AssContext *lables);
+
+#endif //header guard CHIP8_CALLGRAPH_H
@@ -25,8 +25,8 @@
 
 #include "Chip8Disassembler.h"
 
-//opcodes for the Chip-8
-int opcodeCount = 44;
+//opcodes for the Chip-8, only ever read so several threads can disassemble at once
+const int opcodeCount = 44;
 const char * opCodes[][2] = {
     { "00E0", "CLS" },
     { "00EE", "RET" },
@@ -97,7 +97,13 @@ bool Chip8DisProcessFile (char* filenamein, char* filenameout)
 
     //error opening file
     if (fpin == NULL || fpout == NULL)
+    {
+        if (fpin != NULL)
+            fclose(fpin);
+        if (fpout != NULL)
+            fclose(fpout);
         return false;
+    }
 
     //proncess the file line by line
     while (!feof(fpin)) 
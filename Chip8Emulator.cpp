@@ -27,12 +27,22 @@
 #include <iostream>
 #include <sstream>
 #include <string.h>
+#include <stdlib.h>
 #include <iomanip>
+#include <time.h>
 
 #include "Chip8.h"
 #include "Chip8Emulator.h"
 #include "Chip8Disassembler.h"
 #include "Chip8Assembler.h"
+#include "Chip8Batch.h"
+#include "Chip8Rewind.h"
+#include "Chip8Movie.h"
+#include "Chip8Stats.h"
+#include "Chip8Profile.h"
+#include "Chip8CallGraph.h"
+#include "Chip8Trace.h"
+#include "Chip8Metrics.h"
 
 using namespace std;
 
@@ -55,6 +65,32 @@ int displayMemLocation;
 //holds the breakpoint
 int breakpoint = -1;
 
+//seconds of play that can be rewound, 0 turns rewinding off
+int rewindSeconds = 60;
+
+//true while the rewind key is held down
+bool rewinding = false;
+
+//file the keys are recorded to with -m, NULL when not recording
+char *movieFile = NULL;
+
+//file the opcode counts are written to on exit with -o, NULL when not wanted
+char *statsFile = NULL;
+
+//file the profile is written to on exit with -h, and the lables of the game's assembler source given with -l
+char *profileFile = NULL;
+Chip8AssContext profileLables;
+bool haveLables = false;
+
+//file the call graph is written to on exit with -g as collapsed stacks, with a table in the same name plus .txt
+char *callGraphFile = NULL;
+
+//file the last opcodes run are written to on exit with -tl, NULL when not wanted (-t streams them as they run instead)
+char *traceLastFile = NULL;
+
+//time the last frame was shown, for the frame time metrics served with -e
+uint64_t lastFrame = 0;
+
 using namespace std;
 
 int main(int argc, char **argv)
@@ -94,9 +130,31 @@ int main(int argc, char **argv)
         return 0;
     }
 
+    //decode a trace written with -t or -tl
+    if (strcmp(argv[1], "-dt") == 0)
+    {
+        if (argc < 4)
+            PrintHelp();
+        else if (!Chip8TraceDecode(argv[2], argv[3]))
+        {
+            cout << endl << "Error reading trace file" << endl;
+            PrintHelp();
+        }
+        return 0;
+    }
+
+    //assemble, disassemble or run every file of some directories or manifests
+    if (strcmp(argv[1], "-ba") == 0 || strcmp(argv[1], "-bd") == 0 || strcmp(argv[1], "-br") == 0)
+        return RunBatch(argc, argv);
+
+    //play back a recorded movie without a window
+    if (strcmp(argv[1], "-p") == 0)
+        return RunMovie(argc, argv);
+
     //otherwise we must want to play a game;
 
-    //reset the CPU
+    //reset the CPU, each session gets its own random numbers unless a seed is given with -s
+    Chip8Seed(&mychip8, time(NULL));
     Chip8Reset(&mychip8);
 
     //try to load the rom file
@@ -107,6 +165,92 @@ int main(int argc, char **argv)
         return 0;
     }
 
+    //pick the interpreter backend and quirks, the defaults can be set at build time with -DCHIP8_DEFAULT_BACKEND and -DCHIP8_DEFAULT_QUIRKS
+#ifdef CHIP8_DEFAULT_BACKEND
+    mychip8.backend = CHIP8_DEFAULT_BACKEND;
+#endif
+#ifdef CHIP8_DEFAULT_QUIRKS
+    mychip8.quirks = CHIP8_DEFAULT_QUIRKS;
+#endif
+    for (int i = 2; i < argc; i += 2)
+    {
+        if (i + 1 >= argc)
+        {
+            PrintHelp();
+            return 0;
+        }
+
+        if (strcmp(argv[i], "-b") == 0 && strcmp(argv[i + 1], "threaded") == 0)
+            mychip8.backend = CHIP8_BACKEND_THREADED;
+        else if (strcmp(argv[i], "-b") == 0 && strcmp(argv[i + 1], "jit") == 0)
+            mychip8.backend = CHIP8_BACKEND_JIT;
+        else if (strcmp(argv[i], "-b") == 0 && strcmp(argv[i + 1], "handlers") == 0)
+            mychip8.backend = CHIP8_BACKEND_HANDLERS;
+        else if (strcmp(argv[i], "-q") == 0 && strcmp(argv[i + 1], "modern") == 0)
+            mychip8.quirks = CHIP8_QUIRKS_MODERN;
+        else if (strcmp(argv[i], "-q") == 0 && strcmp(argv[i + 1], "vip") == 0)
+            mychip8.quirks = CHIP8_QUIRKS_VIP;
+        else if (strcmp(argv[i], "-q") == 0 && strcmp(argv[i + 1], "chip48") == 0)
+            mychip8.quirks = CHIP8_QUIRKS_CHIP48;
+        else if (strcmp(argv[i], "-q") == 0 && strcmp(argv[i + 1], "schip") == 0)
+            mychip8.quirks = CHIP8_QUIRKS_SCHIP;
+        else if (strcmp(argv[i], "-c") == 0 && atoi(argv[i + 1]) > 0)
+            mychip8.cyclesPerFrame = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-r") == 0 && atoi(argv[i + 1]) >= 0)
+            rewindSeconds = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-s") == 0)
+            Chip8Seed(&mychip8, strtoull(argv[i + 1], NULL, 10));
+        else if (strcmp(argv[i], "-m") == 0)
+            movieFile = argv[i + 1];
+        else if (strcmp(argv[i], "-o") == 0)
+            statsFile = argv[i + 1];
+        else if (strcmp(argv[i], "-h") == 0)
+            profileFile = argv[i + 1];
+        else if (strcmp(argv[i], "-g") == 0)
+            callGraphFile = argv[i + 1];
+        else if (strcmp(argv[i], "-e") == 0)
+        {
+            if (!Chip8MetricsServe(atoi(argv[i + 1])))
+                cout << "Error serving metrics on port " << argv[i + 1] << " (build with -DCHIP8_METRICS)" << endl;
+        }
+        else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "-tl") == 0)
+        {
+            if (argv[i][2] == 'l')
+                traceLastFile = argv[i + 1];
+            if (!Chip8TraceStart(&mychip8, traceLastFile == NULL ? argv[i + 1] : NULL, 0))
+                cout << "Error starting the trace (build with -DCHIP8_TRACE)" << endl;
+        }
+        else if (strcmp(argv[i], "-l") == 0)
+        {
+            Chip8AssInit(&profileLables, false);
+            haveLables = Chip8AssReadLables(&profileLables, argv[i + 1]);
+            if (!haveLables)
+                cout << "Error reading lables from " << argv[i + 1] << endl;
+        }
+        else
+        {
+            PrintHelp();
+            return 0;
+        }
+    }
+
+    //a frame is stored every 60th of a second, all of the memory for it is allocated now
+    Chip8Rewind *rewind = NULL;
+    if (rewindSeconds > 0)
+        rewind = Chip8RewindCreate(rewindSeconds * 60, 0);
+
+    //record the keys from the state the game is in now
+    Chip8Movie *movie = NULL;
+    if (movieFile != NULL)
+    {
+        movie = Chip8MovieRecord(&mychip8, movieFile);
+        if (movie == NULL)
+        {
+            cout << endl << "Error writing movie file" << endl;
+            return 0;
+        }
+    }
+
     //setup and open a window
     sf::ContextSettings settings;
     settings.depthBits = 0;
@@ -117,7 +261,8 @@ int main(int argc, char **argv)
     
     sf::RenderWindow window(sf::VideoMode(width, height), "Chip8 Emu", sf::Style::Default, settings);
     window.setVerticalSyncEnabled(false);
-    //window.setFramerateLimit(60);
+    //the game is paced by the window, each displayed frame runs one chip-8 frame (60Hz)
+    window.setFramerateLimit(60);
 
     //load a font
     sf::Font font;
@@ -140,13 +285,20 @@ int main(int argc, char **argv)
             else if (event.type == sf::Event::KeyPressed)
             {
                 //program/debugger keys
-                if (event.key.code == sf::Keyboard::Escape)                
+                if (event.key.code == sf::Keyboard::Escape)
+                {
+                    if (movie != NULL)
+                        Chip8MovieStop(movie, &mychip8);
+                    WriteReports();
                     exit(0);
+                }
                 else if (event.key.code == sf::Keyboard::Space)                
                     run = !run;
                 else if (!run && event.key.code == sf::Keyboard::N)
                 {             
-                    Chip8EmulateCycle(&mychip8);
+                    if (movie != NULL)
+                        Chip8MovieInput(movie, &mychip8);
+                    Chip8RunCycles(&mychip8, 1);
                     displayMemLocation = mychip8.pc;
                 }
                 else if (!run && event.key.code == sf::Keyboard::Down && displayMemLocation < 4074)                
@@ -168,13 +320,25 @@ int main(int argc, char **argv)
                 { 
                     mychip8.pc = displayMemLocation;
                     run = true;               
+                    if (movie != NULL)
+                        Chip8MovieSync(movie, &mychip8);
                 }
 
                 //load state keys
                 else if (event.key.code == sf::Keyboard::F1)
                     Chip8SaveState(&mychip8, (char*)"state.c8");
                 else if (event.key.code == sf::Keyboard::F2)
+                {
                     Chip8LoadState(&mychip8, (char*)"state.c8");
+                    if (rewind != NULL)
+                        Chip8RewindClear(rewind);
+                    if (movie != NULL)
+                        Chip8MovieSync(movie, &mychip8);
+                }
+
+                //rewind key, the game runs backwards while it is held
+                else if (event.key.code == sf::Keyboard::BackSpace)
+                    rewinding = true;
 
                 //gamepad keys
                 else if (event.key.code == sf::Keyboard::Num1)
@@ -214,7 +378,9 @@ int main(int argc, char **argv)
             //key up events to clear gamepad keys
             else if (event.type == sf::Event::KeyReleased)
             {
-                if (event.key.code == sf::Keyboard::Num1)
+                if (event.key.code == sf::Keyboard::BackSpace)
+                    rewinding = false;
+                else if (event.key.code == sf::Keyboard::Num1)
                     mychip8.key[0x1] = 0;
                 else if (event.key.code == sf::Keyboard::Num2)
                     mychip8.key[0x2] = 0;
@@ -250,13 +416,48 @@ int main(int argc, char **argv)
         }
 
         //if the emulator is not paused
-        if(run)
+        if (run && rewinding && rewind != NULL)
         {
-            //if we are about to process the breakpoint line
-            if (mychip8.pc == breakpoint - 2)
-                run = false;
-            
-            Chip8EmulateCycle(&mychip8);
+            //step back one stored frame per displayed frame, until the oldest one
+            Chip8RewindStep(rewind, &mychip8);
+            displayMemLocation = mychip8.pc;
+            if (movie != NULL)
+                Chip8MovieSync(movie, &mychip8);
+        }
+        else if(run)
+        {
+            //store the frame before it is run, so rewinding goes back to it
+            if (rewind != NULL)
+                Chip8RewindPush(rewind, &mychip8);
+
+            //the keys can only change between runs, record them with the opcode they change at
+            if (movie != NULL)
+                Chip8MovieInput(movie, &mychip8);
+
+            if (breakpoint == -1)
+                Chip8RunFrame(&mychip8);
+            else
+            {
+                //step one opcode at a time so we can stop on the breakpoint line
+                while (true)
+                {
+                    //if we are about to process the breakpoint line, process it and pause
+                    //(every frame runs at least one opcode, so Space always gets past the breakpoint)
+                    bool stop = mychip8.pc == breakpoint - 2;
+
+                    //last opcode of the frame, let Chip8RunFrame tick the timers
+                    bool last = mychip8.cycles % mychip8.cyclesPerFrame == mychip8.cyclesPerFrame - 1;
+                    if (last)
+                        Chip8RunFrame(&mychip8);
+                    else
+                        Chip8RunCycles(&mychip8, 1);
+
+                    if (stop)
+                        run = false;
+                    if (stop || last)
+                        break;
+                }
+            }
             displayMemLocation = mychip8.pc;
         }
 
@@ -265,6 +466,7 @@ int main(int argc, char **argv)
         DrawUI(&window, &font);
         DrawGameScreen(&window);
         window.display();
+        CHIP8_METRICS_FRAME(lastFrame);
 
         //play a beep if needed (not done yet)
         if (mychip8.playBeep)
@@ -272,9 +474,41 @@ int main(int argc, char **argv)
             mychip8.playBeep = false;
         }
     }
+
+    Chip8RewindFree(rewind);
+    if (movie != NULL && !Chip8MovieStop(movie, &mychip8))
+        cout << "Error writing movie file" << endl;
+    WriteReports();
     return 0;
 }
 
+/**
+* Writes the opcode statistics (-o), profile (-h), call graph (-g) and trace (-t, -tl) that were asked for on the command line
+* and stops the metrics listener (-e)
+*
+* @return none
+*/
+void WriteReports()
+{
+    Chip8MetricsStop();
+    if (traceLastFile != NULL && !Chip8TraceDump(&mychip8, traceLastFile))
+        cout << "Error writing trace" << endl;
+    if (!Chip8TraceStop(&mychip8))
+        cout << "Error writing trace" << endl;
+
+    if (statsFile != NULL && !Chip8WriteStats(&mychip8, statsFile))
+        cout << "Error writing opcode statistics (build with -DCHIP8_STATS)" << endl;
+    if (profileFile != NULL && !Chip8WriteProfile(&mychip8, profileFile, haveLables ? &profileLables : NULL))
+        cout << "Error writing profile (build with -DCHIP8_PROFILE)" << endl;
+
+    if (callGraphFile != NULL)
+    {
+        string table = string(callGraphFile) + ".txt";
+        if (!Chip8WriteCallGraph(&mychip8, callGraphFile, (char *)table.c_str(), haveLables ? &profileLables : NULL))
+            cout << "Error writing call graph (build with -DCHIP8_CALLGRAPH)" << endl;
+    }
+}
+
 /**
 * Draws the UI
 *
@@ -320,21 +554,21 @@ void DrawUI(sf::RenderWindow *window, sf::Font *font)
     char buffer[50];
     for(int i = displayMemLocation - 20; i <= displayMemLocation + 20; i += 2)
     {
-        int value = ((int)mychip8.memory[i] << 8) | (int)mychip8.memory[i + 1];
+        int value = ((int)Chip8Read(&mychip8, i) << 8) | (int)Chip8Read(&mychip8, i + 1);
         Chip8Disassemble(value, buffer);
         //if this line is set as a break display the *
         if (i == breakpoint)
         {
             mem << "* " << setfill('0') << setw(4) << hex << (int)i << ":\t";
-            mem << setfill('0') << setw(2) << hex << (int)mychip8.memory[i];
-            mem <<  setfill('0') << setw(2) << hex << (int)mychip8.memory[i + 1];
+            mem << setfill('0') << setw(2) << hex << (int)Chip8Read(&mychip8, i);
+            mem <<  setfill('0') << setw(2) << hex << (int)Chip8Read(&mychip8, i + 1);
             mem << "    " << buffer << endl;
         }
         else
         {
             mem << "  " << setfill('0') << setw(4) << hex << (int)i << ":\t";
-            mem << setfill('0') << setw(2) << hex << (int)mychip8.memory[i];
-            mem << setfill('0') << setw(2) << hex << (int)mychip8.memory[i + 1];
+            mem << setfill('0') << setw(2) << hex << (int)Chip8Read(&mychip8, i);
+            mem << setfill('0') << setw(2) << hex << (int)Chip8Read(&mychip8, i + 1);
             mem << "    " << buffer << endl;
         }
     }
@@ -421,33 +655,148 @@ void DrawGameScreen(sf::RenderWindow *window)
         modifierFactor = modifierFactor / 2;
     }
 
-    sf::Uint8 screen[screeny * screenx * 4];
-    memset (screen, 0, screeny * screenx * 4);
-     for(int y = 0; y < screeny; y++)      
+    //the texture is kept between frames, only the rows that changed are converted and uploaded
+    static sf::Texture texture;
+    if (texture.getSize().x == 0)
+    {
+        texture.create(128, 64);
+        mychip8.dirtyRows = ~0ULL;
+    }
+
+    sf::Uint8 row[128 * 4];
+    for(int y = 0; y < screeny; y++)
+    {
+        if ((mychip8.dirtyRows & (1ULL << y)) == 0)
+            continue;
+
+        memset (row, 0, screenx * 4);
         for(int x = 0; x < screenx; x++)
-            if(mychip8.videoMemory[(y*screenx) + x] == 1)
+            if(Chip8GetPixel(&mychip8, x, y))
             {
-                screen[(x * 4) + (y * screenx * 4) + 0] = 255;
-                screen[(x * 4) + (y * screenx * 4) + 1] = 255;
-                screen[(x * 4) + (y * screenx * 4) + 2] = 255;
-                screen[(x * 4) + (y * screenx * 4) + 3] = 255;
+                row[(x * 4) + 0] = 255;
+                row[(x * 4) + 1] = 255;
+                row[(x * 4) + 2] = 255;
+                row[(x * 4) + 3] = 255;
             }
-            
-    sf::Image image;
-    image.create(screenx, screeny, screen);
 
-    sf::Texture texture;
-    texture.create(screenx, screeny);
-    texture.update(image);
+        texture.update(row, screenx, 1, 0, y);
+    }
+    mychip8.dirtyRows = 0;
 
     sf::Sprite sprite;
     sprite.setTexture(texture);
+    sprite.setTextureRect(sf::IntRect(0, 0, screenx, screeny));
     sprite.setScale(modifierFactor,modifierFactor);
     sprite.setPosition(4,4);
 
     window->draw(sprite);
 }
 
+/**
+* Runs a batch command: -ba outdir files..., -bd outdir files... or -br frames files...
+* Every file is processed on a thread pool, then the result of each file and a summary are printed
+*
+* @param argc number of command line arguments
+* @param argv the command line arguments
+* @return 0 if every file worked, 1 otherwise
+*/
+int RunBatch(int argc, char **argv)
+{
+    int job = CHIP8_BATCH_ASSEMBLE;
+    if (strcmp(argv[1], "-bd") == 0)
+        job = CHIP8_BATCH_DISASSEMBLE;
+    else if (strcmp(argv[1], "-br") == 0)
+        job = CHIP8_BATCH_RUN;
+
+    if (argc < 4 || (job == CHIP8_BATCH_RUN && atoi(argv[2]) <= 0))
+    {
+        PrintHelp();
+        return 1;
+    }
+
+    Chip8Batch *batch = Chip8BatchCreate(job, job == CHIP8_BATCH_RUN ? NULL : argv[2], atoi(argv[2]));
+    if (batch == NULL)
+    {
+        PrintHelp();
+        return 1;
+    }
+
+    for (int i = 3; i < argc; i++)
+    {
+        if (!Chip8BatchAdd(batch, argv[i]))
+            cout << "Error reading " << argv[i] << endl;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int failed = Chip8BatchRun(batch, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    for (int i = 0; i < Chip8BatchCount(batch); i++)
+    {
+        const Chip8BatchResult *result = Chip8BatchGet(batch, i);
+
+        cout << (result->ok ? "ok     " : "FAILED ") << result->input;
+        if (result->output[0] != '\0')
+            cout << " -> " << result->output;
+        cout << ": " << result->message << endl;
+    }
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    cout << Chip8BatchCount(batch) << " files, " << failed << " failed, " << fixed << setprecision(3) << seconds << "s" << endl;
+
+    Chip8BatchFree(batch);
+    return failed > 0 ? 1 : 0;
+}
+
+/**
+* Plays a movie recorded with -m without a window, as fast as the backend runs: -p movie [handlers|threaded|jit]
+* Prints how long the movie is, how long it took and if the game ended in the same state as the recording
+*
+* @param argc number of command line arguments
+* @param argv the command line arguments
+* @return 0 if the movie played back the same, 1 otherwise
+*/
+int RunMovie(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        PrintHelp();
+        return 1;
+    }
+
+    Chip8Movie *movie = Chip8MovieOpen(argv[2]);
+    if (movie == NULL)
+    {
+        cout << endl << "Error reading movie file" << endl;
+        return 1;
+    }
+
+    Chip8Reset(&mychip8);
+    if (argc > 3 && strcmp(argv[3], "threaded") == 0)
+        mychip8.backend = CHIP8_BACKEND_THREADED;
+    else if (argc > 3 && strcmp(argv[3], "jit") == 0)
+        mychip8.backend = CHIP8_BACKEND_JIT;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (Chip8MoviePlay(movie, &mychip8, 1000000))
+        ;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    bool matches = Chip8MovieMatches(movie, &mychip8);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double played = (double)Chip8MovieLength(movie) / mychip8.cyclesPerFrame / 60;
+
+    cout << Chip8MovieLength(movie) << " opcodes (" << fixed << setprecision(1) << played << "s of play) in "
+         << setprecision(3) << seconds << "s, " << setprecision(0) << (seconds > 0 ? played / seconds : 0) << "x real time" << endl;
+    cout << (matches ? "ok, the game ended in the recorded state" : "FAILED, the game did not end in the recorded state") << endl;
+
+    Chip8MovieFree(movie);
+    Chip8Free(&mychip8);
+    return matches ? 0 : 1;
+}
+
 /**
 * prints out how to use the program
 *
@@ -457,6 +806,21 @@ void PrintHelp()
 {
     cout << endl << "Error, please use one of the following commands" << endl;
     cout << "to play a game: Chip8Emu gamefile.c8" << endl;
+    cout << "To pick the interpreter: Chip8Emu gamefile.c8 -b handlers|threaded|jit" << endl;
+    cout << "To set the speed (opcodes per frame, default 16): Chip8Emu gamefile.c8 -c 16" << endl;
+    cout << "To pick the quirks of a interpreter: Chip8Emu gamefile.c8 -q modern|vip|chip48|schip" << endl;
+    cout << "To play the same random numbers every time: Chip8Emu gamefile.c8 -s 1234" << endl;
+    cout << "To record the keys to a movie: Chip8Emu gamefile.c8 -m movie.c8m" << endl;
+    cout << "To write how often each opcode ran on exit (build with -DCHIP8_STATS): Chip8Emu gamefile.c8 -o stats.txt" << endl;
+    cout << "To write where the time went on exit (build with -DCHIP8_PROFILE): Chip8Emu gamefile.c8 -h profile.txt [-l gamefile.asm]" << endl;
+    cout << "To write the subroutine calls as a flame graph on exit (build with -DCHIP8_CALLGRAPH): Chip8Emu gamefile.c8 -g calls.folded [-l gamefile.asm]" << endl;
+    cout << "To trace every opcode to a file, or only the last 4 million on exit (build with -DCHIP8_TRACE): Chip8Emu gamefile.c8 -t|-tl trace.c8t" << endl;
+    cout << "To decode a trace: Chip8Emu -dt trace.c8t trace.txt" << endl;
+    cout << "To serve Prometheus metrics on http://127.0.0.1:port/metrics (build with -DCHIP8_METRICS): Chip8Emu gamefile.c8 -e 9100" << endl;
+    cout << "To play a movie back as fast as possible: Chip8Emu -p movie.c8m [handlers|threaded|jit]" << endl;
+    cout << "To set how many seconds can be rewound with backspace (default 60, 0 for off): Chip8Emu gamefile.c8 -r 60" << endl;
     cout << "To assemble a file: Chip8Emu -a filenamein.ca filename out.c8" << endl;
-    cout << "To disassemble a file: Chip8Emu -d filenamein.ca filename out.c8" << endl << endl;
+    cout << "To disassemble a file: Chip8Emu -d filenamein.ca filename out.c8" << endl;
+    cout << "To assemble or disassemble many files: Chip8Emu -ba|-bd outdir files, directories or @manifests" << endl;
+    cout << "To run many games without a window: Chip8Emu -br frames files, directories or @manifests" << endl << endl;
 }
\ No newline at end of file
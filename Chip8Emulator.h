@@ -40,6 +40,34 @@ void DrawGameScreen(sf::RenderWindow *window);
 */
 void DrawUI(sf::RenderWindow *window, sf::Font *font);
 
+/**
+* Runs a batch command: -ba outdir files..., -bd outdir files... or -br frames files...
+* Every file is processed on a thread pool, then the result of each file and a summary are printed
+*
+* @param argc number of command line arguments
+* @param argv the command line arguments
+* @return 0 if every file worked, 1 otherwise
+*/
+int RunBatch(int argc, char **argv);
+
+/**
+* Plays a movie recorded with -m without a window, as fast as the backend runs: -p movie [handlers|threaded|jit]
+* Prints how long the movie is, how long it took and if the game ended in the same state as the recording
+*
+* @param argc number of command line arguments
+* @param argv the command line arguments
+* @return 0 if the movie played back the same, 1 otherwise
+*/
+int RunMovie(int argc, char **argv);
+
+/**
+* Writes the opcode statistics (-o), profile (-h), call graph (-g) and trace (-t, -tl) that were asked for on the command line
+* and stops the metrics listener (-e)
+*
+* @return none
+*/
+void WriteReports();
+
 /**
 * prints out how to use the program
 *
@@ -0,0 +1,984 @@
+/**
+* Chip-8 JIT
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Jit.h"
+#include "Chip8Threaded.h"
+#include "Chip8Stats.h"
+#include "Chip8Profile.h"
+#include "Chip8CallGraph.h"
+#include "Chip8Trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(CHIP8_NO_JIT)
+
+#include <sys/mman.h>
+
+//size of the executable buffer, all blocks are dropped and rebuilt when it fills up
+#define CHIP8_JIT_CODE_SIZE         (1024 * 1024)
+
+//longest block that is translated, in opcodes
+#define CHIP8_JIT_MAX_BLOCK         64
+
+//most bytes of x86 code a single opcode (or a block prologue or exit) can take
+#define CHIP8_JIT_MAX_OPCODE_SIZE   64
+
+//most opcodes of translated blocks that are remembered for the CHIP8_STATS counts, all blocks are dropped when it fills up
+#define CHIP8_JIT_MAX_COUNTED       65536
+
+//blocks count how often they run when built with CHIP8_STATS or CHIP8_PROFILE
+#if defined(CHIP8_STATS) || defined(CHIP8_PROFILE)
+#define CHIP8_JIT_COUNT_BLOCKS
+#endif
+
+//most jumps that can wait for their target block to be translated
+#define CHIP8_JIT_MAX_LINKS         4096
+
+//offsets of the Chip8CPU fields used by the translated code, rbx always holds the Chip8CPU
+#define CHIP8_JIT_V(x)      ((int)offsetof(Chip8CPU, V) + (x))
+#define CHIP8_JIT_I         ((int)offsetof(Chip8CPU, I))
+#define CHIP8_JIT_PC        ((int)offsetof(Chip8CPU, pc))
+#define CHIP8_JIT_SP        ((int)offsetof(Chip8CPU, sp))
+#define CHIP8_JIT_STACK     ((int)offsetof(Chip8CPU, stack))
+#define CHIP8_JIT_KEY       ((int)offsetof(Chip8CPU, key))
+#define CHIP8_JIT_OPCODE    ((int)offsetof(Chip8CPU, opcode))
+#define CHIP8_JIT_CYCLES    ((int)offsetof(Chip8CPU, cycles))
+
+//x86 registers used in the reg field of a ModRM byte
+#define CHIP8_JIT_AL        0
+#define CHIP8_JIT_CL        1
+#define CHIP8_JIT_DL        2
+
+//a jump in the code waiting for the block at target to be translated
+typedef struct
+{
+    unsigned int site;
+    unsigned short target;
+} Chip8JitLink;
+
+struct Chip8Jit
+{
+    //executable buffer and how much of it is in use
+    unsigned char *code;
+    unsigned int used;
+
+    //the buffer is never writable and executable at once, it is made writable to translate blocks
+    //and executable again before they are run
+    bool writable;
+
+    //start of the code that returns from translated code to Chip8RunJit, and end of the stubs
+    unsigned int exitStub;
+    unsigned int stubsEnd;
+
+    //entry stub, runs translated code until a block exits and returns the cycles left
+    unsigned long (*enter)(Chip8CPU *Chip8, unsigned long cycles, unsigned char *block, uint64_t end);
+
+    //translated block for each start address, NULL if there is none
+    unsigned char *blocks[4096];
+
+    //number of opcodes in each translated block
+    unsigned char blockLength[4096];
+
+    //set for every byte of memory a translated block was built from
+    unsigned char covered[4096];
+
+    //jumps that can be chained once their target is translated
+    Chip8JitLink links[CHIP8_JIT_MAX_LINKS];
+    int linkCount;
+
+    //CHIP8_QUIRKS_* profile the blocks were translated for
+    unsigned char quirks;
+
+#ifdef CHIP8_JIT_COUNT_BLOCKS
+    //counts the blocks are added to, every opcode of a block runs each time the block is entered, so a block
+    //counts its runs and they are added to the opcodes and addresses it was built from by Chip8JitCountStats
+    struct Chip8Stats *stats;
+    struct Chip8Profile *profile;
+    uint64_t runs[4096];
+    unsigned int firstCounted[4096];
+    unsigned short counted[CHIP8_JIT_MAX_COUNTED];
+    unsigned int countedUsed;
+#endif
+
+#ifdef CHIP8_CALLGRAPH
+    //the blocks were translated to call the 2NNN and 00EE handlers, so the call graph sees them
+    bool callGraph;
+#endif
+};
+
+/*************************************************************************************************
+ * x86-64 code emitter
+*************************************************************************************************/
+
+static void Chip8JitByte(struct Chip8Jit *jit, unsigned char b)
+{
+    jit->code[jit->used++] = b;
+}
+
+static void Chip8JitWord(struct Chip8Jit *jit, unsigned short w)
+{
+    memcpy(jit->code + jit->used, &w, 2);
+    jit->used += 2;
+}
+
+static void Chip8JitDword(struct Chip8Jit *jit, unsigned int d)
+{
+    memcpy(jit->code + jit->used, &d, 4);
+    jit->used += 4;
+}
+
+//rewrite a rel32 at site so it lands on target
+static void Chip8JitPatch(struct Chip8Jit *jit, unsigned int site, unsigned char *target)
+{
+    int rel = (int)(target - (jit->code + site + 4));
+    memcpy(jit->code + site, &rel, 4);
+}
+
+//opcode byte followed by ModRM for [rbx + disp32]
+static void Chip8JitMem(struct Chip8Jit *jit, unsigned char op, int reg, int disp)
+{
+    Chip8JitByte(jit, op);
+    Chip8JitByte(jit, 0x80 | (reg << 3) | 3);
+    Chip8JitDword(jit, disp);
+}
+
+//two byte opcode followed by ModRM for [rbx + disp32]
+static void Chip8JitMem2(struct Chip8Jit *jit, unsigned char op, int reg, int disp)
+{
+    Chip8JitByte(jit, 0x0F);
+    Chip8JitMem(jit, op, reg, disp);
+}
+
+//jmp rel32
+static void Chip8JitJump(struct Chip8Jit *jit, unsigned char *target)
+{
+    Chip8JitByte(jit, 0xE9);
+    Chip8JitDword(jit, 0);
+    Chip8JitPatch(jit, jit->used - 4, target);
+}
+
+//mov word [rbx + pc], target, then return to Chip8RunJit
+static void Chip8JitExitTo(struct Chip8Jit *jit, unsigned short target)
+{
+    //already translated so go straight there
+    if (target <= 0xFFD && jit->blocks[target] != NULL)
+    {
+        Chip8JitJump(jit, jit->blocks[target]);
+        return;
+    }
+
+    Chip8JitByte(jit, 0x66);
+    Chip8JitMem(jit, 0xC7, 0, CHIP8_JIT_PC);
+    Chip8JitWord(jit, target);
+    Chip8JitJump(jit, jit->code + jit->exitStub);
+
+    //remember the jump so it can go to the block once it exists
+    if (target <= 0xFFD && jit->linkCount < CHIP8_JIT_MAX_LINKS)
+    {
+        jit->links[jit->linkCount].site = jit->used - 4;
+        jit->links[jit->linkCount].target = target;
+        jit->linkCount++;
+    }
+}
+
+//return to Chip8RunJit, pc has already been stored
+static void Chip8JitExit(struct Chip8Jit *jit)
+{
+    Chip8JitJump(jit, jit->code + jit->exitStub);
+}
+
+//adds 1 to a CHIP8_STATS counter, does nothing for a NULL counter (rax and the flags are lost)
+static void Chip8JitCount(struct Chip8Jit *jit, uint64_t *counter)
+{
+    if (counter == NULL)
+        return;
+
+    //mov rax, counter; inc qword [rax]
+    unsigned long long address = (unsigned long long)counter;
+    Chip8JitByte(jit, 0x48); Chip8JitByte(jit, 0xB8);
+    memcpy(jit->code + jit->used, &address, 8);
+    jit->used += 8;
+    Chip8JitByte(jit, 0x48); Chip8JitByte(jit, 0xFF); Chip8JitByte(jit, 0x00);
+}
+
+//ends a block on a skip opcode, jcc is the condition (0x84 je, 0x85 jne) that skips, taken is counted when it does
+static void Chip8JitSkip(struct Chip8Jit *jit, unsigned char jcc, unsigned short next, uint64_t *taken)
+{
+    Chip8JitByte(jit, 0x0F);
+    Chip8JitByte(jit, jcc);
+    Chip8JitDword(jit, 0);
+    unsigned int site = jit->used - 4;
+
+    Chip8JitExitTo(jit, next);
+    Chip8JitPatch(jit, site, jit->code + jit->used);
+    Chip8JitCount(jit, taken);
+    Chip8JitExitTo(jit, next + 2);
+}
+
+//calls a opcode handler the same way Chip8RunCycles would, position is the number of the opcode in its block
+static void Chip8JitCall(struct Chip8Jit *jit, unsigned int position, unsigned short next, unsigned short opcode, void (*handler)(Chip8CPU *Chip8))
+{
+    //mov rax, r14; sub rax, r12; add rax, position; mov [rbx + cycles], rax
+    Chip8JitByte(jit, 0x4C); Chip8JitByte(jit, 0x89); Chip8JitByte(jit, 0xF0);
+    Chip8JitByte(jit, 0x4C); Chip8JitByte(jit, 0x29); Chip8JitByte(jit, 0xE0);
+    Chip8JitByte(jit, 0x48); Chip8JitByte(jit, 0x05);
+    Chip8JitDword(jit, position);
+    Chip8JitByte(jit, 0x48);
+    Chip8JitMem(jit, 0x89, CHIP8_JIT_AL, CHIP8_JIT_CYCLES);
+
+    //mov word [rbx + pc], next
+    Chip8JitByte(jit, 0x66);
+    Chip8JitMem(jit, 0xC7, 0, CHIP8_JIT_PC);
+    Chip8JitWord(jit, next);
+
+    //mov word [rbx + opcode], opcode
+    Chip8JitByte(jit, 0x66);
+    Chip8JitMem(jit, 0xC7, 0, CHIP8_JIT_OPCODE);
+    Chip8JitWord(jit, opcode);
+
+    //mov rdi, rbx
+    Chip8JitByte(jit, 0x48); Chip8JitByte(jit, 0x89); Chip8JitByte(jit, 0xDF);
+
+    //mov rax, handler; call rax
+    unsigned long long address = (unsigned long long)handler;
+    Chip8JitByte(jit, 0x48); Chip8JitByte(jit, 0xB8);
+    memcpy(jit->code + jit->used, &address, 8);
+    jit->used += 8;
+    Chip8JitByte(jit, 0xFF); Chip8JitByte(jit, 0xD0);
+}
+
+//setcc cl (0x92 setc, 0x93 setnc) then mov [rbx + VF], cl
+static void Chip8JitSetVF(struct Chip8Jit *jit, unsigned char setcc)
+{
+    Chip8JitByte(jit, 0x0F); Chip8JitByte(jit, setcc); Chip8JitByte(jit, 0xC1);
+    Chip8JitMem(jit, 0x88, CHIP8_JIT_CL, CHIP8_JIT_V(0xF));
+}
+
+/**
+* Builds the stubs at the start of the buffer that go in and out of translated code
+* Registers: rbx holds the Chip8CPU, r13 the cycles left, r14 the value of Chip8->cycles the run ends at
+* and r12 the cycles that were left when the current block started
+*
+* @param jit the translation cache
+* @return Nothing.
+*/
+static void Chip8JitBuildStubs(struct Chip8Jit *jit)
+{
+    static const unsigned char enter[] = 
+    {
+        0x53,                       //push rbx
+        0x55,                       //push rbp
+        0x41, 0x54,                 //push r12
+        0x41, 0x55,                 //push r13
+        0x41, 0x56,                 //push r14
+        0x41, 0x57,                 //push r15
+        0x48, 0x83, 0xEC, 0x08,     //sub rsp, 8 (keep calls 16 byte aligned)
+        0x48, 0x89, 0xFB,           //mov rbx, rdi
+        0x49, 0x89, 0xF5,           //mov r13, rsi
+        0x49, 0x89, 0xCE,           //mov r14, rcx
+        0xFF, 0xE2                  //jmp rdx
+    };
+    static const unsigned char exit[] = 
+    {
+        0x4C, 0x89, 0xE8,           //mov rax, r13
+        0x48, 0x83, 0xC4, 0x08,     //add rsp, 8
+        0x41, 0x5F,                 //pop r15
+        0x41, 0x5E,                 //pop r14
+        0x41, 0x5D,                 //pop r13
+        0x41, 0x5C,                 //pop r12
+        0x5D,                       //pop rbp
+        0x5B,                       //pop rbx
+        0xC3                        //ret
+    };
+
+    memcpy(jit->code, enter, sizeof(enter));
+    jit->enter = (unsigned long (*)(Chip8CPU *, unsigned long, unsigned char *, uint64_t))jit->code;
+    jit->exitStub = sizeof(enter);
+    memcpy(jit->code + jit->exitStub, exit, sizeof(exit));
+    jit->stubsEnd = jit->exitStub + sizeof(exit);
+    jit->used = jit->stubsEnd;
+}
+
+/**
+* Makes the buffer writable to translate blocks into it, or executable to run them
+*
+* @param jit the translation cache
+* @param writable true to make it writable, false to make it executable
+* @return false if the protection could not be changed.
+*/
+static bool Chip8JitProtect(struct Chip8Jit *jit, bool writable)
+{
+    if (jit->writable == writable)
+        return true;
+
+    if (mprotect(jit->code, CHIP8_JIT_CODE_SIZE, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) != 0)
+        return false;
+
+    jit->writable = writable;
+    return true;
+}
+
+#ifdef CHIP8_JIT_COUNT_BLOCKS
+//times the block at start once every CHIP8_PROFILE_INTERVAL blocks (rax and the flags are lost)
+static void Chip8JitSample(struct Chip8Jit *jit, unsigned short start)
+{
+    //mov rax, &countdown; dec dword [rax]; jnz past the call
+    unsigned long long address = (unsigned long long)&jit->profile->countdown;
+    Chip8JitByte(jit, 0x48); Chip8JitByte(jit, 0xB8);
+    memcpy(jit->code + jit->used, &address, 8);
+    jit->used += 8;
+    Chip8JitByte(jit, 0xFF); Chip8JitByte(jit, 0x08);
+    Chip8JitByte(jit, 0x75); Chip8JitByte(jit, 20);
+
+    //mov rdi, rbx; mov esi, start; mov rax, Chip8ProfileSample; call rax (20 bytes)
+    Chip8JitByte(jit, 0x48); Chip8JitByte(jit, 0x89); Chip8JitByte(jit, 0xDF);
+    Chip8JitByte(jit, 0xBE);
+    Chip8JitDword(jit, start);
+    address = (unsigned long long)&Chip8ProfileSample;
+    Chip8JitByte(jit, 0x48); Chip8JitByte(jit, 0xB8);
+    memcpy(jit->code + jit->used, &address, 8);
+    jit->used += 8;
+    Chip8JitByte(jit, 0xFF); Chip8JitByte(jit, 0xD0);
+}
+#endif
+
+/**
+* Adds the runs of every translated block to the counts of the opcodes and addresses it was built from,
+* and sets them back to 0
+*
+* @param jit the translation cache
+* @return Nothing.
+*/
+static void Chip8JitAddRuns(struct Chip8Jit *jit)
+{
+#ifdef CHIP8_JIT_COUNT_BLOCKS
+    for (int start = 0; start < 4096; start++)
+    {
+        if (jit->blocks[start] == NULL || jit->runs[start] == 0)
+            continue;
+
+        for (int i = 0; i < jit->blockLength[start]; i++)
+        {
+            if (jit->stats != NULL)
+                jit->stats->opcodes[jit->counted[jit->firstCounted[start] + i]] += jit->runs[start];
+            if (jit->profile != NULL)
+                jit->profile->runs[start + i * 2] += jit->runs[start];
+        }
+        jit->runs[start] = 0;
+    }
+#else
+    (void)jit;
+#endif
+}
+
+/**
+* Drops every translated block, the stubs are kept
+* Nothing is written to the buffer, handlers called from translated code can flush it
+*
+* @param jit the translation cache
+* @return Nothing.
+*/
+static void Chip8JitFlush(struct Chip8Jit *jit)
+{
+    Chip8JitAddRuns(jit);
+#ifdef CHIP8_JIT_COUNT_BLOCKS
+    memset(jit->runs, 0, sizeof(jit->runs));
+    jit->countedUsed = 0;
+#endif
+
+    jit->used = jit->stubsEnd;
+    memset(jit->blocks, 0, sizeof(jit->blocks));
+    memset(jit->blockLength, 0, sizeof(jit->blockLength));
+    memset(jit->covered, 0, sizeof(jit->covered));
+    jit->linkCount = 0;
+}
+
+/**
+* Translates the basic block starting at a address, the buffer must be writable
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param jit the translation cache
+* @param start address of the first opcode, must be 0xFFD or lower
+* @return the entry point of the block.
+*/
+static unsigned char *Chip8JitTranslate(Chip8CPU *Chip8, struct Chip8Jit *jit, unsigned short start)
+{
+    if (jit->used + (CHIP8_JIT_MAX_BLOCK + 4) * CHIP8_JIT_MAX_OPCODE_SIZE > CHIP8_JIT_CODE_SIZE)
+        Chip8JitFlush(jit);
+#ifdef CHIP8_JIT_COUNT_BLOCKS
+    if (jit->countedUsed + CHIP8_JIT_MAX_BLOCK > CHIP8_JIT_MAX_COUNTED)
+        Chip8JitFlush(jit);
+#endif
+
+    unsigned char *entry = jit->code + jit->used;
+
+    //cmp r13, length; jb out of cycles; mov r12, r13; sub r13, length
+    Chip8JitByte(jit, 0x49); Chip8JitByte(jit, 0x81); Chip8JitByte(jit, 0xFD);
+    Chip8JitDword(jit, 0);
+    unsigned int lengthCheck = jit->used - 4;
+    Chip8JitByte(jit, 0x0F); Chip8JitByte(jit, 0x82);
+    Chip8JitDword(jit, 0);
+    unsigned int outOfCycles = jit->used - 4;
+    Chip8JitByte(jit, 0x4D); Chip8JitByte(jit, 0x89); Chip8JitByte(jit, 0xEC);
+    Chip8JitByte(jit, 0x49); Chip8JitByte(jit, 0x81); Chip8JitByte(jit, 0xED);
+    Chip8JitDword(jit, 0);
+    unsigned int lengthSub = jit->used - 4;
+
+    //counters compiled into the block when built with CHIP8_STATS or CHIP8_PROFILE, one for the block and one for each skip taken
+    Chip8Stats *stats = NULL;
+#ifdef CHIP8_JIT_COUNT_BLOCKS
+    stats = jit->stats;
+    if (stats != NULL || jit->profile != NULL)
+    {
+        Chip8JitCount(jit, &jit->runs[start]);
+        jit->firstCounted[start] = jit->countedUsed;
+    }
+    if (jit->profile != NULL)
+        Chip8JitSample(jit, start);
+#endif
+
+    unsigned short pc = start;
+    unsigned int length = 0;
+    bool ended = false;
+
+    //the quirks are fixed when a block is translated, Chip8RunJit flushes the blocks if the profile changes
+    int quirks = Chip8->quirks;
+    void (**handlers)(Chip8CPU *Chip8) = Chip8DecodedOpcodeTable[quirks];
+
+    while (!ended)
+    {
+        if (length == CHIP8_JIT_MAX_BLOCK || pc > 0xFFD)
+        {
+            Chip8JitExitTo(jit, pc);
+            break;
+        }
+
+        unsigned short opcode = Chip8ReadOpcode(Chip8, pc);
+        unsigned char op = Chip8DecodeAddress(Chip8, pc);
+        unsigned short next = pc + 2;
+        int x = (opcode & 0x0F00) >> 8;
+        int y = (opcode & 0x00F0) >> 4;
+        unsigned char kk = opcode & 0x00FF;
+        unsigned short nnn = opcode & 0x0FFF;
+
+        jit->covered[pc] = jit->covered[pc + 1] = 1;
+        length++;
+
+#ifdef CHIP8_JIT_COUNT_BLOCKS
+        jit->counted[jit->countedUsed++] = opcode;
+#endif
+
+        switch (op)
+        {
+            case CHIP8_OP_1NNN:
+                Chip8JitExitTo(jit, nnn);
+                ended = true;
+                break;
+
+            case CHIP8_OP_2NNN:
+#ifdef CHIP8_CALLGRAPH
+                //the handler follows the call in the call graph
+                if (jit->callGraph)
+                {
+                    Chip8JitCall(jit, length - 1, next, opcode, handlers[op]);
+                    Chip8JitExit(jit);
+                    ended = true;
+                    break;
+                }
+#endif
+                //movzx eax, word [sp]; and eax, 15; mov word [rbx + rax * 2 + stack], next; inc word [sp]
+                Chip8JitMem2(jit, 0xB7, CHIP8_JIT_AL, CHIP8_JIT_SP);
+                Chip8JitByte(jit, 0x83); Chip8JitByte(jit, 0xE0); Chip8JitByte(jit, 0x0F);
+                Chip8JitByte(jit, 0x66); Chip8JitByte(jit, 0xC7); Chip8JitByte(jit, 0x84); Chip8JitByte(jit, 0x43);
+                Chip8JitDword(jit, CHIP8_JIT_STACK);
+                Chip8JitWord(jit, next);
+                Chip8JitByte(jit, 0x66);
+                Chip8JitMem(jit, 0xFF, 0, CHIP8_JIT_SP);
+                Chip8JitExitTo(jit, nnn);
+                ended = true;
+                break;
+
+            case CHIP8_OP_00EE:
+#ifdef CHIP8_CALLGRAPH
+                if (jit->callGraph)
+                {
+                    Chip8JitCall(jit, length - 1, next, opcode, handlers[op]);
+                    Chip8JitExit(jit);
+                    ended = true;
+                    break;
+                }
+#endif
+                //movzx eax, word [sp]; dec eax; mov [sp], ax; and eax, 15
+                Chip8JitMem2(jit, 0xB7, CHIP8_JIT_AL, CHIP8_JIT_SP);
+                Chip8JitByte(jit, 0xFF); Chip8JitByte(jit, 0xC8);
+                Chip8JitByte(jit, 0x66);
+                Chip8JitMem(jit, 0x89, CHIP8_JIT_AL, CHIP8_JIT_SP);
+                Chip8JitByte(jit, 0x83); Chip8JitByte(jit, 0xE0); Chip8JitByte(jit, 0x0F);
+                //movzx eax, word [rbx + rax * 2 + stack]; mov [pc], ax
+                Chip8JitByte(jit, 0x0F); Chip8JitByte(jit, 0xB7); Chip8JitByte(jit, 0x84); Chip8JitByte(jit, 0x43);
+                Chip8JitDword(jit, CHIP8_JIT_STACK);
+                Chip8JitByte(jit, 0x66);
+                Chip8JitMem(jit, 0x89, CHIP8_JIT_AL, CHIP8_JIT_PC);
+                Chip8JitExit(jit);
+                ended = true;
+                break;
+
+            case CHIP8_OP_3XNN:
+            case CHIP8_OP_4XNN:
+                //cmp byte [Vx], kk
+                Chip8JitMem(jit, 0x80, 7, CHIP8_JIT_V(x));
+                Chip8JitByte(jit, kk);
+                Chip8JitSkip(jit, op == CHIP8_OP_3XNN ? 0x84 : 0x85, next, stats != NULL ? &stats->skips[op] : NULL);
+                ended = true;
+                break;
+
+            case CHIP8_OP_5XY0:
+            case CHIP8_OP_9XY0:
+                //mov al, [Vx]; cmp al, [Vy]
+                Chip8JitMem(jit, 0x8A, CHIP8_JIT_AL, CHIP8_JIT_V(x));
+                Chip8JitMem(jit, 0x3A, CHIP8_JIT_AL, CHIP8_JIT_V(y));
+                Chip8JitSkip(jit, op == CHIP8_OP_5XY0 ? 0x84 : 0x85, next, stats != NULL ? &stats->skips[op] : NULL);
+                ended = true;
+                break;
+
+            case CHIP8_OP_EX9E:
+            case CHIP8_OP_EXA1:
+                //movzx eax, byte [Vx]; cmp byte [rbx + rax + key], 0
+                Chip8JitMem2(jit, 0xB6, CHIP8_JIT_AL, CHIP8_JIT_V(x));
+                Chip8JitByte(jit, 0x80); Chip8JitByte(jit, 0xBC); Chip8JitByte(jit, 0x03);
+                Chip8JitDword(jit, CHIP8_JIT_KEY);
+                Chip8JitByte(jit, 0x00);
+                Chip8JitSkip(jit, op == CHIP8_OP_EX9E ? 0x85 : 0x84, next, stats != NULL ? &stats->skips[op] : NULL);
+                ended = true;
+                break;
+
+            case CHIP8_OP_6XNN:
+                //mov byte [Vx], kk
+                Chip8JitMem(jit, 0xC6, 0, CHIP8_JIT_V(x));
+                Chip8JitByte(jit, kk);
+                break;
+
+            case CHIP8_OP_7XNN:
+                //add byte [Vx], kk
+                Chip8JitMem(jit, 0x80, 0, CHIP8_JIT_V(x));
+                Chip8JitByte(jit, kk);
+                break;
+
+            case CHIP8_OP_8XY0:
+                Chip8JitMem(jit, 0x8A, CHIP8_JIT_AL, CHIP8_JIT_V(y));
+                Chip8JitMem(jit, 0x88, CHIP8_JIT_AL, CHIP8_JIT_V(x));
+                break;
+
+            case CHIP8_OP_8XY1:
+            case CHIP8_OP_8XY2:
+            case CHIP8_OP_8XY3:
+                //mov al, [Vx]; or/and/xor al, [Vy]; mov [Vx], al
+                Chip8JitMem(jit, 0x8A, CHIP8_JIT_AL, CHIP8_JIT_V(x));
+                Chip8JitMem(jit, op == CHIP8_OP_8XY1 ? 0x0A : op == CHIP8_OP_8XY2 ? 0x22 : 0x32, CHIP8_JIT_AL, CHIP8_JIT_V(y));
+                Chip8JitMem(jit, 0x88, CHIP8_JIT_AL, CHIP8_JIT_V(x));
+                if (CHIP8_QUIRK_VF_RESET(quirks))
+                {
+                    //mov byte [VF], 0
+                    Chip8JitMem(jit, 0xC6, 0, CHIP8_JIT_V(0xF));
+                    Chip8JitByte(jit, 0x00);
+                }
+                break;
+
+            case CHIP8_OP_8XY4:
+            case CHIP8_OP_8XY5:
+            case CHIP8_OP_8XY7:
+                //the handlers write VF before the result, when VF is also a operand let them do it
+                if (x == 0xF || y == 0xF)
+                {
+                    Chip8JitCall(jit, length - 1, next, opcode, handlers[op]);
+                    break;
+                }
+                if (op == CHIP8_OP_8XY7)
+                {
+                    Chip8JitMem(jit, 0x8A, CHIP8_JIT_AL, CHIP8_JIT_V(y));
+                    Chip8JitMem(jit, 0x2A, CHIP8_JIT_AL, CHIP8_JIT_V(x));
+                }
+                else
+                {
+                    Chip8JitMem(jit, 0x8A, CHIP8_JIT_AL, CHIP8_JIT_V(x));
+                    Chip8JitMem(jit, op == CHIP8_OP_8XY4 ? 0x02 : 0x2A, CHIP8_JIT_AL, CHIP8_JIT_V(y));
+                }
+                Chip8JitMem(jit, 0x88, CHIP8_JIT_AL, CHIP8_JIT_V(x));
+                //carry for add, not borrow for the subtracts (mov does not touch the flags)
+                Chip8JitSetVF(jit, op == CHIP8_OP_8XY4 ? 0x92 : 0x93);
+                break;
+
+            case CHIP8_OP_8XY6:
+            case CHIP8_OP_8XYE:
+                if (x == 0xF || CHIP8_QUIRK_SHIFT_VY(quirks))
+                {
+                    Chip8JitCall(jit, length - 1, next, opcode, handlers[op]);
+                    break;
+                }
+                //shr/shl byte [Vx], 1 then VF = the bit shifted out
+                Chip8JitMem(jit, 0xD0, op == CHIP8_OP_8XY6 ? 5 : 4, CHIP8_JIT_V(x));
+                Chip8JitSetVF(jit, 0x92);
+                break;
+
+            case CHIP8_OP_ANNN:
+                //mov word [I], nnn
+                Chip8JitByte(jit, 0x66);
+                Chip8JitMem(jit, 0xC7, 0, CHIP8_JIT_I);
+                Chip8JitWord(jit, nnn);
+                break;
+
+            case CHIP8_OP_BNNN:
+                //movzx eax, byte [V0] (or [Vx] for BXNN); add eax, nnn; mov [pc], ax
+                Chip8JitMem2(jit, 0xB6, CHIP8_JIT_AL, CHIP8_JIT_V(CHIP8_QUIRK_JUMP_VX(quirks) ? x : 0));
+                Chip8JitByte(jit, 0x05);
+                Chip8JitDword(jit, nnn);
+                Chip8JitByte(jit, 0x66);
+                Chip8JitMem(jit, 0x89, CHIP8_JIT_AL, CHIP8_JIT_PC);
+                Chip8JitExit(jit);
+                ended = true;
+                break;
+
+            case CHIP8_OP_FX1E:
+                if (x == 0xF)
+                {
+                    Chip8JitCall(jit, length - 1, next, opcode, handlers[op]);
+                    break;
+                }
+                //movzx eax, word [I]; movzx ecx, byte [Vx]; add eax, ecx
+                Chip8JitMem2(jit, 0xB7, CHIP8_JIT_AL, CHIP8_JIT_I);
+                Chip8JitMem2(jit, 0xB6, CHIP8_JIT_CL, CHIP8_JIT_V(x));
+                Chip8JitByte(jit, 0x01); Chip8JitByte(jit, 0xC8);
+                //cmp eax, 0xFFF; seta dl; mov [I], ax; mov [VF], dl
+                Chip8JitByte(jit, 0x3D);
+                Chip8JitDword(jit, 0xFFF);
+                Chip8JitByte(jit, 0x0F); Chip8JitByte(jit, 0x97); Chip8JitByte(jit, 0xC2);
+                Chip8JitByte(jit, 0x66);
+                Chip8JitMem(jit, 0x89, CHIP8_JIT_AL, CHIP8_JIT_I);
+                Chip8JitMem(jit, 0x88, CHIP8_JIT_DL, CHIP8_JIT_V(0xF));
+                break;
+
+            case CHIP8_OP_FX29:
+            case CHIP8_OP_FX30:
+                //movzx eax, byte [Vx]; lea eax, [rax + rax * 4]; mov [I], ax
+                Chip8JitMem2(jit, 0xB6, CHIP8_JIT_AL, CHIP8_JIT_V(x));
+                Chip8JitByte(jit, 0x8D); Chip8JitByte(jit, 0x04); Chip8JitByte(jit, 0x80);
+                Chip8JitByte(jit, 0x66);
+                Chip8JitMem(jit, 0x89, CHIP8_JIT_AL, CHIP8_JIT_I);
+                break;
+
+            //the idle handlers move Chip8->cycles forward, so the cycles left are reloaded and the block ends
+            case CHIP8_OP_FX07_IDLE:
+            case CHIP8_OP_1NNN_IDLE:
+            case CHIP8_OP_FX0A:
+            case CHIP8_OP_00FD:
+                //the idle loops also depend on the 2 opcodes after this one
+                if (op == CHIP8_OP_FX07_IDLE || op == CHIP8_OP_1NNN_IDLE)
+                    memset(jit->covered + pc, 1, 6);
+                Chip8JitCall(jit, length - 1, next, opcode, handlers[op]);
+                //mov r13, r14; sub r13, [rbx + cycles]; dec r13
+                Chip8JitByte(jit, 0x4D); Chip8JitByte(jit, 0x89); Chip8JitByte(jit, 0xF5);
+                Chip8JitByte(jit, 0x4C);
+                Chip8JitMem(jit, 0x2B, 5, CHIP8_JIT_CYCLES);
+                Chip8JitByte(jit, 0x49); Chip8JitByte(jit, 0xFF); Chip8JitByte(jit, 0xCD);
+                Chip8JitExit(jit);
+                ended = true;
+                break;
+
+            //these can change pc or write memory that may have been translated, so the block ends after them
+            case CHIP8_OP_FX33:
+            case CHIP8_OP_FX55:
+                Chip8JitCall(jit, length - 1, next, opcode, handlers[op]);
+                Chip8JitExit(jit);
+                ended = true;
+                break;
+
+            default:
+                Chip8JitCall(jit, length - 1, next, opcode, handlers[op]);
+                break;
+        }
+
+        pc = next;
+    }
+
+    //out of cycles: leave pc at the start of the block and return
+    Chip8JitPatch(jit, outOfCycles, jit->code + jit->used);
+    Chip8JitByte(jit, 0x66);
+    Chip8JitMem(jit, 0xC7, 0, CHIP8_JIT_PC);
+    Chip8JitWord(jit, start);
+    Chip8JitExit(jit);
+
+    memcpy(jit->code + lengthCheck, &length, 4);
+    memcpy(jit->code + lengthSub, &length, 4);
+
+    jit->blocks[start] = entry;
+    jit->blockLength[start] = length;
+
+    //chain the jumps that were waiting for this block
+    for (int i = 0; i < jit->linkCount; )
+    {
+        if (jit->links[i].target == start)
+        {
+            Chip8JitPatch(jit, jit->links[i].site, entry);
+            jit->links[i] = jit->links[--jit->linkCount];
+        }
+        else
+            i++;
+    }
+
+    return entry;
+}
+
+/**
+* Runs opcodes by translating them to x86-64 code
+* Basic blocks starting at pc are translated once into a executable buffer and run natively,
+* blocks ending in a jump or call to a fixed address are chained straight to the next block.
+* The buffer is writable only while blocks are translated and executable only while they run.
+* Opcodes that are hard to translate (DXYN, FX0A...) call the Chip8OpCode handlers.
+* The translation cache is created on the first call and kept in Chip8->jit.
+* On other hosts, or if the buffer can not be mapped, the threaded interpreter is used instead.
+* Chip8->cycles is counted up for each opcode, the timers are brought up to date by Chip8RunCycles.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+void Chip8RunJit(Chip8CPU *Chip8, unsigned long cycles)
+{
+    struct Chip8Jit *jit = Chip8->jit;
+    uint64_t end = Chip8->cycles + cycles;
+
+#ifdef CHIP8_TRACE
+    //translated blocks do not stop after each opcode, the threaded loop traces them
+    if (Chip8->trace != NULL)
+    {
+        Chip8RunThreaded(Chip8, cycles);
+        return;
+    }
+#endif
+
+    if (jit == NULL)
+    {
+        jit = (struct Chip8Jit *)calloc(1, sizeof(struct Chip8Jit));
+        if (jit == NULL)
+        {
+            Chip8RunThreaded(Chip8, cycles);
+            return;
+        }
+
+        void *code = mmap(NULL, CHIP8_JIT_CODE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (code == MAP_FAILED)
+        {
+            free(jit);
+            Chip8RunThreaded(Chip8, cycles);
+            return;
+        }
+
+        jit->code = (unsigned char *)code;
+        jit->writable = true;
+        Chip8JitBuildStubs(jit);
+        Chip8JitFlush(jit);
+        jit->quirks = Chip8->quirks;
+        Chip8->jit = jit;
+    }
+
+    if (jit->quirks != Chip8->quirks)
+    {
+        Chip8JitFlush(jit);
+        jit->quirks = Chip8->quirks;
+    }
+
+#ifdef CHIP8_JIT_COUNT_BLOCKS
+    //the blocks count into the counts they were translated with
+    if (jit->stats != Chip8->stats || jit->profile != Chip8->profile)
+    {
+        Chip8JitFlush(jit);
+        jit->stats = Chip8->stats;
+        jit->profile = Chip8->profile;
+    }
+#endif
+#ifdef CHIP8_CALLGRAPH
+    if (jit->callGraph != (Chip8->callGraph != NULL))
+    {
+        Chip8JitFlush(jit);
+        jit->callGraph = Chip8->callGraph != NULL;
+    }
+#endif
+
+    while (cycles > 0)
+    {
+        unsigned short pc = Chip8->pc;
+        Chip8->cycles = end - cycles;
+        Chip8->runUntil = end;
+
+        //the last opcode in memory wraps around, leave it to the interpreter
+        if (pc > 0xFFD)
+        {
+            Chip8RunThreaded(Chip8, 1);
+            cycles--;
+            continue;
+        }
+
+        unsigned char *block = jit->blocks[pc];
+        if (block == NULL)
+        {
+            if (!Chip8JitProtect(jit, true))
+            {
+                Chip8RunThreaded(Chip8, cycles);
+                return;
+            }
+            block = Chip8JitTranslate(Chip8, jit, pc);
+        }
+
+        //not enough cycles left for the whole block
+        if (jit->blockLength[pc] > cycles)
+        {
+            Chip8RunThreaded(Chip8, cycles);
+            return;
+        }
+
+        if (!Chip8JitProtect(jit, false))
+        {
+            Chip8RunThreaded(Chip8, cycles);
+            return;
+        }
+        cycles = jit->enter(Chip8, cycles, block, end);
+    }
+
+    Chip8->cycles = end;
+}
+
+/**
+* Drops the translated blocks if any of them were built from a range of memory
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address first address that was written
+* @param length number of bytes that were written
+* @return Nothing.
+*/
+void Chip8JitInvalidate(Chip8CPU *Chip8, int address, int length)
+{
+    struct Chip8Jit *jit = Chip8->jit;
+
+    if (jit == NULL)
+        return;
+
+    if (address < 0)
+        address = 0;
+    if (address + length > 4096)
+        length = 4096 - address;
+
+    //blocks can be chained together, so drop all of them rather than tracking who jumps where
+    for (int i = 0; i < length; i++)
+    {
+        if (jit->covered[address + i])
+        {
+            Chip8JitFlush(jit);
+            return;
+        }
+    }
+}
+
+/**
+* Adds the opcodes run by translated blocks to Chip8->stats and Chip8->profile, called before they are read
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8JitCountStats(Chip8CPU *Chip8)
+{
+    if (Chip8->jit != NULL)
+        Chip8JitAddRuns(Chip8->jit);
+}
+
+/**
+* Frees the translation cache of a Chip8CPU
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8JitFree(Chip8CPU *Chip8)
+{
+    struct Chip8Jit *jit = Chip8->jit;
+
+    if (jit == NULL)
+        return;
+
+    Chip8JitAddRuns(jit);
+    munmap(jit->code, CHIP8_JIT_CODE_SIZE);
+    free(jit);
+    Chip8->jit = NULL;
+}
+
+#else
+
+/**
+* Runs opcodes with the threaded interpreter, there is no JIT for this host
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+void Chip8RunJit(Chip8CPU *Chip8, unsigned long cycles)
+{
+    Chip8RunThreaded(Chip8, cycles);
+}
+
+/**
+* Nothing is translated on this host
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address first address that was written
+* @param length number of bytes that were written
+* @return Nothing.
+*/
+void Chip8JitInvalidate(Chip8CPU *Chip8, int address, int length)
+{
+    (void)Chip8;
+    (void)address;
+    (void)length;
+}
+
+/**
+* Nothing is translated on this host
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8JitCountStats(Chip8CPU *Chip8)
+{
+    (void)Chip8;
+}
+
+/**
+* Nothing is translated on this host
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8JitFree(Chip8CPU *Chip8)
+{
+    (void)Chip8;
+}
+
+#endif
@@ -0,0 +1,70 @@
+/**
+* Chip-8 JIT
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_JIT_H
+#define CHIP8_JIT_H
+
+#include "Chip8.h"
+
+/**
+* Runs opcodes by translating them to x86-64 code
+* Basic blocks starting at pc are translated once into a executable buffer and run natively,
+* blocks ending in a jump or call to a fixed address are chained straight to the next block.
+* Opcodes that are hard to translate (DXYN, FX0A...) call the Chip8OpCode handlers.
+* The translation cache is created on the first call and kept in Chip8->jit.
+* On other hosts, or if the buffer can not be mapped, the threaded interpreter is used instead.
+* Chip8->cycles is counted up for each opcode, the timers are brought up to date by Chip8RunCycles.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+void Chip8RunJit(Chip8CPU *Chip8, unsigned long cycles);
+
+/**
+* Drops the translated blocks if any of them were built from a range of memory
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address first address that was written
+* @param length number of bytes that were written
+* @return Nothing.
+*/
+void Chip8JitInvalidate(Chip8CPU *Chip8, int address, int length);
+
+/**
+* Adds the opcodes run by translated blocks to Chip8->stats and Chip8->profile, called before they are read
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8JitCountStats(Chip8CPU *Chip8);
+
+/**
+* Frees the translation cache of a Chip8CPU
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8JitFree(Chip8CPU *Chip8);
+
+#endif //header guard CHIP8_JIT_H
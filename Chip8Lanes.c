@@ -0,0 +1,829 @@
+/**
+* Chip-8 Lanes
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+
+#include "Chip8Lanes.h"
+#include <stdlib.h>
+#include <string.h>
+
+//mask with every lane of a group set
+#define CHIP8_LANES_ALL     0xFFFFFFFFu
+
+//a group that averaged fewer lanes than this for each opcode it ran has split up,
+//its lanes are run one at a time for the next CHIP8_LANES_RETRY runs before it tries again
+#define CHIP8_LANES_SPLIT   4
+#define CHIP8_LANES_RETRY   60
+
+//runs the statements for every lane in mask
+//the loop over a full group has no test in it, so the compiler can turn it into vector instructions
+#define CHIP8_LANES_FOR(l, ...)                                                 \
+    do                                                                          \
+    {                                                                           \
+        if (mask == CHIP8_LANES_ALL)                                            \
+        {                                                                       \
+            _Pragma("GCC ivdep")                                                \
+            for (int l = 0; l < CHIP8_LANES; l++)                               \
+            {                                                                   \
+                __VA_ARGS__                                                     \
+            }                                                                   \
+        }                                                                       \
+        else                                                                    \
+        {                                                                       \
+            for (uint32_t bits = mask; bits; bits &= bits - 1)                  \
+            {                                                                   \
+                int l = __builtin_ctz(bits);                                    \
+                __VA_ARGS__                                                     \
+            }                                                                   \
+        }                                                                       \
+    } while (0)
+
+//CHIP8_LANES instances run together, their registers are stored register by register so each one fills a vector
+typedef struct
+{
+    unsigned char V[16][CHIP8_LANES];
+    unsigned short stack[16][CHIP8_LANES];
+    unsigned short I[CHIP8_LANES];
+    unsigned short pc[CHIP8_LANES];
+    unsigned short sp[CHIP8_LANES];
+    unsigned char delayTimer[CHIP8_LANES];
+    unsigned char soundTimer[CHIP8_LANES];
+
+    //the instance run by each lane, memory, the display and everything else is kept there
+    Chip8CPU *cpu[CHIP8_LANES];
+
+    //lanes that have a instance, the last group may not be full
+    uint32_t used;
+
+    //memoryWrites of each instance when sameCode was worked out, sameCode is set while every lane has the same memory
+    unsigned int memoryWrites[CHIP8_LANES];
+    bool sameCode;
+
+    //runs left before the group tries to run its lanes together again, see CHIP8_LANES_SPLIT
+    unsigned int scalarRuns;
+
+    //the registers above are only copied back into an instance when it is handed out by Chip8LanesGet,
+    //out has the lanes whose instance holds their registers, they are copied in again by the next run
+    uint32_t out;
+
+    //lanes that have not halted
+    uint32_t running;
+
+    //number of opcodes the group has run, Chip8->cycles of the lanes that are not out
+    uint64_t cycles;
+} Chip8LaneGroup;
+
+struct Chip8Lanes
+{
+    Chip8CPU *instances;
+    int count;
+
+    Chip8LaneGroup *groups;
+    int groupCount;
+};
+
+/**
+* Copies the registers of a lane's instance into the group
+*
+* @param group Address of the Chip8LaneGroup object
+* @param l lane
+* @return Nothing.
+*/
+static void Chip8LanesLoad(Chip8LaneGroup *group, int l)
+{
+    Chip8CPU *Chip8 = group->cpu[l];
+
+    for (int i = 0; i < 16; i++)
+    {
+        group->V[i][l] = Chip8->V[i];
+        group->stack[i][l] = Chip8->stack[i];
+    }
+
+    group->I[l] = Chip8->I;
+    group->pc[l] = Chip8->pc;
+    group->sp[l] = Chip8->sp;
+    group->delayTimer[l] = Chip8->delayTimer;
+    group->soundTimer[l] = Chip8->soundTimer;
+}
+
+/**
+* Copies the registers of a lane back into its instance
+*
+* @param group Address of the Chip8LaneGroup object
+* @param l lane
+* @return Nothing.
+*/
+static void Chip8LanesStore(Chip8LaneGroup *group, int l)
+{
+    Chip8CPU *Chip8 = group->cpu[l];
+
+    for (int i = 0; i < 16; i++)
+    {
+        Chip8->V[i] = group->V[i][l];
+        Chip8->stack[i] = group->stack[i][l];
+    }
+
+    Chip8->I = group->I[l];
+    Chip8->pc = group->pc[l];
+    Chip8->sp = group->sp[l];
+    Chip8->delayTimer = group->delayTimer[l];
+    Chip8->soundTimer = group->soundTimer[l];
+}
+
+/**
+* Counts the timers of every lane down, like Chip8UpdateTimers
+*
+* @param group Address of the Chip8LaneGroup object
+* @param frames number of 60Hz frames that have passed
+* @return Nothing.
+*/
+static void Chip8LanesTick(Chip8LaneGroup *group, uint64_t frames)
+{
+    unsigned char f = frames > 0xFF ? 0xFF : frames;
+    uint32_t beep = 0;
+
+    for (int l = 0; l < CHIP8_LANES; l++)
+    {
+        unsigned char delay = group->delayTimer[l];
+        unsigned char sound = group->soundTimer[l];
+
+        group->delayTimer[l] = delay > f ? delay - f : 0;
+        group->soundTimer[l] = sound > f ? sound - f : 0;
+        beep |= (uint32_t)(sound != 0 && sound <= f) << l;
+    }
+
+    for (; beep; beep &= beep - 1)
+        group->cpu[__builtin_ctz(beep)]->playBeep = true;
+}
+
+/**
+* Copies the registers of a lane back into its instance, if they are not there already
+* The lane is read back in at the start of the next run.
+*
+* @param group Address of the Chip8LaneGroup object
+* @param l lane
+* @return Nothing.
+*/
+static void Chip8LanesCheckOut(Chip8LaneGroup *group, int l)
+{
+    Chip8CPU *Chip8 = group->cpu[l];
+
+    if (group->out >> l & 1)
+        return;
+
+    Chip8LanesStore(group, l);
+    Chip8->cycles = group->cycles;
+    Chip8->timerCycle = group->cycles;
+    Chip8->runUntil = group->cycles;
+    group->out |= 1u << l;
+}
+
+/**
+* Works out if every lane has the same memory again, if any of them has written to it since the last time
+* While they do, the lanes at the same address are known to have the same opcode there.
+*
+* @param group Address of the Chip8LaneGroup object
+* @return Nothing.
+*/
+static void Chip8LanesCheckCode(Chip8LaneGroup *group)
+{
+    bool written = false;
+
+    for (uint32_t m = group->used; m; m &= m - 1)
+    {
+        int l = __builtin_ctz(m);
+
+        if (group->memoryWrites[l] != group->cpu[l]->memoryWrites)
+        {
+            group->memoryWrites[l] = group->cpu[l]->memoryWrites;
+            written = true;
+        }
+    }
+
+    if (!written)
+        return;
+
+    Chip8Page **pages = group->cpu[0]->pages;
+
+    //lanes that share a page (see Chip8ShareMemory) do not need to compare it
+    group->sameCode = true;
+    for (uint32_t m = group->used & (group->used - 1); m && group->sameCode; m &= m - 1)
+    {
+        Chip8Page **other = group->cpu[__builtin_ctz(m)]->pages;
+
+        for (int i = 0; i < CHIP8_PAGE_COUNT && group->sameCode; i++)
+            group->sameCode = other[i] == pages[i] || memcmp(other[i]->data, pages[i]->data, CHIP8_PAGE_SIZE) == 0;
+    }
+}
+
+/**
+* Runs a opcode on the lanes in a mask together
+* Only opcodes that just use the registers are run here, the rest are run one lane at a time by Chip8LanesScalar.
+*
+* @param group Address of the Chip8LaneGroup object
+* @param mask lanes to run
+* @param op CHIP8_OP_* index of the opcode
+* @param opcode the opcode
+* @param quirks CHIP8_QUIRKS_* profile
+* @return false if the opcode has to be run one lane at a time.
+*/
+static bool Chip8LanesVector(Chip8LaneGroup *group, uint32_t mask, unsigned char op, unsigned short opcode, int quirks)
+{
+    unsigned char (*V)[CHIP8_LANES] = group->V;
+    unsigned short *pc = group->pc;
+    const int x = (opcode & 0x0F00) >> 8;
+    const int y = (opcode & 0x00F0) >> 4;
+    const unsigned char nn = opcode & 0x00FF;
+    const unsigned short nnn = opcode & 0x0FFF;
+
+    //the opcodes that set VF as well as VX are left to the handlers when VF is also VX or VY
+    if ((x == 0xF || y == 0xF) && ((op >= CHIP8_OP_8XY4 && op <= CHIP8_OP_8XYE) || op == CHIP8_OP_FX1E))
+        return false;
+
+    switch (op)
+    {
+        case CHIP8_OP_00EE:
+            CHIP8_LANES_FOR(l, group->sp[l]--; pc[l] = group->stack[group->sp[l] & 0x0F][l];);
+            return true;
+
+        case CHIP8_OP_1NNN:
+        case CHIP8_OP_1NNN_IDLE:
+            CHIP8_LANES_FOR(l, pc[l] = nnn;);
+            return true;
+
+        case CHIP8_OP_2NNN:
+            CHIP8_LANES_FOR(l, group->stack[group->sp[l] & 0x0F][l] = pc[l] + 2; group->sp[l]++; pc[l] = nnn;);
+            return true;
+
+        case CHIP8_OP_3XNN:
+            CHIP8_LANES_FOR(l, pc[l] += V[x][l] == nn ? 4 : 2;);
+            return true;
+
+        case CHIP8_OP_4XNN:
+            CHIP8_LANES_FOR(l, pc[l] += V[x][l] != nn ? 4 : 2;);
+            return true;
+
+        case CHIP8_OP_5XY0:
+            CHIP8_LANES_FOR(l, pc[l] += V[x][l] == V[y][l] ? 4 : 2;);
+            return true;
+
+        case CHIP8_OP_9XY0:
+            CHIP8_LANES_FOR(l, pc[l] += V[x][l] != V[y][l] ? 4 : 2;);
+            return true;
+
+        case CHIP8_OP_6XNN:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[x][l] = nn;);
+            return true;
+
+        case CHIP8_OP_7XNN:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[x][l] += nn;);
+            return true;
+
+        case CHIP8_OP_8XY0:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[x][l] = V[y][l];);
+            return true;
+
+        case CHIP8_OP_8XY1:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[x][l] |= V[y][l];);
+            if (CHIP8_QUIRK_VF_RESET(quirks))
+                CHIP8_LANES_FOR(l, V[0xF][l] = 0;);
+            return true;
+
+        case CHIP8_OP_8XY2:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[x][l] &= V[y][l];);
+            if (CHIP8_QUIRK_VF_RESET(quirks))
+                CHIP8_LANES_FOR(l, V[0xF][l] = 0;);
+            return true;
+
+        case CHIP8_OP_8XY3:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[x][l] ^= V[y][l];);
+            if (CHIP8_QUIRK_VF_RESET(quirks))
+                CHIP8_LANES_FOR(l, V[0xF][l] = 0;);
+            return true;
+
+        case CHIP8_OP_8XY4:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[0xF][l] = V[y][l] > 0xFF - V[x][l]; V[x][l] += V[y][l];);
+            return true;
+
+        case CHIP8_OP_8XY5:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[0xF][l] = V[y][l] <= V[x][l]; V[x][l] -= V[y][l];);
+            return true;
+
+        case CHIP8_OP_8XY6:
+            if (CHIP8_QUIRK_SHIFT_VY(quirks))
+                CHIP8_LANES_FOR(l, V[x][l] = V[y][l];);
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[0xF][l] = V[x][l] & 0x1; V[x][l] >>= 1;);
+            return true;
+
+        case CHIP8_OP_8XY7:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[0xF][l] = V[x][l] <= V[y][l]; V[x][l] = V[y][l] - V[x][l];);
+            return true;
+
+        case CHIP8_OP_8XYE:
+            if (CHIP8_QUIRK_SHIFT_VY(quirks))
+                CHIP8_LANES_FOR(l, V[x][l] = V[y][l];);
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[0xF][l] = V[x][l] >> 7; V[x][l] <<= 1;);
+            return true;
+
+        case CHIP8_OP_ANNN:
+            CHIP8_LANES_FOR(l, pc[l] += 2; group->I[l] = nnn;);
+            return true;
+
+        case CHIP8_OP_BNNN:
+        {
+            const int jump = CHIP8_QUIRK_JUMP_VX(quirks) ? x : 0;
+            CHIP8_LANES_FOR(l, pc[l] = nnn + V[jump][l];);
+            return true;
+        }
+
+        case CHIP8_OP_EX9E:
+            CHIP8_LANES_FOR(l, pc[l] += group->cpu[l]->key[V[x][l]] != 0 ? 4 : 2;);
+            return true;
+
+        case CHIP8_OP_EXA1:
+            CHIP8_LANES_FOR(l, pc[l] += group->cpu[l]->key[V[x][l]] == 0 ? 4 : 2;);
+            return true;
+
+        case CHIP8_OP_FX07:
+        case CHIP8_OP_FX07_IDLE:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[x][l] = group->delayTimer[l];);
+            return true;
+
+        case CHIP8_OP_FX15:
+            CHIP8_LANES_FOR(l, pc[l] += 2; group->delayTimer[l] = V[x][l];);
+            return true;
+
+        case CHIP8_OP_FX18:
+            CHIP8_LANES_FOR(l, pc[l] += 2; group->soundTimer[l] = V[x][l];);
+            return true;
+
+        case CHIP8_OP_FX1E:
+            CHIP8_LANES_FOR(l, pc[l] += 2; V[0xF][l] = group->I[l] + V[x][l] > 0xFFF; group->I[l] += V[x][l];);
+            return true;
+
+        case CHIP8_OP_FX29:
+        case CHIP8_OP_FX30:
+            CHIP8_LANES_FOR(l, pc[l] += 2; group->I[l] = V[x][l] * 0x5;);
+            return true;
+    }
+
+    return false;
+}
+
+/**
+* Runs a opcode on one lane with the handler from Chip8DecodedOpcodeTable
+* The lane's registers are copied into its instance for the handler and copied back after it.
+*
+* @param group Address of the Chip8LaneGroup object
+* @param l lane
+* @param op CHIP8_OP_* index of the opcode
+* @param opcode the opcode, the same in every lane of the slot
+* @param handler handler for the opcode
+* @param now number of the opcode being run
+* @param until cycle the handler may fast-forward to (see Chip8->runUntil)
+* @return Nothing.
+*/
+static void Chip8LanesScalar(Chip8LaneGroup *group, int l, unsigned char op, unsigned short opcode, void (*handler)(Chip8CPU *Chip8), uint64_t now, uint64_t until)
+{
+    Chip8CPU *Chip8 = group->cpu[l];
+
+    Chip8->opcode = opcode;
+
+    if (op == CHIP8_OP_DXYN)
+    {
+        //the most common one, it only reads VX, VY and I and sets VF
+        int x = (opcode & 0x0F00) >> 8;
+        int y = (opcode & 0x00F0) >> 4;
+
+        Chip8->V[x] = group->V[x][l];
+        Chip8->V[y] = group->V[y][l];
+        Chip8->I = group->I[l];
+        (*handler)(Chip8);
+        group->V[0xF][l] = Chip8->V[0xF];
+        group->pc[l] += 2;
+        return;
+    }
+
+    Chip8LanesStore(group, l);
+
+    //the lanes' timers are always up to date, so Chip8UpdateTimers has nothing to do
+    Chip8->cycles = now;
+    Chip8->timerCycle = now;
+    Chip8->runUntil = until;
+
+    Chip8->pc += 2;
+    (*handler)(Chip8);
+
+    Chip8LanesLoad(group, l);
+}
+
+/**
+* Runs a number of opcodes on a group
+* Each step every lane runs one opcode, lanes at the same address with the same opcode run it together.
+* A lane in a idle loop (see Chip8DecodeAddress), or waiting for a key, sits out the steps Chip8RunCycles
+* would have fast-forwarded, and the whole group is fast-forwarded while every lane is sitting out.
+*
+* @param group Address of the Chip8LaneGroup object
+* @param cycles number of opcodes to run, 0 to run to the end of the current frame
+* @return Nothing.
+*/
+static void Chip8LanesRunGroup(Chip8LaneGroup *group, uint64_t cycles)
+{
+    Chip8CPU *first = group->cpu[0];
+    const int quirks = first->quirks;
+    const unsigned int cyclesPerFrame = first->cyclesPerFrame;
+    void (**handlers)(Chip8CPU *Chip8) = Chip8DecodedOpcodeTable[quirks];
+
+    //the first lane sets the group's cycles if it has been handed out
+    if (group->out & 1)
+        group->cycles = first->cycles;
+
+    if (cycles == 0)
+        cycles = cyclesPerFrame - group->cycles % cyclesPerFrame;
+
+    uint64_t now = group->cycles;
+    uint64_t end = now + cycles;
+    uint64_t nextFrame = (now / cyclesPerFrame + 1) * cyclesPerFrame;
+
+    //lanes sitting out until their wake cycle
+    uint32_t parked = 0;
+    uint64_t wake[CHIP8_LANES];
+    uint64_t nextWake = end;
+
+    //opcodes run, and the lanes that ran them, to tell if the group has split up
+    uint64_t slotsRun = 0;
+    uint64_t lanesRun = 0;
+
+    if (group->scalarRuns > 0)
+    {
+        //the lanes have gone their own ways, run them one at a time with their own backend for now
+        group->scalarRuns--;
+        for (uint32_t m = group->used; m; m &= m - 1)
+            Chip8RunCycles(group->cpu[__builtin_ctz(m)], cycles);
+        group->cycles = end;
+        return;
+    }
+
+    Chip8LanesCheckCode(group);
+
+    for (uint32_t m = group->out; m; m &= m - 1)
+    {
+        int l = __builtin_ctz(m);
+
+        Chip8UpdateTimers(group->cpu[l]);
+        Chip8LanesLoad(group, l);
+
+        if (group->cpu[l]->halted)
+            group->running &= ~(1u << l);
+        else
+            group->running |= 1u << l;
+    }
+    group->out = 0;
+
+    while (now < end)
+    {
+        if (parked && nextWake <= now)
+        {
+            nextWake = end;
+            for (uint32_t m = parked; m; m &= m - 1)
+            {
+                int l = __builtin_ctz(m);
+
+                if (wake[l] <= now)
+                    parked &= ~(1u << l);
+                else if (wake[l] < nextWake)
+                    nextWake = wake[l];
+            }
+        }
+
+        uint32_t remaining = group->running & ~parked;
+
+        //nothing to run until the next lane wakes, jump there and let the timers catch up
+        if (remaining == 0)
+        {
+            uint64_t skipTo = parked ? nextWake : end;
+
+            Chip8LanesTick(group, skipTo / cyclesPerFrame - now / cyclesPerFrame);
+            now = skipTo;
+            nextFrame = (now / cyclesPerFrame + 1) * cyclesPerFrame;
+            continue;
+        }
+
+        //sort the lanes by pc, each slot of the table holds the lanes at one address
+        int slotCount = 0;
+        unsigned short slotPc[CHIP8_LANES];
+        uint32_t slotMask[CHIP8_LANES];
+        signed char table[64];
+        unsigned short leadPc = group->pc[__builtin_ctz(remaining)];
+        unsigned short apart = 0;
+
+        if (remaining == CHIP8_LANES_ALL)
+        {
+            for (int l = 0; l < CHIP8_LANES; l++)
+                apart |= group->pc[l] ^ leadPc;
+        }
+        else
+        {
+            for (uint32_t m = remaining; m; m &= m - 1)
+                apart |= group->pc[__builtin_ctz(m)] ^ leadPc;
+        }
+
+        if (apart == 0)
+        {
+            //the usual case, every lane is at the same address
+            slotPc[0] = leadPc;
+            slotMask[0] = remaining;
+            slotCount = 1;
+            remaining = 0;
+        }
+        else
+            memset(table, -1, sizeof(table));
+
+        for (uint32_t m = remaining; m; m &= m - 1)
+        {
+            int l = __builtin_ctz(m);
+            int hash = (group->pc[l] >> 1) & 63;
+
+            while (table[hash] >= 0 && slotPc[table[hash]] != group->pc[l])
+                hash = (hash + 1) & 63;
+
+            if (table[hash] < 0)
+            {
+                table[hash] = slotCount;
+                slotPc[slotCount] = group->pc[l];
+                slotMask[slotCount++] = 0;
+            }
+            slotMask[table[hash]] |= 1u << l;
+        }
+
+        for (int slot = 0; slot < slotCount; slot++)
+        {
+            int lead = __builtin_ctz(slotMask[slot]);
+            Chip8CPU *Chip8 = group->cpu[lead];
+            unsigned short pc = group->pc[lead] & 0x0FFF;
+            unsigned char high = Chip8Read(Chip8, pc);
+            unsigned char low = Chip8Read(Chip8, pc + 1);
+            uint32_t mask = slotMask[slot];
+
+            //a lane that has written other code at this address runs in a slot of its own
+            uint32_t other = 0;
+            for (uint32_t m = group->sameCode ? 0 : mask & (mask - 1); m; m &= m - 1)
+            {
+                int l = __builtin_ctz(m);
+                if (Chip8Read(group->cpu[l], pc) != high || Chip8Read(group->cpu[l], pc + 1) != low)
+                    other |= 1u << l;
+            }
+
+            for (mask &= ~other; other; other &= other - 1)
+            {
+                slotPc[slotCount] = group->pc[__builtin_ctz(other)];
+                slotMask[slotCount++] = other & -other;
+            }
+
+            slotsRun++;
+            lanesRun += __builtin_popcount(mask);
+
+            unsigned char op = Chip8->decodeCache[pc];
+            if (op == CHIP8_OP_UNDECODED)
+                op = Chip8->decodeCache[pc] = Chip8DecodeAddress(Chip8, pc);
+
+            if (op == CHIP8_OP_1NNN_IDLE)
+            {
+                //jumps to itself, nothing changes for the rest of the run
+                for (uint32_t m = mask; m; m &= m - 1)
+                    wake[__builtin_ctz(m)] = end;
+                parked |= mask;
+                continue;
+            }
+
+            if (op == CHIP8_OP_FX07_IDLE)
+            {
+                //sit out the whole loops that would still read a non zero DT, see Chip8OpCodeFX07Idle
+                uint64_t frame = now / cyclesPerFrame;
+                uint64_t loopsLeft = (end - now - 1) / 3;
+
+                for (uint32_t m = mask; m; m &= m - 1)
+                {
+                    int l = __builtin_ctz(m);
+                    unsigned char delay = group->delayTimer[l];
+                    uint64_t expires = (frame + delay) * cyclesPerFrame;
+                    uint64_t loops = (expires - now + 2) / 3;
+
+                    if (loops > loopsLeft)
+                        loops = loopsLeft;
+
+                    if (delay == 0 || loops == 0 || Chip8ReadOpcode(group->cpu[l], pc + 2) != Chip8ReadOpcode(Chip8, pc + 2) ||
+                        Chip8ReadOpcode(group->cpu[l], pc + 4) != Chip8ReadOpcode(Chip8, pc + 4))
+                        continue;
+
+                    wake[l] = now + loops * 3;
+                    if (wake[l] < nextWake || !parked)
+                        nextWake = wake[l];
+                    parked |= 1u << l;
+                    mask &= ~(1u << l);
+                }
+
+                if (mask == 0)
+                    continue;
+            }
+
+            unsigned short opcode = (high << 8) | low;
+
+            if (Chip8LanesVector(group, mask, op, opcode, quirks))
+                continue;
+
+            for (uint32_t m = mask; m; m &= m - 1)
+            {
+                int l = __builtin_ctz(m);
+
+                Chip8LanesScalar(group, l, op, opcode, handlers[op], now, end);
+
+                //FX0A with no key down skips the rest of the run, 00FD stops the lane
+                if (group->cpu[l]->halted)
+                    group->running &= ~(1u << l);
+                else if (group->cpu[l]->cycles > now)
+                {
+                    wake[l] = group->cpu[l]->cycles + 1;
+                    if (wake[l] < nextWake || !parked)
+                        nextWake = wake[l];
+                    parked |= 1u << l;
+                }
+            }
+
+            //FX33 and FX55 may have written different values in each lane
+            Chip8LanesCheckCode(group);
+        }
+
+        if (++now == nextFrame)
+        {
+            Chip8LanesTick(group, 1);
+            nextFrame += cyclesPerFrame;
+        }
+    }
+
+    group->cycles = now;
+
+    if (lanesRun < slotsRun * CHIP8_LANES_SPLIT)
+    {
+        group->scalarRuns = CHIP8_LANES_RETRY;
+        for (uint32_t m = group->used; m; m &= m - 1)
+            Chip8LanesCheckOut(group, __builtin_ctz(m));
+    }
+}
+
+/**
+* Creates a set of Chip8CPU objects that are run in groups of CHIP8_LANES
+* The instances start zeroed and reset, ready for Chip8LoadRom.
+*
+* @param count number of Chip8CPU objects
+* @return the lanes, or NULL if they could not be created.
+*/
+Chip8Lanes *Chip8LanesCreate(int count)
+{
+    if (count <= 0)
+        return NULL;
+
+    Chip8Lanes *lanes = (Chip8Lanes *)calloc(1, sizeof(Chip8Lanes));
+    if (!lanes)
+        return NULL;
+
+    lanes->count = count;
+    lanes->groupCount = (count + CHIP8_LANES - 1) / CHIP8_LANES;
+    lanes->instances = (Chip8CPU *)calloc(count, sizeof(Chip8CPU));
+
+    //each register of a group starts on a cache line, so the vector loads are aligned
+    void *groups = NULL;
+    if (posix_memalign(&groups, 64, lanes->groupCount * sizeof(Chip8LaneGroup)) == 0)
+        lanes->groups = (Chip8LaneGroup *)groups;
+
+    if (!lanes->instances || !lanes->groups)
+    {
+        free(lanes->instances);
+        free(lanes->groups);
+        free(lanes);
+        return NULL;
+    }
+
+    memset(lanes->groups, 0, lanes->groupCount * sizeof(Chip8LaneGroup));
+
+    for (int i = 0; i < count; i++)
+    {
+        Chip8LaneGroup *group = &lanes->groups[i / CHIP8_LANES];
+
+        Chip8Reset(&lanes->instances[i]);
+        group->cpu[i % CHIP8_LANES] = &lanes->instances[i];
+        group->used |= 1u << (i % CHIP8_LANES);
+        group->out |= 1u << (i % CHIP8_LANES);
+    }
+
+    return lanes;
+}
+
+/**
+* Frees the lanes and their instances
+*
+* @param lanes Address of the Chip8Lanes object
+* @return Nothing.
+*/
+void Chip8LanesFree(Chip8Lanes *lanes)
+{
+    if (!lanes)
+        return;
+
+    for (int i = 0; i < lanes->count; i++)
+        Chip8Free(&lanes->instances[i]);
+
+    free(lanes->instances);
+    free(lanes->groups);
+    free(lanes);
+}
+
+/**
+* Returns one of the instances, to load a ROM or read its state between runs
+* The lanes keep the registers between runs, they are copied back into the instance here so they can be read
+* and changed, and the instance is read back in at the start of the next run. Only fetch the instances you need.
+*
+* @param lanes Address of the Chip8Lanes object
+* @param index instance number, 0 to count - 1
+* @return Address of the Chip8CPU object.
+*/
+Chip8CPU *Chip8LanesGet(Chip8Lanes *lanes, int index)
+{
+    Chip8LanesCheckOut(&lanes->groups[index / CHIP8_LANES], index % CHIP8_LANES);
+    return &lanes->instances[index];
+}
+
+/**
+* Presses or releases a key on one of the instances between runs, without copying its registers back
+*
+* @param lanes Address of the Chip8Lanes object
+* @param index instance number, 0 to count - 1
+* @param key key number, 0 to 15
+* @param down true if the key is pressed
+* @return Nothing.
+*/
+void Chip8LanesSetKey(Chip8Lanes *lanes, int index, int key, bool down)
+{
+    lanes->instances[index].key[key] = down;
+}
+
+/**
+* Returns the number of instances
+*
+* @param lanes Address of the Chip8Lanes object
+* @return number of instances.
+*/
+int Chip8LanesCount(Chip8Lanes *lanes)
+{
+    return lanes->count;
+}
+
+/**
+* Runs a number of opcodes on every instance that has not halted
+* The instances of a group run together while they are at the same opcode, and one at a time once they split up.
+* A group runs with the quirks, cyclesPerFrame and cycles of its first instance, and every instance of
+* the group ends with the same cycles. The results are the same as Chip8RunCycles on each instance.
+*
+* @param lanes Address of the Chip8Lanes object
+* @param cycles number of opcodes to run on each instance
+* @return Nothing.
+*/
+void Chip8LanesRunCycles(Chip8Lanes *lanes, uint64_t cycles)
+{
+    if (cycles == 0)
+        return;
+
+    for (int i = 0; i < lanes->groupCount; i++)
+        Chip8LanesRunGroup(&lanes->groups[i], cycles);
+}
+
+/**
+* Runs every instance to the end of its group's current 60Hz frame (see Chip8RunFrame)
+*
+* @param lanes Address of the Chip8Lanes object
+* @return Nothing.
+*/
+void Chip8LanesRunFrame(Chip8Lanes *lanes)
+{
+    for (int i = 0; i < lanes->groupCount; i++)
+        Chip8LanesRunGroup(&lanes->groups[i], 0);
+}
@@ -0,0 +1,103 @@
+/**
+* Chip-8 Lanes
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+
+#ifndef CHIP8_LANES_H
+#define CHIP8_LANES_H
+
+#include "Chip8.h"
+
+//instances run together in a group, one byte register of each instance fills a 256-bit vector
+#define CHIP8_LANES 32
+
+//a set of Chip8CPU objects run in lockstep groups, see Chip8Lanes.c
+typedef struct Chip8Lanes Chip8Lanes;
+
+/**
+* Creates a set of Chip8CPU objects that are run in groups of CHIP8_LANES
+* The instances start zeroed and reset, ready for Chip8LoadRom.
+*
+* @param count number of Chip8CPU objects
+* @return the lanes, or NULL if they could not be created.
+*/
+Chip8Lanes *Chip8LanesCreate(int count);
+
+/**
+* Frees the lanes and their instances
+*
+* @param lanes Address of the Chip8Lanes object
+* @return Nothing.
+*/
+void Chip8LanesFree(Chip8Lanes *lanes);
+
+/**
+* Returns one of the instances, to load a ROM or read its state between runs
+* The lanes keep the registers between runs, they are copied back into the instance here so they can be read
+* and changed, and the instance is read back in at the start of the next run. Only fetch the instances you need.
+*
+* @param lanes Address of the Chip8Lanes object
+* @param index instance number, 0 to count - 1
+* @return Address of the Chip8CPU object.
+*/
+Chip8CPU *Chip8LanesGet(Chip8Lanes *lanes, int index);
+
+/**
+* Presses or releases a key on one of the instances between runs, without copying its registers back
+*
+* @param lanes Address of the Chip8Lanes object
+* @param index instance number, 0 to count - 1
+* @param key key number, 0 to 15
+* @param down true if the key is pressed
+* @return Nothing.
+*/
+void Chip8LanesSetKey(Chip8Lanes *lanes, int index, int key, bool down);
+
+/**
+* Returns the number of instances
+*
+* @param lanes Address of the Chip8Lanes object
+* @return number of instances.
+*/
+int Chip8LanesCount(Chip8Lanes *lanes);
+
+/**
+* Runs a number of opcodes on every instance that has not halted
+* The instances of a group run together while they are at the same opcode, and one at a time once they split up.
+* A group runs with the quirks, cyclesPerFrame and cycles of its first instance, and every instance of
+* the group ends with the same cycles. The results are the same as Chip8RunCycles on each instance.
+*
+* @param lanes Address of the Chip8Lanes object
+* @param cycles number of opcodes to run on each instance
+* @return Nothing.
+*/
+void Chip8LanesRunCycles(Chip8Lanes *lanes, uint64_t cycles);
+
+/**
+* Runs every instance to the end of its group's current 60Hz frame (see Chip8RunFrame)
+*
+* @param lanes Address of the Chip8Lanes object
+* @return Nothing.
+*/
+void Chip8LanesRunFrame(Chip8Lanes *lanes);
+
+#endif //header guard CHIP8_LANES_H
@@ -0,0 +1,412 @@
+/**
+* Chip-8 Metrics
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+//the shard of this thread, NULL until it updates a metric
+__thread Chip8MetricsShard *Chip8MetricsLocal = NULL;
+
+//every shard made so far, and the lock held while adding one or adding them up
+static Chip8MetricsShard *Chip8MetricsShards = NULL;
+static pthread_mutex_t Chip8MetricsLock = PTHREAD_MUTEX_INITIALIZER;
+
+//instructions and time of the last scrape, for the instructions per second
+static uint64_t Chip8MetricsLastInstructions = 0;
+static uint64_t Chip8MetricsLastScrape = 0;
+
+//the listener started by Chip8MetricsServe, -1 when there is none
+static int Chip8MetricsSocket = -1;
+static pthread_t Chip8MetricsThread;
+
+//the connection being answered, -1 when there is none, Chip8MetricsStop shuts it down so the thread is not held up
+static int Chip8MetricsClient = -1;
+static pthread_mutex_t Chip8MetricsClientLock = PTHREAD_MUTEX_INITIALIZER;
+
+//percentiles of the timing histograms written by Chip8MetricsWrite
+static const double Chip8MetricsQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+/**
+* Makes the shard of this thread and adds it to the shards a scrape adds up
+*
+* @return the shard, NULL if there was no memory.
+*/
+Chip8MetricsShard *Chip8MetricsRegister(void)
+{
+    Chip8MetricsShard *shard = (Chip8MetricsShard *)calloc(1, sizeof(Chip8MetricsShard));
+    if (shard == NULL)
+        return NULL;
+
+    pthread_mutex_lock(&Chip8MetricsLock);
+    shard->next = Chip8MetricsShards;
+    Chip8MetricsShards = shard;
+    pthread_mutex_unlock(&Chip8MetricsLock);
+
+    Chip8MetricsLocal = shard;
+    return shard;
+}
+
+/**
+* Counts a frame shown by a front end, call it once for each frame shown
+* The time since the last frame is counted into the frame times, and each 60th of a second over one frame
+* is counted as a dropped frame.
+*
+* @param last time of the last frame from Chip8MetricsNow, 0 before the first frame, set to now
+* @return Nothing.
+*/
+void Chip8MetricsFrame(uint64_t *last)
+{
+    Chip8MetricsShard *shard = Chip8MetricsShardGet();
+    uint64_t now = Chip8MetricsNow();
+
+    if (shard == NULL)
+        return;
+
+    Chip8MetricsAdd(&shard->frames, 1);
+    if (*last != 0 && now > *last)
+    {
+        uint64_t elapsed = now - *last;
+        uint64_t frames = (elapsed + CHIP8_METRICS_FRAME_TIME / 2) / CHIP8_METRICS_FRAME_TIME;
+
+        Chip8MetricsTime(&shard->frameTime, elapsed);
+        if (frames > 1)
+            Chip8MetricsAdd(&shard->droppedFrames, frames - 1);
+    }
+
+    *last = now;
+}
+
+/**
+* Adds a histogram of a shard to a total
+*
+* @param total the histogram added to
+* @param histogram the histogram of the shard
+* @return Nothing.
+*/
+static void Chip8MetricsAddHistogram(Chip8MetricsHistogram *total, Chip8MetricsHistogram *histogram)
+{
+    for (int i = 0; i < CHIP8_METRICS_BUCKETS; i++)
+        total->buckets[i] += __atomic_load_n(&histogram->buckets[i], __ATOMIC_RELAXED);
+    total->count += __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+    total->sum += __atomic_load_n(&histogram->sum, __ATOMIC_RELAXED);
+}
+
+/**
+* Returns the smallest time counted into a bucket of a histogram
+*
+* @param bucket the bucket
+* @return the time in nanoseconds.
+*/
+static uint64_t Chip8MetricsBucketStart(int bucket)
+{
+    if (bucket < 4)
+        return bucket;
+    return (uint64_t)(4 + bucket % 4) << (bucket / 4 - 1);
+}
+
+/**
+* Writes a timing histogram as a Prometheus summary in seconds: its percentiles, sum and count
+* The percentiles are the middle of the bucket they fall in, so they are within 13% of the real time.
+*
+* @param file file to write to
+* @param name name of the metric
+* @param help description of the metric
+* @param histogram the histogram
+* @return Nothing.
+*/
+static void Chip8MetricsWriteSummary(FILE *file, const char *name, const char *help, Chip8MetricsHistogram *histogram)
+{
+    fprintf(file, "# HELP %s %s\n", name, help);
+    fprintf(file, "# TYPE %s summary\n", name);
+
+    for (size_t q = 0; q < sizeof(Chip8MetricsQuantiles) / sizeof(Chip8MetricsQuantiles[0]); q++)
+    {
+        double value = 0;
+        uint64_t rank = (uint64_t)(Chip8MetricsQuantiles[q] * histogram->count + 0.999999);
+        uint64_t seen = 0;
+
+        for (int i = 0; i < CHIP8_METRICS_BUCKETS && histogram->count > 0; i++)
+        {
+            seen += histogram->buckets[i];
+            if (seen >= rank)
+            {
+                value = (Chip8MetricsBucketStart(i) + Chip8MetricsBucketStart(i + 1)) / 2.0 / 1e9;
+                break;
+            }
+        }
+
+        fprintf(file, "%s{quantile=\"%g\"} %.9g\n", name, Chip8MetricsQuantiles[q], value);
+    }
+
+    fprintf(file, "%s_sum %.9g\n", name, histogram->sum / 1e9);
+    fprintf(file, "%s_count %llu\n", name, (unsigned long long)histogram->count);
+}
+
+/**
+* Writes a counter in the Prometheus text format
+*
+* @param file file to write to
+* @param name name of the metric
+* @param help description of the metric
+* @param value the count
+* @return Nothing.
+*/
+static void Chip8MetricsWriteCounter(FILE *file, const char *name, const char *help, uint64_t value)
+{
+    fprintf(file, "# HELP %s %s\n", name, help);
+    fprintf(file, "# TYPE %s counter\n", name);
+    fprintf(file, "%s %llu\n", name, (unsigned long long)value);
+}
+
+/**
+* Writes every metric in the Prometheus text format, the shards of all threads added up
+* The instructions per second are taken over the time since the last scrape.
+*
+* @param file file to write to
+* @return Nothing.
+*/
+void Chip8MetricsWrite(FILE *file)
+{
+    Chip8MetricsShard *total = (Chip8MetricsShard *)calloc(1, sizeof(Chip8MetricsShard));
+    if (total == NULL)
+        return;
+
+    pthread_mutex_lock(&Chip8MetricsLock);
+
+    for (Chip8MetricsShard *shard = Chip8MetricsShards; shard != NULL; shard = shard->next)
+    {
+        total->instructions += __atomic_load_n(&shard->instructions, __ATOMIC_RELAXED);
+        total->timerTicks += __atomic_load_n(&shard->timerTicks, __ATOMIC_RELAXED);
+        total->badOpcodes += __atomic_load_n(&shard->badOpcodes, __ATOMIC_RELAXED);
+        total->frames += __atomic_load_n(&shard->frames, __ATOMIC_RELAXED);
+        total->droppedFrames += __atomic_load_n(&shard->droppedFrames, __ATOMIC_RELAXED);
+        Chip8MetricsAddHistogram(&total->frameTime, &shard->frameTime);
+        Chip8MetricsAddHistogram(&total->saveTime, &shard->saveTime);
+        Chip8MetricsAddHistogram(&total->loadTime, &shard->loadTime);
+    }
+
+    uint64_t now = Chip8MetricsNow();
+    double perSecond = 0;
+    if (Chip8MetricsLastScrape != 0 && now > Chip8MetricsLastScrape)
+        perSecond = (total->instructions - Chip8MetricsLastInstructions) * 1e9 / (now - Chip8MetricsLastScrape);
+    Chip8MetricsLastInstructions = total->instructions;
+    Chip8MetricsLastScrape = now;
+
+    pthread_mutex_unlock(&Chip8MetricsLock);
+
+    Chip8MetricsWriteCounter(file, "chip8_instructions_total", "Opcodes run, not counting idle loops that were fast-forwarded.", total->instructions);
+    fprintf(file, "# HELP chip8_instructions_per_second Opcodes run per second since the last scrape.\n");
+    fprintf(file, "# TYPE chip8_instructions_per_second gauge\n");
+    fprintf(file, "chip8_instructions_per_second %.1f\n", perSecond);
+    Chip8MetricsWriteCounter(file, "chip8_frames_total", "Frames rendered.", total->frames);
+    Chip8MetricsWriteCounter(file, "chip8_dropped_frames_total", "Frames missed because a frame took too long.", total->droppedFrames);
+    Chip8MetricsWriteSummary(file, "chip8_frame_seconds", "Time between rendered frames.", &total->frameTime);
+    Chip8MetricsWriteCounter(file, "chip8_timer_ticks_total", "Delay and sound timer ticks.", total->timerTicks);
+    Chip8MetricsWriteCounter(file, "chip8_bad_opcodes_total", "Opcodes that are not valid.", total->badOpcodes);
+    Chip8MetricsWriteSummary(file, "chip8_save_seconds", "Time to save a state.", &total->saveTime);
+    Chip8MetricsWriteSummary(file, "chip8_load_seconds", "Time to load a state.", &total->loadTime);
+
+    free(total);
+}
+
+/**
+* Sends all of a buffer to a connection, without SIGPIPE if the other end has gone
+*
+* @param client the connection
+* @param data bytes to send
+* @param length number of bytes
+* @return false if the connection failed or timed out.
+*/
+static bool Chip8MetricsSend(int client, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t sent = send(client, data, length, MSG_NOSIGNAL);
+        if (sent <= 0)
+            return false;
+
+        data += sent;
+        length -= sent;
+    }
+
+    return true;
+}
+
+/**
+* Answers one connection: reads the request up to the end of its headers, then sends the metrics or a 404
+* The connection times out after CHIP8_METRICS_TIMEOUT seconds, so a client that sends nothing cannot hold up the next scrape.
+*
+* @param client the connection
+* @return Nothing.
+*/
+static void Chip8MetricsAnswer(int client)
+{
+    struct timeval timeout = {CHIP8_METRICS_TIMEOUT, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[CHIP8_METRICS_REQUEST_SIZE];
+    size_t length = 0;
+
+    while (length < sizeof(request) - 1)
+    {
+        ssize_t received = recv(client, request + length, sizeof(request) - 1 - length, 0);
+        if (received <= 0)
+            return;
+
+        length += received;
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL)
+            break;
+    }
+    request[length] = '\0';
+
+    if (strncmp(request, "GET /metrics", 12) != 0 || (request[12] != ' ' && request[12] != '?'))
+    {
+        const char *notFound = "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\nnot found\n";
+        Chip8MetricsSend(client, notFound, strlen(notFound));
+        return;
+    }
+
+    //the metrics are written to memory first and sent from there
+    char *body = NULL;
+    size_t size = 0;
+    FILE *file = open_memstream(&body, &size);
+    if (file == NULL)
+        return;
+
+    Chip8MetricsWrite(file);
+    fclose(file);
+
+    const char *header = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n";
+    if (Chip8MetricsSend(client, header, strlen(header)))
+        Chip8MetricsSend(client, body, size);
+
+    free(body);
+}
+
+/**
+* The listener thread, answers each connection with the metrics until Chip8MetricsStop closes the listener
+*
+* @param data not used
+* @return NULL.
+*/
+static void *Chip8MetricsServerMain(void *data)
+{
+    (void)data;
+
+    while (true)
+    {
+        int client = accept(Chip8MetricsSocket, NULL, NULL);
+        if (client < 0)
+            break;
+
+        pthread_mutex_lock(&Chip8MetricsClientLock);
+        Chip8MetricsClient = client;
+        pthread_mutex_unlock(&Chip8MetricsClientLock);
+
+        Chip8MetricsAnswer(client);
+
+        pthread_mutex_lock(&Chip8MetricsClientLock);
+        Chip8MetricsClient = -1;
+        pthread_mutex_unlock(&Chip8MetricsClientLock);
+
+        close(client);
+    }
+
+    return NULL;
+}
+
+/**
+* Starts a thread answering HTTP requests for /metrics on 127.0.0.1 with Chip8MetricsWrite
+*
+* @param port TCP port to listen on
+* @return false if the listener could not be made, or the emulator was built without CHIP8_METRICS.
+*/
+bool Chip8MetricsServe(int port)
+{
+#ifndef CHIP8_METRICS
+    return false;
+#endif
+
+    if (Chip8MetricsSocket >= 0)
+        return false;
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0)
+        return false;
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    //only this machine can read the metrics
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 16) != 0)
+    {
+        close(listener);
+        return false;
+    }
+
+    Chip8MetricsSocket = listener;
+    if (pthread_create(&Chip8MetricsThread, NULL, Chip8MetricsServerMain, NULL) != 0)
+    {
+        close(listener);
+        Chip8MetricsSocket = -1;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+* Stops the thread started by Chip8MetricsServe and closes the listener
+*
+* @return Nothing.
+*/
+void Chip8MetricsStop(void)
+{
+    if (Chip8MetricsSocket < 0)
+        return;
+
+    //wakes the thread up from accept, which then fails and ends the thread, and from a connection it is answering
+    shutdown(Chip8MetricsSocket, SHUT_RDWR);
+    pthread_mutex_lock(&Chip8MetricsClientLock);
+    if (Chip8MetricsClient >= 0)
+        shutdown(Chip8MetricsClient, SHUT_RDWR);
+    pthread_mutex_unlock(&Chip8MetricsClientLock);
+    pthread_join(Chip8MetricsThread, NULL);
+    close(Chip8MetricsSocket);
+    Chip8MetricsSocket = -1;
+}
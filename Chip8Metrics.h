@@ -0,0 +1,202 @@
+/**
+* Chip-8 Metrics
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_METRICS_H
+#define CHIP8_METRICS_H
+
+#include "Chip8.h"
+#include <stdio.h>
+#include <time.h>
+
+//buckets of a timing histogram, 4 for each power of 2 of nanoseconds up to about 18 minutes
+#define CHIP8_METRICS_BUCKETS       160
+
+//time of a frame at 60 frames a second in nanoseconds, a frame that takes longer misses the frames it runs over
+#define CHIP8_METRICS_FRAME_TIME    16666667
+
+//most bytes of a request read by the metrics listener, and the seconds it waits on a connection before dropping it
+#define CHIP8_METRICS_REQUEST_SIZE  1024
+#define CHIP8_METRICS_TIMEOUT       2
+
+//times in nanoseconds, counted into buckets at most 25% wide so percentiles can be taken from them
+typedef struct
+{
+    uint64_t buckets[CHIP8_METRICS_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+} Chip8MetricsHistogram;
+
+//the metrics updated by one thread, only that thread writes them and a scrape adds up the shards of every thread
+//A shard is made the first time a thread updates a metric and is kept after the thread ends, so its counts are not lost.
+typedef struct Chip8MetricsShard
+{
+    //opcodes run by Chip8RunCycles (not the idle loops that were fast-forwarded), timer ticks (frame boundaries passed) and opcodes that are not valid
+    uint64_t instructions;
+    uint64_t timerTicks;
+    uint64_t badOpcodes;
+
+    //frames shown by a front end, the frames it missed and how long each frame took
+    uint64_t frames;
+    uint64_t droppedFrames;
+    Chip8MetricsHistogram frameTime;
+
+    //how long Chip8SaveState and Chip8LoadState took
+    Chip8MetricsHistogram saveTime;
+    Chip8MetricsHistogram loadTime;
+
+    struct Chip8MetricsShard *next;
+} Chip8MetricsShard;
+
+//the shard of this thread, NULL until it updates a metric
+extern __thread Chip8MetricsShard *Chip8MetricsLocal;
+
+/**
+* Makes the shard of this thread and adds it to the shards a scrape adds up
+*
+* @return the shard, NULL if there was no memory.
+*/
+Chip8MetricsShard *Chip8MetricsRegister(void);
+
+/**
+* Returns the shard of this thread
+*
+* @return the shard, NULL if there was no memory for it.
+*/
+static inline Chip8MetricsShard *Chip8MetricsShardGet(void)
+{
+    Chip8MetricsShard *shard = Chip8MetricsLocal;
+    return shard != NULL ? shard : Chip8MetricsRegister();
+}
+
+/**
+* Adds to a metric of this thread's shard
+* Only this thread writes it, so it is a plain add, the store is atomic so a scrape never reads half of it.
+*
+* @param counter the metric
+* @param n amount to add
+* @return Nothing.
+*/
+static inline void Chip8MetricsAdd(uint64_t *counter, uint64_t n)
+{
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+/**
+* Counts a time into a histogram of this thread's shard
+*
+* @param histogram the histogram
+* @param nanoseconds the time
+* @return Nothing.
+*/
+static inline void Chip8MetricsTime(Chip8MetricsHistogram *histogram, uint64_t nanoseconds)
+{
+    int bucket = 0;
+
+    //4 buckets for each power of 2, picked by the 2 bits under the top bit
+    if (nanoseconds >= 4)
+    {
+        int top = 63 - __builtin_clzll(nanoseconds);
+        bucket = top * 4 + ((nanoseconds >> (top - 2)) & 3) - 4;
+        if (bucket >= CHIP8_METRICS_BUCKETS)
+            bucket = CHIP8_METRICS_BUCKETS - 1;
+    }
+    else
+        bucket = nanoseconds;
+
+    Chip8MetricsAdd(&histogram->buckets[bucket], 1);
+    Chip8MetricsAdd(&histogram->count, 1);
+    Chip8MetricsAdd(&histogram->sum, nanoseconds);
+}
+
+/**
+* Returns the host's monotonic clock
+*
+* @return the clock in nanoseconds.
+*/
+static inline uint64_t Chip8MetricsNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//the metrics are only compiled in when built with -DCHIP8_METRICS, otherwise these are empty
+#ifdef CHIP8_METRICS
+#define CHIP8_METRICS_ADD(metric, n)                                            \
+    do                                                                          \
+    {                                                                           \
+        Chip8MetricsShard *shard_ = Chip8MetricsShardGet();                     \
+        if (shard_ != NULL)                                                     \
+            Chip8MetricsAdd(&shard_->metric, (n));                              \
+    } while (0)
+#define CHIP8_METRICS_START(start)  uint64_t start = Chip8MetricsNow()
+#define CHIP8_METRICS_TIME(metric, start)                                       \
+    do                                                                          \
+    {                                                                           \
+        Chip8MetricsShard *shard_ = Chip8MetricsShardGet();                     \
+        if (shard_ != NULL)                                                     \
+            Chip8MetricsTime(&shard_->metric, Chip8MetricsNow() - (start));     \
+    } while (0)
+#define CHIP8_METRICS_FRAME(last)   Chip8MetricsFrame(&(last))
+#else
+#define CHIP8_METRICS_ADD(metric, n)        do { } while (0)
+#define CHIP8_METRICS_START(start)          do { } while (0)
+#define CHIP8_METRICS_TIME(metric, start)   do { } while (0)
+#define CHIP8_METRICS_FRAME(last)           do { } while (0)
+#endif
+
+/**
+* Counts a frame shown by a front end, call it once for each frame shown
+* The time since the last frame is counted into the frame times, and each 60th of a second over one frame
+* is counted as a dropped frame.
+*
+* @param last time of the last frame from Chip8MetricsNow, 0 before the first frame, set to now
+* @return Nothing.
+*/
+void Chip8MetricsFrame(uint64_t *last);
+
+/**
+* Writes every metric in the Prometheus text format, the shards of all threads added up
+* The instructions per second are taken over the time since the last scrape.
+*
+* @param file file to write to
+* @return Nothing.
+*/
+void Chip8MetricsWrite(FILE *file);
+
+/**
+* Starts a thread answering HTTP requests for /metrics on 127.0.0.1 with Chip8MetricsWrite
+*
+* @param port TCP port to listen on
+* @return false if the listener could not be made, or the emulator was built without CHIP8_METRICS.
+*/
+bool Chip8MetricsServe(int port);
+
+/**
+* Stops the thread started by Chip8MetricsServe and closes the listener
+*
+* @return Nothing.
+*/
+void Chip8MetricsStop(void);
+
+#endif //header guard CHIP8_METRICS_H
@@ -0,0 +1,472 @@
+/**
+* Chip-8 Movie
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Movie.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Chip8Movie
+{
+    //the file being recorded to, NULL when playing
+    FILE *file;
+
+    //value of cycles at the last record, the next record is stored from it
+    uint64_t last;
+
+    //keys at the last record, as a mask with key 0 in bit 0
+    unsigned short keys;
+
+    //the movie being played, and the position of the next record
+    unsigned char *data;
+    size_t size;
+    size_t position;
+
+    //record read but not reached yet while playing: its type, the cycles it is at and its keys or checksum
+    unsigned char pending;
+    uint64_t target;
+    uint32_t value;
+
+    //the end record was reached while playing
+    bool ended;
+
+    //opcodes from the start to the end record
+    uint64_t length;
+};
+
+/**
+* Returns the keys of a machine as a mask with key 0 in bit 0
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return the mask.
+*/
+static unsigned short Chip8MovieKeys(Chip8CPU *Chip8)
+{
+    unsigned short keys = 0;
+
+    for (int i = 0; i < 16; i++)
+        keys |= (Chip8->key[i] != 0) << i;
+
+    return keys;
+}
+
+/**
+* Returns the checksum a movie ends with: the checksum at the end of the machine's Chip8SerializeState state
+* (with opcode set to 0)
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return the checksum.
+*/
+static uint32_t Chip8MovieChecksum(Chip8CPU *Chip8)
+{
+    //opcode is only the opcode being run and the JIT does not keep it up to date, so it is left out
+    unsigned short opcode = Chip8->opcode;
+    Chip8->opcode = 0;
+
+    unsigned char state[CHIP8_STATE_MAX_SIZE];
+    size_t length = Chip8SerializeState(Chip8, state, sizeof(state));
+
+    Chip8->opcode = opcode;
+
+    return state[length - 4] | state[length - 3] << 8 | state[length - 2] << 16 | (uint32_t)state[length - 1] << 24;
+}
+
+/**
+* Writes a number 7 bits per byte, lowest bits first, the top bit of a byte is set when more bytes follow
+*
+* @param file the file to write to
+* @param value the number
+* @return Nothing.
+*/
+static void Chip8MoviePutNumber(FILE *file, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        fputc((value & 0x7F) | 0x80, file);
+        value >>= 7;
+    }
+
+    fputc(value, file);
+}
+
+/**
+* Reads a number written by Chip8MoviePutNumber
+*
+* @param movie Address of the Chip8Movie object, the number is read at position
+* @param value where to store the number
+* @return false if the movie ended in the middle of the number.
+*/
+static bool Chip8MovieGetNumber(Chip8Movie *movie, uint64_t *value)
+{
+    *value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (movie->position >= movie->size)
+            return false;
+
+        unsigned char byte = movie->data[movie->position++];
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+* Reads a little endian number of bytes from the movie
+*
+* @param movie Address of the Chip8Movie object, the number is read at position
+* @param bytes number of bytes
+* @param value where to store the number
+* @return false if the movie ended in the middle of the number.
+*/
+static bool Chip8MovieGetBytes(Chip8Movie *movie, int bytes, uint32_t *value)
+{
+    if (movie->position + bytes > movie->size)
+        return false;
+
+    *value = 0;
+    for (int i = 0; i < bytes; i++)
+        *value |= (uint32_t)movie->data[movie->position++] << (i * 8);
+
+    return true;
+}
+
+/**
+* Starts recording a movie of a machine, its state now is the start of the movie
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write the movie to
+* @return the movie, or NULL if the file could not be written.
+*/
+Chip8Movie *Chip8MovieRecord(Chip8CPU *Chip8, char *filename)
+{
+    Chip8Movie *movie = (Chip8Movie *)calloc(1, sizeof(Chip8Movie));
+    if (movie == NULL)
+        return NULL;
+
+    movie->file = fopen(filename, "wb");
+    if (!movie->file)
+    {
+        free(movie);
+        return NULL;
+    }
+
+    fwrite(CHIP8_MOVIE_MAGIC, 1, 4, movie->file);
+    fputc(CHIP8_MOVIE_VERSION, movie->file);
+
+    Chip8MovieSync(movie, Chip8);
+
+    return movie;
+}
+
+/**
+* Records the keys of the machine if they changed, call it before every Chip8RunCycles or Chip8RunFrame
+* The keys are stored with the number of opcodes run so far, so the player presses them at exactly the same opcode.
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8MovieInput(Chip8Movie *movie, Chip8CPU *Chip8)
+{
+    //the machine went back without a Chip8MovieSync, store it whole so the movie still plays the same
+    if (Chip8->cycles < movie->last)
+    {
+        Chip8MovieSync(movie, Chip8);
+        return;
+    }
+
+    unsigned short keys = Chip8MovieKeys(Chip8);
+    if (keys == movie->keys)
+        return;
+
+    fputc(CHIP8_MOVIE_KEYS, movie->file);
+    Chip8MoviePutNumber(movie->file, Chip8->cycles - movie->last);
+    fputc(keys & 0xFF, movie->file);
+    fputc(keys >> 8, movie->file);
+
+    movie->last = Chip8->cycles;
+    movie->keys = keys;
+}
+
+/**
+* Records the whole state of the machine, call it after the machine was changed by something other than
+* running it (a loaded state, rewinding or the debugger)
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8MovieSync(Chip8Movie *movie, Chip8CPU *Chip8)
+{
+    unsigned char state[CHIP8_STATE_MAX_SIZE];
+    size_t length = Chip8SerializeState(Chip8, state, sizeof(state));
+
+    fputc(CHIP8_MOVIE_STATE, movie->file);
+    fputc(length & 0xFF, movie->file);
+    fputc(length >> 8, movie->file);
+    fwrite(state, 1, length, movie->file);
+
+    movie->last = Chip8->cycles;
+    movie->keys = Chip8MovieKeys(Chip8);
+}
+
+/**
+* Ends a recording: writes the end of the movie with a checksum of the machine, closes the file and frees the movie
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @return false if the file could not be written.
+*/
+bool Chip8MovieStop(Chip8Movie *movie, Chip8CPU *Chip8)
+{
+    if (Chip8->cycles < movie->last)
+        Chip8MovieSync(movie, Chip8);
+
+    uint32_t checksum = Chip8MovieChecksum(Chip8);
+
+    fputc(CHIP8_MOVIE_END, movie->file);
+    Chip8MoviePutNumber(movie->file, Chip8->cycles - movie->last);
+    for (int i = 0; i < 4; i++)
+        fputc((checksum >> (i * 8)) & 0xFF, movie->file);
+
+    bool written = !ferror(movie->file);
+    if (fclose(movie->file) != 0)
+        written = false;
+
+    free(movie);
+
+    return written;
+}
+
+/**
+* Reads the next record of a movie, states are loaded into the machine straight away
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object, NULL to only check the record
+* @return false if the movie is damaged or has no more records.
+*/
+static bool Chip8MovieNext(Chip8Movie *movie, Chip8CPU *Chip8)
+{
+    if (movie->position >= movie->size)
+        return false;
+
+    unsigned char type = movie->data[movie->position++];
+    uint64_t cycles;
+    uint32_t length;
+
+    switch (type)
+    {
+        case CHIP8_MOVIE_STATE:
+            if (!Chip8MovieGetBytes(movie, 2, &length) || movie->position + length > movie->size)
+                return false;
+
+            if (Chip8 != NULL && !Chip8DeserializeState(Chip8, movie->data + movie->position, length))
+                return false;
+
+            movie->position += length;
+            movie->pending = CHIP8_MOVIE_STATE;
+            if (Chip8 != NULL)
+                movie->last = Chip8->cycles;
+            return true;
+
+        case CHIP8_MOVIE_KEYS:
+        case CHIP8_MOVIE_END:
+            if (!Chip8MovieGetNumber(movie, &cycles) || !Chip8MovieGetBytes(movie, type == CHIP8_MOVIE_KEYS ? 2 : 4, &movie->value))
+                return false;
+
+            movie->pending = type;
+            movie->target = movie->last + cycles;
+            return true;
+    }
+
+    return false;
+}
+
+/**
+* Loads a movie to play it back
+*
+* @param filename the movie file
+* @return the movie, or NULL if the file could not be read or is not a movie.
+*/
+Chip8Movie *Chip8MovieOpen(char *filename)
+{
+    FILE *file;
+    file = fopen(filename, "rb");
+
+    if (!file)
+        return NULL;
+
+    Chip8Movie *movie = (Chip8Movie *)calloc(1, sizeof(Chip8Movie));
+    if (movie == NULL)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    //read the whole file, playing it back then needs no more file reads
+    size_t capacity = 0;
+    while (!feof(file))
+    {
+        if (movie->size == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 65536;
+            unsigned char *data = (unsigned char *)realloc(movie->data, capacity);
+            if (data == NULL)
+                break;
+            movie->data = data;
+        }
+
+        movie->size += fread(movie->data + movie->size, 1, capacity - movie->size, file);
+        if (ferror(file))
+            break;
+    }
+
+    bool read = feof(file);
+    fclose(file);
+
+    //it must start with a state, so the machine starts where the recording did
+    if (!read || movie->size < 6 || memcmp(movie->data, CHIP8_MOVIE_MAGIC, 4) != 0 || movie->data[4] != CHIP8_MOVIE_VERSION ||
+        movie->data[5] != CHIP8_MOVIE_STATE)
+    {
+        Chip8MovieFree(movie);
+        return NULL;
+    }
+
+    //walk the records once to check them and add up the length
+    movie->position = 5;
+    while (Chip8MovieNext(movie, NULL))
+    {
+        if (movie->pending != CHIP8_MOVIE_STATE)
+            movie->length += movie->target - movie->last;
+
+        if (movie->pending == CHIP8_MOVIE_END)
+            break;
+    }
+
+    if (movie->pending != CHIP8_MOVIE_END)
+        movie->length = 0;
+
+    movie->position = 5;
+    movie->pending = 0;
+    movie->last = 0;
+
+    return movie;
+}
+
+/**
+* Plays a movie on a machine: runs up to a number of opcodes, setting the state and keys as they were recorded
+* The first call puts the machine in the state the movie starts with. The backend of the machine is not changed,
+* so a movie can be played back on any backend.
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run, the movie stops early at its end
+* @return false once the movie has ended (or is damaged).
+*/
+bool Chip8MoviePlay(Chip8Movie *movie, Chip8CPU *Chip8, uint64_t cycles)
+{
+    while (!movie->ended)
+    {
+        //the next record, a state is loaded straight away
+        if (movie->pending == 0 || movie->pending == CHIP8_MOVIE_STATE)
+        {
+            if (!Chip8MovieNext(movie, Chip8))
+            {
+                movie->ended = true;
+                movie->pending = 0;
+                break;
+            }
+            continue;
+        }
+
+        //run up to the record, or as far as asked
+        uint64_t run = movie->target - Chip8->cycles;
+        if (run > cycles)
+        {
+            if (cycles > 0)
+                Chip8RunCycles(Chip8, cycles);
+            return true;
+        }
+
+        if (run > 0)
+            Chip8RunCycles(Chip8, run);
+        cycles -= run;
+
+        movie->last = movie->target;
+
+        if (movie->pending == CHIP8_MOVIE_END)
+        {
+            movie->ended = true;
+            break;
+        }
+
+        for (int i = 0; i < 16; i++)
+            Chip8->key[i] = (movie->value >> i) & 1;
+        movie->pending = 0;
+    }
+
+    return false;
+}
+
+/**
+* Checks that a movie that was played to its end left the machine in the same state as the recording
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @return true if the movie ended and the state matches.
+*/
+bool Chip8MovieMatches(Chip8Movie *movie, Chip8CPU *Chip8)
+{
+    return movie->ended && movie->pending == CHIP8_MOVIE_END && movie->value == Chip8MovieChecksum(Chip8);
+}
+
+/**
+* Returns the number of opcodes in a movie, from the start to the end record
+*
+* @param movie Address of the Chip8Movie object
+* @return number of opcodes, 0 if the movie has no end.
+*/
+uint64_t Chip8MovieLength(Chip8Movie *movie)
+{
+    return movie->length;
+}
+
+/**
+* Frees a movie opened with Chip8MovieOpen
+*
+* @param movie Address of the Chip8Movie object
+* @return Nothing.
+*/
+void Chip8MovieFree(Chip8Movie *movie)
+{
+    if (movie == NULL)
+        return;
+
+    free(movie->data);
+    free(movie);
+}
@@ -0,0 +1,128 @@
+/**
+* Chip-8 Movie
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_MOVIE_H
+#define CHIP8_MOVIE_H
+
+#include "Chip8.h"
+
+/*
+ Movie files start with CHIP8_MOVIE_MAGIC and a version byte, followed by records that start with a type byte:
+ CHIP8_MOVIE_STATE  2 byte length and a Chip8SerializeState state, the machine is set to it (always the first record)
+ CHIP8_MOVIE_KEYS   opcodes run since the last record (a 7 bits per byte number) and the 16 keys as a 2 byte mask
+ CHIP8_MOVIE_END    opcodes run since the last record and the checksum of the state the recording ended on
+ Numbers are little endian.
+*/
+#define CHIP8_MOVIE_MAGIC   "C8MV"
+#define CHIP8_MOVIE_VERSION 1
+#define CHIP8_MOVIE_STATE   'S'
+#define CHIP8_MOVIE_KEYS    'K'
+#define CHIP8_MOVIE_END     'E'
+
+//a movie being recorded or played, see Chip8Movie.c
+typedef struct Chip8Movie Chip8Movie;
+
+/**
+* Starts recording a movie of a machine, its state now is the start of the movie
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write the movie to
+* @return the movie, or NULL if the file could not be written.
+*/
+Chip8Movie *Chip8MovieRecord(Chip8CPU *Chip8, char *filename);
+
+/**
+* Records the keys of the machine if they changed, call it before every Chip8RunCycles or Chip8RunFrame
+* The keys are stored with the number of opcodes run so far, so the player presses them at exactly the same opcode.
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8MovieInput(Chip8Movie *movie, Chip8CPU *Chip8);
+
+/**
+* Records the whole state of the machine, call it after the machine was changed by something other than
+* running it (a loaded state, rewinding or the debugger)
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8MovieSync(Chip8Movie *movie, Chip8CPU *Chip8);
+
+/**
+* Ends a recording: writes the end of the movie with a checksum of the machine, closes the file and frees the movie
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @return false if the file could not be written.
+*/
+bool Chip8MovieStop(Chip8Movie *movie, Chip8CPU *Chip8);
+
+/**
+* Loads a movie to play it back
+*
+* @param filename the movie file
+* @return the movie, or NULL if the file could not be read or is not a movie.
+*/
+Chip8Movie *Chip8MovieOpen(char *filename);
+
+/**
+* Plays a movie on a machine: runs up to a number of opcodes, setting the state and keys as they were recorded
+* The first call puts the machine in the state the movie starts with. The backend of the machine is not changed,
+* so a movie can be played back on any backend.
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run, the movie stops early at its end
+* @return false once the movie has ended (or is damaged).
+*/
+bool Chip8MoviePlay(Chip8Movie *movie, Chip8CPU *Chip8, uint64_t cycles);
+
+/**
+* Checks that a movie that was played to its end left the machine in the same state as the recording
+*
+* @param movie Address of the Chip8Movie object
+* @param Chip8 Address of the Chip8CPU object
+* @return true if the movie ended and the state matches.
+*/
+bool Chip8MovieMatches(Chip8Movie *movie, Chip8CPU *Chip8);
+
+/**
+* Returns the number of opcodes in a movie, from the start to the end record
+*
+* @param movie Address of the Chip8Movie object
+* @return number of opcodes, 0 if the movie has no end.
+*/
+uint64_t Chip8MovieLength(Chip8Movie *movie);
+
+/**
+* Frees a movie opened with Chip8MovieOpen
+*
+* @param movie Address of the Chip8Movie object
+* @return Nothing.
+*/
+void Chip8MovieFree(Chip8Movie *movie);
+
+#endif //header guard CHIP8_MOVIE_H
@@ -0,0 +1,376 @@
+/**
+* Chip-8 Pool
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Pool.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//size of a cache line, each instance starts on its own line so workers never share one
+#define CHIP8_POOL_ALIGN    64
+
+//jobs the workers can be given by Chip8PoolStart
+#define CHIP8_POOL_INIT     0   //zero and reset the instances
+#define CHIP8_POOL_CYCLES   1   //Chip8RunCycles on the instances
+#define CHIP8_POOL_FRAME    2   //Chip8RunFrame on the instances
+#define CHIP8_POOL_QUIT     3   //leave the worker thread
+
+typedef struct
+{
+    struct Chip8Pool *pool;
+
+    //the worker runs instances first to first + count - 1
+    int first;
+    int count;
+
+    //position of the worker, used to pick its core
+    int number;
+
+    pthread_t thread;
+} Chip8PoolWorker;
+
+struct Chip8Pool
+{
+    //count instances, each stride bytes apart in a CHIP8_POOL_ALIGN aligned block
+    unsigned char *instances;
+    size_t stride;
+    int count;
+
+    //CHIP8_STATUS_* bits of each instance
+    unsigned char *status;
+
+    Chip8PoolWorker *workers;
+    int workerCount;
+
+    //the job being run, started by Chip8PoolStart when generation is counted up
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;
+    int running;
+    int job;
+    uint64_t cycles;
+};
+
+/**
+* Pins the calling worker thread to one of the cores the process is allowed to run on
+* Does nothing on hosts without pthread_setaffinity_np
+*
+* @param number position of the worker
+* @return Nothing.
+*/
+static void Chip8PoolPin(int number)
+{
+#ifdef __linux__
+    cpu_set_t allowed;
+    cpu_set_t core;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0)
+        return;
+
+    //take the number'th allowed core, going round again if there are more workers than cores
+    int skip = number % CPU_COUNT(&allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, &allowed) || skip-- > 0)
+            continue;
+
+        CPU_ZERO(&core);
+        CPU_SET(cpu, &core);
+        pthread_setaffinity_np(pthread_self(), sizeof(core), &core);
+        return;
+    }
+#else
+    (void)number;
+#endif
+}
+
+/**
+* Runs a job on a range of instances and sets their status
+*
+* @param pool Address of the Chip8Pool object
+* @param first first instance to run
+* @param count number of instances to run
+* @param job CHIP8_POOL_* job
+* @param cycles opcodes to run for CHIP8_POOL_CYCLES
+* @return Nothing.
+*/
+static void Chip8PoolRunRange(Chip8Pool *pool, int first, int count, int job, uint64_t cycles)
+{
+    for (int i = first; i < first + count; i++)
+    {
+        Chip8CPU *Chip8 = Chip8PoolGet(pool, i);
+
+        if (job == CHIP8_POOL_INIT)
+        {
+            memset(Chip8, 0, sizeof(Chip8CPU));
+            Chip8Reset(Chip8);
+            Chip8->dirtyRows = 0;
+        }
+        else
+        {
+            Chip8->dirtyRows = 0;
+
+            if (!Chip8->halted)
+            {
+                if (job == CHIP8_POOL_FRAME)
+                    Chip8RunFrame(Chip8);
+                else
+                    Chip8RunCycles(Chip8, cycles);
+            }
+        }
+
+        pool->status[i] = (Chip8->halted ? CHIP8_STATUS_HALTED : 0) |
+                          (Chip8->waitingForKey ? CHIP8_STATUS_WAITING_KEY : 0) |
+                          (Chip8->dirtyRows != 0 ? CHIP8_STATUS_SCREEN_CHANGED : 0);
+    }
+}
+
+/**
+* Worker thread, waits for each job from Chip8PoolStart and runs it on its range of instances
+*
+* @param arg Address of the Chip8PoolWorker object
+* @return NULL.
+*/
+static void *Chip8PoolWorkerMain(void *arg)
+{
+    Chip8PoolWorker *worker = (Chip8PoolWorker *)arg;
+    Chip8Pool *pool = worker->pool;
+    unsigned long generation = 0;
+
+    Chip8PoolPin(worker->number);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == generation)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        generation = pool->generation;
+        int job = pool->job;
+        uint64_t cycles = pool->cycles;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (job == CHIP8_POOL_QUIT)
+            return NULL;
+
+        Chip8PoolRunRange(pool, worker->first, worker->count, job, cycles);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0)
+            pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+* Gives every worker a job and waits for all of them to finish it
+*
+* @param pool Address of the Chip8Pool object
+* @param job CHIP8_POOL_* job
+* @param cycles opcodes to run for CHIP8_POOL_CYCLES
+* @return Nothing.
+*/
+static void Chip8PoolStart(Chip8Pool *pool, int job, uint64_t cycles)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->cycles = cycles;
+    pool->running = pool->workerCount;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+
+    if (job != CHIP8_POOL_QUIT)
+    {
+        while (pool->running > 0)
+            pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+* Stops the workers that were started and frees the pool
+*
+* @param pool Address of the Chip8Pool object
+* @return Nothing.
+*/
+static void Chip8PoolDestroy(Chip8Pool *pool)
+{
+    if (pool->workerCount > 0)
+    {
+        Chip8PoolStart(pool, CHIP8_POOL_QUIT, 0);
+        for (int i = 0; i < pool->workerCount; i++)
+            pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool->status);
+    free(pool->instances);
+    free(pool);
+}
+
+/**
+* Creates a pool of Chip8CPU objects and the worker threads that run them
+* The instances are zeroed and reset by the worker that runs them, so their memory is local to its core.
+* Each worker is pinned to a core and runs a fixed, contiguous range of the instances.
+*
+* @param count number of Chip8CPU objects
+* @param threads number of worker threads, 0 for one per online core
+* @return the pool, or NULL if it could not be created.
+*/
+Chip8Pool *Chip8PoolCreate(int count, int threads)
+{
+    if (count <= 0)
+        return NULL;
+
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0)
+        threads = 1;
+    if (threads > count)
+        threads = count;
+
+    Chip8Pool *pool = (Chip8Pool *)calloc(1, sizeof(Chip8Pool));
+    if (!pool)
+        return NULL;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    pool->count = count;
+    pool->stride = (sizeof(Chip8CPU) + CHIP8_POOL_ALIGN - 1) & ~(size_t)(CHIP8_POOL_ALIGN - 1);
+    pool->status = (unsigned char *)calloc(count, 1);
+    pool->workers = (Chip8PoolWorker *)calloc(threads, sizeof(Chip8PoolWorker));
+
+    void *instances = NULL;
+    if (posix_memalign(&instances, CHIP8_POOL_ALIGN, pool->stride * count) == 0)
+        pool->instances = (unsigned char *)instances;
+
+    if (!pool->status || !pool->workers || !pool->instances)
+    {
+        Chip8PoolDestroy(pool);
+        return NULL;
+    }
+
+    for (int i = 0; i < threads; i++)
+    {
+        Chip8PoolWorker *worker = &pool->workers[i];
+
+        worker->pool = pool;
+        worker->number = i;
+        worker->first = (int)((long long)count * i / threads);
+        worker->count = (int)((long long)count * (i + 1) / threads) - worker->first;
+
+        if (pthread_create(&worker->thread, NULL, Chip8PoolWorkerMain, worker) != 0)
+        {
+            Chip8PoolDestroy(pool);
+            return NULL;
+        }
+        pool->workerCount++;
+    }
+
+    Chip8PoolStart(pool, CHIP8_POOL_INIT, 0);
+
+    return pool;
+}
+
+/**
+* Stops the worker threads and frees the pool and its instances (and their memory pages and JIT caches)
+*
+* @param pool Address of the Chip8Pool object
+* @return Nothing.
+*/
+void Chip8PoolFree(Chip8Pool *pool)
+{
+    if (!pool)
+        return;
+
+    for (int i = 0; i < pool->count; i++)
+        Chip8Free(Chip8PoolGet(pool, i));
+
+    Chip8PoolDestroy(pool);
+}
+
+/**
+* Returns one of the instances, to load a ROM, set the backend or quirks, or press keys between runs
+* The instances must not be touched while Chip8PoolRunCycles or Chip8PoolRunFrame is running.
+*
+* @param pool Address of the Chip8Pool object
+* @param index instance number, 0 to count - 1
+* @return Address of the Chip8CPU object.
+*/
+Chip8CPU *Chip8PoolGet(Chip8Pool *pool, int index)
+{
+    return (Chip8CPU *)(pool->instances + pool->stride * index);
+}
+
+/**
+* Returns the number of instances in the pool
+*
+* @param pool Address of the Chip8Pool object
+* @return number of instances.
+*/
+int Chip8PoolCount(Chip8Pool *pool)
+{
+    return pool->count;
+}
+
+/**
+* Runs a number of opcodes on every instance that has not halted, and waits for all of them to finish
+*
+* @param pool Address of the Chip8Pool object
+* @param cycles number of opcodes to run on each instance
+* @return Nothing.
+*/
+void Chip8PoolRunCycles(Chip8Pool *pool, uint64_t cycles)
+{
+    Chip8PoolStart(pool, CHIP8_POOL_CYCLES, cycles);
+}
+
+/**
+* Runs every instance that has not halted to the end of its current 60Hz frame (see Chip8RunFrame)
+*
+* @param pool Address of the Chip8Pool object
+* @return Nothing.
+*/
+void Chip8PoolRunFrame(Chip8Pool *pool)
+{
+    Chip8PoolStart(pool, CHIP8_POOL_FRAME, 0);
+}
+
+/**
+* Returns the CHIP8_STATUS_* bits of a instance after the last run
+*
+* @param pool Address of the Chip8Pool object
+* @param index instance number, 0 to count - 1
+* @return CHIP8_STATUS_* bits.
+*/
+unsigned char Chip8PoolStatus(Chip8Pool *pool, int index)
+{
+    return pool->status[index];
+}
@@ -0,0 +1,100 @@
+/**
+* Chip-8 Pool
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_POOL_H
+#define CHIP8_POOL_H
+
+#include "Chip8.h"
+
+//bits returned by Chip8PoolStatus
+#define CHIP8_STATUS_HALTED         1   //the program ran 00FD and has stopped
+#define CHIP8_STATUS_WAITING_KEY    2   //FX0A is waiting for a key
+#define CHIP8_STATUS_SCREEN_CHANGED 4   //the display changed during the last run
+
+//a set of Chip8CPU objects and the worker threads that run them, see Chip8Pool.c
+typedef struct Chip8Pool Chip8Pool;
+
+/**
+* Creates a pool of Chip8CPU objects and the worker threads that run them
+* The instances are zeroed and reset by the worker that runs them, so their memory is local to its core.
+* Each worker is pinned to a core and runs a fixed, contiguous range of the instances.
+*
+* @param count number of Chip8CPU objects
+* @param threads number of worker threads, 0 for one per online core
+* @return the pool, or NULL if it could not be created.
+*/
+Chip8Pool *Chip8PoolCreate(int count, int threads);
+
+/**
+* Stops the worker threads and frees the pool and its instances (and their memory pages and JIT caches)
+*
+* @param pool Address of the Chip8Pool object
+* @return Nothing.
+*/
+void Chip8PoolFree(Chip8Pool *pool);
+
+/**
+* Returns one of the instances, to load a ROM, set the backend or quirks, or press keys between runs
+* The instances must not be touched while Chip8PoolRunCycles or Chip8PoolRunFrame is running.
+*
+* @param pool Address of the Chip8Pool object
+* @param index instance number, 0 to count - 1
+* @return Address of the Chip8CPU object.
+*/
+Chip8CPU *Chip8PoolGet(Chip8Pool *pool, int index);
+
+/**
+* Returns the number of instances in the pool
+*
+* @param pool Address of the Chip8Pool object
+* @return number of instances.
+*/
+int Chip8PoolCount(Chip8Pool *pool);
+
+/**
+* Runs a number of opcodes on every instance that has not halted, and waits for all of them to finish
+*
+* @param pool Address of the Chip8Pool object
+* @param cycles number of opcodes to run on each instance
+* @return Nothing.
+*/
+void Chip8PoolRunCycles(Chip8Pool *pool, uint64_t cycles);
+
+/**
+* Runs every instance that has not halted to the end of its current 60Hz frame (see Chip8RunFrame)
+*
+* @param pool Address of the Chip8Pool object
+* @return Nothing.
+*/
+void Chip8PoolRunFrame(Chip8Pool *pool);
+
+/**
+* Returns the CHIP8_STATUS_* bits of a instance after the last run
+*
+* @param pool Address of the Chip8Pool object
+* @param index instance number, 0 to count - 1
+* @return CHIP8_STATUS_* bits.
+*/
+unsigned char Chip8PoolStatus(Chip8Pool *pool, int index);
+
+#endif //header guard CHIP8_POOL_H
@@ -0,0 +1,228 @@
+/**
+* Chip-8 Profiler
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Profile.h"
+#include "Chip8Jit.h"
+#include "Chip8Disassembler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//a loop found by Chip8WriteProfile, a jump at end back to start
+typedef struct
+{
+    unsigned short start;
+    unsigned short end;
+    uint64_t ticks;
+} Chip8ProfileLoop;
+
+/**
+* Returns the profile of a instance
+* The profile is kept from the first Chip8Reset until Chip8ClearProfile or Chip8Free.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return the profile, NULL if the emulator was built without CHIP8_PROFILE.
+*/
+Chip8Profile *Chip8GetProfile(Chip8CPU *Chip8)
+{
+    if (Chip8->profile == NULL)
+        return NULL;
+
+    //the JIT counts whole blocks and adds them up here
+    Chip8JitCountStats(Chip8);
+
+    return Chip8->profile;
+}
+
+/**
+* Sets the profile of a instance back to 0
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8ClearProfile(Chip8CPU *Chip8)
+{
+    if (Chip8->profile == NULL)
+        return;
+
+    Chip8JitCountStats(Chip8);
+    memset(Chip8->profile, 0, sizeof(Chip8Profile));
+    Chip8->profile->countdown = CHIP8_PROFILE_INTERVAL;
+}
+
+/**
+* Writes the name of a address as the closest lable at or before it plus a offset
+*
+* @param lables lables read by Chip8AssReadLables, or NULL
+* @param address the address
+* @param buffer at least 40 bytes for the name, empty if there is no lable before the address
+* @return Nothing.
+*/
+static void Chip8ProfileLable(Chip8AssContext *lables, int address, char *buffer)
+{
+    int best = -1;
+
+    buffer[0] = '\0';
+    if (lables == NULL)
+        return;
+
+    for (int i = 0; i < lables->addressPointersCount; i++)
+    {
+        int at = lables->addressPointers[i].address;
+        if (at <= address && (best < 0 || at > lables->addressPointers[best].address))
+            best = i;
+    }
+
+    if (best < 0)
+        return;
+
+    if (lables->addressPointers[best].address == address)
+        snprintf(buffer, 40, "%.25s", lables->addressPointers[best].name);
+    else
+        snprintf(buffer, 40, "%.25s+%X", lables->addressPointers[best].name, address - lables->addressPointers[best].address);
+}
+
+/**
+* Tells if more time was spent at one address than another, or it ran more often when the times are the same
+*
+* @param profile the profile
+* @param address the address
+* @param other the address to compare it with
+* @return true if address is hotter than other.
+*/
+static bool Chip8ProfileHotter(Chip8Profile *profile, int address, int other)
+{
+    if (profile->ticks[address] != profile->ticks[other])
+        return profile->ticks[address] > profile->ticks[other];
+    return profile->runs[address] > profile->runs[other];
+}
+
+/**
+* Writes a report of where a instance spent its time to a text file: the hottest addresses, then the hottest
+* loops (a jump back and the opcodes it jumps over). Each address is shown with its disassembly, and with
+* the lable it is at when the lables of the assembler source are given.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write
+* @param lables lables read by Chip8AssReadLables, or NULL
+* @return false if there is no profile (built without CHIP8_PROFILE) or the file could not be written.
+*/
+bool Chip8WriteProfile(Chip8CPU *Chip8, char *filename, Chip8AssContext *lables)
+{
+    Chip8Profile *profile = Chip8GetProfile(Chip8);
+
+    if (profile == NULL)
+        return false;
+
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+        return false;
+
+    uint64_t runs = 0, ticks = 0;
+    for (int address = 0; address < 4096; address++)
+    {
+        runs += profile->runs[address];
+        ticks += profile->ticks[address];
+    }
+    double total = ticks > 0 ? (double)ticks : 1;
+
+    fprintf(file, "opcodes run: %llu\n", (unsigned long long)runs);
+    fprintf(file, "host clock ticks: %llu (1 opcode in %d timed)\n\n", (unsigned long long)ticks * CHIP8_PROFILE_INTERVAL, CHIP8_PROFILE_INTERVAL);
+
+    //the hottest addresses by time, then by runs for the ones that were never timed
+    unsigned short top[CHIP8_PROFILE_TOP_ADDRESSES];
+    int count = 0;
+
+    for (int address = 0; address < 4096; address++)
+    {
+        if (profile->runs[address] == 0 || (count == CHIP8_PROFILE_TOP_ADDRESSES && !Chip8ProfileHotter(profile, address, top[count - 1])))
+            continue;
+
+        int i = count < CHIP8_PROFILE_TOP_ADDRESSES ? count++ : count - 1;
+        for (; i > 0 && Chip8ProfileHotter(profile, address, top[i - 1]); i--)
+            top[i] = top[i - 1];
+        top[i] = address;
+    }
+
+    fprintf(file, "%-7s %-20s %16s %8s %10s  %s\n", "address", "lable", "runs", "time", "ticks/run", "opcode");
+
+    for (int i = 0; i < count; i++)
+    {
+        char lable[40], name[50];
+        int address = top[i];
+        unsigned short opcode = Chip8ReadOpcode(Chip8, address);
+
+        Chip8ProfileLable(lables, address, lable);
+        Chip8Disassemble(opcode, name);
+
+        fprintf(file, "%03X     %-20s %16llu %7.2f%% %10.1f  %04X %s\n", address, lable, (unsigned long long)profile->runs[address],
+            profile->ticks[address] * 100 / total,
+            profile->runs[address] > 0 ? (double)profile->ticks[address] * CHIP8_PROFILE_INTERVAL / profile->runs[address] : 0.0,
+            opcode, name);
+    }
+
+    //a jump back to a earlier address that has run is taken as the end of a loop, the loop's time is
+    //the time of every address from the target of the jump to the jump
+    Chip8ProfileLoop loops[CHIP8_PROFILE_TOP_LOOPS];
+    count = 0;
+
+    for (int address = 0; address < 4095; address++)
+    {
+        unsigned short opcode = Chip8ReadOpcode(Chip8, address);
+        int target = opcode & 0x0FFF;
+
+        if (profile->runs[address] == 0 || (opcode & 0xF000) != 0x1000 || target > address)
+            continue;
+
+        Chip8ProfileLoop loop = {(unsigned short)target, (unsigned short)address, 0};
+        for (int i = target; i <= address; i++)
+            loop.ticks += profile->ticks[i];
+
+        if (count == CHIP8_PROFILE_TOP_LOOPS && loop.ticks <= loops[count - 1].ticks)
+            continue;
+
+        int i = count < CHIP8_PROFILE_TOP_LOOPS ? count++ : count - 1;
+        for (; i > 0 && loops[i - 1].ticks < loop.ticks; i--)
+            loops[i] = loops[i - 1];
+        loops[i] = loop;
+    }
+
+    fprintf(file, "\n%-9s %-20s %16s %8s %12s\n", "loop", "lable", "iterations", "time", "opcodes/iter");
+
+    for (int i = 0; i < count; i++)
+    {
+        char lable[40];
+        uint64_t iterations = profile->runs[loops[i].end];
+        uint64_t opcodes = 0;
+
+        for (int address = loops[i].start; address <= loops[i].end; address++)
+            opcodes += profile->runs[address];
+
+        Chip8ProfileLable(lables, loops[i].start, lable);
+
+        fprintf(file, "%03X-%03X   %-20s %16llu %7.2f%% %12.1f\n", loops[i].start, loops[i].end, lable, (unsigned long long)iterations,
+            loops[i].ticks * 100 / total, (double)opcodes / iterations);
+    }
+
+    return fclose(file) == 0;
+}
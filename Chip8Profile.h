@@ -0,0 +1,170 @@
+/**
+* Chip-8 Profiler
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_PROFILE_H
+#define CHIP8_PROFILE_H
+
+#include "Chip8.h"
+#include "Chip8Assembler.h"
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//one opcode in this many is timed (one translated block in this many under the JIT)
+#define CHIP8_PROFILE_INTERVAL      64
+
+//hottest addresses and loops listed by Chip8WriteProfile
+#define CHIP8_PROFILE_TOP_ADDRESSES 40
+#define CHIP8_PROFILE_TOP_LOOPS     10
+
+//where a instance spends its time, kept in Chip8->profile when built with CHIP8_PROFILE
+typedef struct Chip8Profile
+{
+    //times the opcode at each address was run
+    uint64_t runs[4096];
+
+    //host clock ticks of the timed opcodes at each address, times CHIP8_PROFILE_INTERVAL this is the time spent there
+    //under the JIT the time of a whole block is given to its first address
+    uint64_t ticks[4096];
+
+    //opcodes left until the next one is timed, and the opcode being timed
+    unsigned int countdown;
+    bool timing;
+    unsigned short timedAddress;
+    uint64_t timedStart;
+} Chip8Profile;
+
+/**
+* Reads the host clock the profile is timed with, the CPU's time stamp counter where there is one
+*
+* @return the clock in ticks.
+*/
+static inline uint64_t Chip8ProfileClock()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+/**
+* Starts or ends the timing of a opcode, called when the countdown reaches 0
+* A timed opcode ends when the next one starts, then the countdown starts over.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param address address of the opcode that is about to run
+* @return Nothing.
+*/
+static inline void Chip8ProfileSample(Chip8CPU *Chip8, unsigned int address)
+{
+    Chip8Profile *profile = Chip8->profile;
+    uint64_t now = Chip8ProfileClock();
+
+    if (profile->timing)
+    {
+        profile->ticks[profile->timedAddress] += now - profile->timedStart;
+        profile->timing = false;
+        profile->countdown = CHIP8_PROFILE_INTERVAL - 1;
+    }
+    else
+    {
+        profile->timedAddress = address & 0x0FFF;
+        profile->timedStart = now;
+        profile->timing = true;
+        profile->countdown = 1;
+    }
+}
+
+/**
+* Ends the timing of a opcode when the backend returns, so the time between runs is not counted
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+static inline void Chip8ProfileStop(Chip8CPU *Chip8)
+{
+    if (Chip8->profile != NULL && Chip8->profile->timing)
+        Chip8ProfileSample(Chip8, 0);
+}
+
+//the profile is only compiled in when built with -DCHIP8_PROFILE, otherwise these are empty
+#ifdef CHIP8_PROFILE
+#define CHIP8_PROFILE_RUN(Chip8, address)                                       \
+    do                                                                          \
+    {                                                                           \
+        Chip8Profile *profile_ = (Chip8)->profile;                              \
+        if (profile_ != NULL)                                                   \
+        {                                                                       \
+            profile_->runs[(address)]++;                                        \
+            if (--profile_->countdown == 0)                                     \
+                Chip8ProfileSample((Chip8), (address));                         \
+        }                                                                       \
+    } while (0)
+#define CHIP8_PROFILE_ADD(Chip8, address, n)                                    \
+    do                                                                          \
+    {                                                                           \
+        if ((Chip8)->profile != NULL)                                           \
+            (Chip8)->profile->runs[(address) & 0x0FFF] += (n);                  \
+    } while (0)
+#define CHIP8_PROFILE_STOP(Chip8)               Chip8ProfileStop(Chip8)
+#else
+#define CHIP8_PROFILE_RUN(Chip8, address)       do { } while (0)
+#define CHIP8_PROFILE_ADD(Chip8, address, n)    do { } while (0)
+#define CHIP8_PROFILE_STOP(Chip8)               do { } while (0)
+#endif
+
+/**
+* Returns the profile of a instance
+* The profile is kept from the first Chip8Reset until Chip8ClearProfile or Chip8Free.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return the profile, NULL if the emulator was built without CHIP8_PROFILE.
+*/
+Chip8Profile *Chip8GetProfile(Chip8CPU *Chip8);
+
+/**
+* Sets the profile of a instance back to 0
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8ClearProfile(Chip8CPU *Chip8);
+
+/**
+* Writes a report of where a instance spent its time to a text file: the hottest addresses, then the hottest
+* loops (a jump back and the opcodes it jumps over). Each address is shown with its disassembly, and with
+* the lable it is at when the lables of the assembler source are given.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write
+* @param lables lables read by Chip8AssReadLables, or NULL
+* @return false if there is no profile (built without CHIP8_PROFILE) or the file could not be written.
+*/
+bool Chip8WriteProfile(Chip8CPU *Chip8, char *filename, Chip8AssContext *lables);
+
+#endif //header guard CHIP8_PROFILE_H
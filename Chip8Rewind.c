@@ -0,0 +1,528 @@
+/**
+* Chip-8 Rewind
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Rewind.h"
+#include <stdlib.h>
+#include <string.h>
+
+//zero runs shorter than this are kept in the literal bytes around them, a run header costs 4 bytes
+#define CHIP8_REWIND_MIN_RUN    4
+
+//the part of a Chip8CPU that is stored for each frame, the caches, pointers and host settings are left out
+typedef struct
+{
+    unsigned char memory[4096];
+    unsigned long long videoMemory[64][2];
+    uint64_t cycles;
+    uint64_t timerCycle;
+    uint64_t random;
+    unsigned short stack[16];
+    unsigned short opcode;
+    unsigned short I;
+    unsigned short pc;
+    unsigned short sp;
+    unsigned char V[16];
+    unsigned char R[8];
+    unsigned char delayTimer;
+    unsigned char soundTimer;
+    bool extendedGraphicsMode;
+    bool playBeep;
+    bool waitingForKey;
+    bool halted;
+} Chip8RewindImage;
+
+//one stored frame
+typedef struct
+{
+    //where the encoded frame is in the snapshot block, and how long it is
+    size_t offset;
+    size_t length;
+
+    //frame number (counted up on every push) of the keyframe it is stored against, its own number for a keyframe
+    uint64_t key;
+} Chip8RewindFrame;
+
+struct Chip8Rewind
+{
+    //ring of frames, count frames starting at first, oldest first
+    Chip8RewindFrame *frames;
+    int capacity;
+    int first;
+    int count;
+
+    //frame number of the newest frame + 1
+    uint64_t pushed;
+
+    //the encoded frames, stored one after the other and wrapping back to 0 when the next one does not fit
+    unsigned char *block;
+    size_t size;
+
+    //the decoded keyframe the newest frames are stored against, and its frame number
+    Chip8RewindImage keyImage;
+    uint64_t keyNumber;
+    bool keyValid;
+
+    //scratch space for encoding and decoding a frame
+    Chip8RewindImage image;
+    unsigned char *encoded;
+};
+
+/**
+* Returns the ring entry of a frame, by its position from the oldest frame
+*
+* @param rewind Address of the Chip8Rewind object
+* @param index 0 for the oldest frame, count - 1 for the newest
+* @return Address of the frame.
+*/
+static Chip8RewindFrame *Chip8RewindAt(Chip8Rewind *rewind, int index)
+{
+    return &rewind->frames[(rewind->first + index) % rewind->capacity];
+}
+
+/**
+* Copies the stored part of a machine into a image
+*
+* @param image Address of the image to fill in
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+static void Chip8RewindCapture(Chip8RewindImage *image, Chip8CPU *Chip8)
+{
+    //zeroed so the padding is the same in every image
+    memset(image, 0, sizeof(Chip8RewindImage));
+
+    for (int i = 0; i < CHIP8_PAGE_COUNT; i++)
+        memcpy(image->memory + i * CHIP8_PAGE_SIZE, Chip8->pages[i]->data, CHIP8_PAGE_SIZE);
+
+    memcpy(image->videoMemory, Chip8->videoMemory, sizeof(image->videoMemory));
+    memcpy(image->stack, Chip8->stack, sizeof(image->stack));
+    memcpy(image->V, Chip8->V, sizeof(image->V));
+    memcpy(image->R, Chip8->R, sizeof(image->R));
+    image->cycles = Chip8->cycles;
+    image->timerCycle = Chip8->timerCycle;
+    image->random = Chip8->random;
+    image->opcode = Chip8->opcode;
+    image->I = Chip8->I;
+    image->pc = Chip8->pc;
+    image->sp = Chip8->sp;
+    image->delayTimer = Chip8->delayTimer;
+    image->soundTimer = Chip8->soundTimer;
+    image->extendedGraphicsMode = Chip8->extendedGraphicsMode;
+    image->playBeep = Chip8->playBeep;
+    image->waitingForKey = Chip8->waitingForKey;
+    image->halted = Chip8->halted;
+}
+
+/**
+* Puts a image back into a machine
+* Only the memory that differs is written, so pages still shared with other instances stay shared.
+*
+* @param image Address of the image
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+static void Chip8RewindRestore(Chip8RewindImage *image, Chip8CPU *Chip8)
+{
+    for (int i = 0; i < CHIP8_PAGE_COUNT; i++)
+    {
+        unsigned char *data = Chip8->pages[i]->data;
+        unsigned char *saved = image->memory + i * CHIP8_PAGE_SIZE;
+
+        if (memcmp(data, saved, CHIP8_PAGE_SIZE) == 0)
+            continue;
+
+        for (int j = 0; j < CHIP8_PAGE_SIZE; j++)
+        {
+            if (Chip8Read(Chip8, i * CHIP8_PAGE_SIZE + j) != saved[j])
+            {
+                Chip8Write(Chip8, i * CHIP8_PAGE_SIZE + j, saved[j]);
+                Chip8InvalidateDecodeCache(Chip8, i * CHIP8_PAGE_SIZE + j, 1);
+            }
+        }
+    }
+
+    memcpy(Chip8->videoMemory, image->videoMemory, sizeof(image->videoMemory));
+    memcpy(Chip8->stack, image->stack, sizeof(image->stack));
+    memcpy(Chip8->V, image->V, sizeof(image->V));
+    memcpy(Chip8->R, image->R, sizeof(image->R));
+    Chip8->cycles = image->cycles;
+    Chip8->timerCycle = image->timerCycle;
+    Chip8->random = image->random;
+    Chip8->runUntil = image->cycles;
+    Chip8->opcode = image->opcode;
+    Chip8->I = image->I;
+    Chip8->pc = image->pc;
+    Chip8->sp = image->sp;
+    Chip8->delayTimer = image->delayTimer;
+    Chip8->soundTimer = image->soundTimer;
+    Chip8->extendedGraphicsMode = image->extendedGraphicsMode;
+    Chip8->playBeep = image->playBeep;
+    Chip8->waitingForKey = image->waitingForKey;
+    Chip8->halted = image->halted;
+
+    //the whole screen has to be redrawn
+    Chip8->dirtyRows = ~0ULL;
+    Chip8->refreshScreen = true;
+}
+
+/**
+* Encodes a image as the bytes that differ from a base image
+* The two images are XORed, then stored as runs: 2 bytes of unchanged (zero) bytes to skip, 2 bytes of length
+* and that many XORed bytes.
+*
+* @param image Address of the image to encode
+* @param base Address of the image it is stored against, or NULL to store it against zeros
+* @param out where to write the encoded bytes, at least 2 * sizeof(Chip8RewindImage) + 4 bytes
+* @return number of bytes written.
+*/
+static size_t Chip8RewindEncode(const Chip8RewindImage *image, const Chip8RewindImage *base, unsigned char *out)
+{
+    const unsigned char *a = (const unsigned char *)image;
+    const unsigned char *b = (const unsigned char *)base;
+    const size_t size = sizeof(Chip8RewindImage);
+    size_t length = 0;
+    size_t i = 0;
+
+    while (i < size)
+    {
+        //unchanged bytes
+        size_t skip = i;
+        while (i < size && a[i] == (b ? b[i] : 0))
+            i++;
+        skip = i - skip;
+
+        if (i == size)
+            break;
+
+        //changed bytes, up to the next run of CHIP8_REWIND_MIN_RUN unchanged ones
+        size_t start = i;
+        size_t same = 0;
+        while (i < size && same < CHIP8_REWIND_MIN_RUN)
+        {
+            same = a[i] == (b ? b[i] : 0) ? same + 1 : 0;
+            i++;
+        }
+        i -= same;
+
+        out[length++] = skip & 0xFF;
+        out[length++] = skip >> 8;
+        out[length++] = (i - start) & 0xFF;
+        out[length++] = (i - start) >> 8;
+        for (size_t j = start; j < i; j++)
+            out[length++] = a[j] ^ (b ? b[j] : 0);
+    }
+
+    return length;
+}
+
+/**
+* Decodes a frame written by Chip8RewindEncode
+*
+* @param image Address of the image, it must hold the base image (or zeros) and is changed into the frame
+* @param in the encoded bytes
+* @param length number of encoded bytes
+* @return Nothing.
+*/
+static void Chip8RewindDecode(Chip8RewindImage *image, const unsigned char *in, size_t length)
+{
+    unsigned char *a = (unsigned char *)image;
+    size_t i = 0;
+    size_t position = 0;
+
+    while (position + 4 <= length)
+    {
+        i += in[position] | (in[position + 1] << 8);
+        size_t count = in[position + 2] | (in[position + 3] << 8);
+        position += 4;
+
+        for (size_t j = 0; j < count; j++)
+            a[i++] ^= in[position++];
+    }
+}
+
+/**
+* Decodes a keyframe into keyImage, unless it is already there
+*
+* @param rewind Address of the Chip8Rewind object
+* @param index position of the keyframe from the oldest frame
+* @return Nothing.
+*/
+static void Chip8RewindLoadKey(Chip8Rewind *rewind, int index)
+{
+    Chip8RewindFrame *frame = Chip8RewindAt(rewind, index);
+
+    if (rewind->keyValid && rewind->keyNumber == frame->key)
+        return;
+
+    memset(&rewind->keyImage, 0, sizeof(Chip8RewindImage));
+    Chip8RewindDecode(&rewind->keyImage, rewind->block + frame->offset, frame->length);
+    rewind->keyNumber = frame->key;
+    rewind->keyValid = true;
+}
+
+/**
+* Drops the oldest frame, and the frames stored against it if it is a keyframe
+*
+* @param rewind Address of the Chip8Rewind object
+* @return Nothing.
+*/
+static void Chip8RewindDropOldest(Chip8Rewind *rewind)
+{
+    uint64_t key = Chip8RewindAt(rewind, 0)->key;
+
+    do
+    {
+        rewind->first = (rewind->first + 1) % rewind->capacity;
+        rewind->count--;
+    }
+    while (rewind->count > 0 && Chip8RewindAt(rewind, 0)->key == key);
+
+    if (rewind->keyNumber == key)
+        rewind->keyValid = false;
+}
+
+/**
+* Finds room for length bytes after the newest frame, dropping the oldest frames that are in the way
+*
+* @param rewind Address of the Chip8Rewind object
+* @param length number of bytes needed
+* @return offset of the room in the snapshot block.
+*/
+static size_t Chip8RewindMakeRoom(Chip8Rewind *rewind, size_t length)
+{
+    size_t end = 0;
+
+    if (rewind->count > 0)
+    {
+        Chip8RewindFrame *newest = Chip8RewindAt(rewind, rewind->count - 1);
+        end = newest->offset + newest->length;
+    }
+
+    size_t offset = end;
+    if (offset + length > rewind->size)
+    {
+        //wrap back to the start, the frames between the end and the end of the block are the oldest
+        offset = 0;
+        while (rewind->count > 0 && Chip8RewindAt(rewind, 0)->offset >= end)
+            Chip8RewindDropOldest(rewind);
+    }
+
+    //the frames still ahead of the room are from the last time around the block, so they are the oldest
+    while (rewind->count > 0 && (rewind->count == rewind->capacity ||
+           (Chip8RewindAt(rewind, 0)->offset >= offset && Chip8RewindAt(rewind, 0)->offset < offset + length)))
+        Chip8RewindDropOldest(rewind);
+
+    return offset;
+}
+
+/**
+* Creates a rewind buffer that holds up to a number of frames in a fixed block of memory
+* All memory is allocated here, pushing and stepping back never allocate.
+* When the block is full the oldest frames are dropped, so the window may be shorter than frames.
+*
+* @param frames number of frames to keep (60 per second)
+* @param bytes size of the snapshot block, 0 for frames * CHIP8_REWIND_BYTES_PER_FRAME
+* @return the rewind buffer, or NULL if it could not be created.
+*/
+Chip8Rewind *Chip8RewindCreate(int frames, size_t bytes)
+{
+    if (frames < 1)
+        return NULL;
+
+    if (bytes == 0)
+        bytes = (size_t)frames * CHIP8_REWIND_BYTES_PER_FRAME;
+
+    Chip8Rewind *rewind = (Chip8Rewind *)calloc(1, sizeof(Chip8Rewind));
+    if (rewind == NULL)
+        return NULL;
+
+    rewind->capacity = frames;
+    rewind->size = bytes;
+    rewind->frames = (Chip8RewindFrame *)calloc(frames, sizeof(Chip8RewindFrame));
+    rewind->block = (unsigned char *)malloc(bytes);
+    rewind->encoded = (unsigned char *)malloc(2 * sizeof(Chip8RewindImage) + 4);
+
+    if (rewind->frames == NULL || rewind->block == NULL || rewind->encoded == NULL)
+    {
+        Chip8RewindFree(rewind);
+        return NULL;
+    }
+
+    return rewind;
+}
+
+/**
+* Frees a rewind buffer
+*
+* @param rewind Address of the Chip8Rewind object
+* @return Nothing.
+*/
+void Chip8RewindFree(Chip8Rewind *rewind)
+{
+    if (rewind == NULL)
+        return;
+
+    free(rewind->frames);
+    free(rewind->block);
+    free(rewind->encoded);
+    free(rewind);
+}
+
+/**
+* Drops every stored frame, call it after a reset, a new ROM or a loaded state
+*
+* @param rewind Address of the Chip8Rewind object
+* @return Nothing.
+*/
+void Chip8RewindClear(Chip8Rewind *rewind)
+{
+    rewind->first = 0;
+    rewind->count = 0;
+    rewind->keyValid = false;
+}
+
+/**
+* Stores a snapshot of the machine, call it once per frame before the frame is run
+* Every CHIP8_REWIND_KEYFRAME_INTERVAL frames a full snapshot is stored, the frames in between only store
+* what changed since that snapshot.
+*
+* @param rewind Address of the Chip8Rewind object
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8RewindPush(Chip8Rewind *rewind, Chip8CPU *Chip8)
+{
+    uint64_t number = rewind->pushed++;
+
+    Chip8RewindCapture(&rewind->image, Chip8);
+
+    //store against the keyframe of the newest frame while it is recent enough
+    bool keyframe = rewind->count == 0 || !rewind->keyValid ||
+        number - rewind->keyNumber >= CHIP8_REWIND_KEYFRAME_INTERVAL;
+
+    size_t length = Chip8RewindEncode(&rewind->image, keyframe ? NULL : &rewind->keyImage, rewind->encoded);
+    size_t offset = Chip8RewindMakeRoom(rewind, length);
+
+    //making room dropped the keyframe this frame was stored against
+    if (!keyframe && !rewind->keyValid)
+    {
+        keyframe = true;
+        length = Chip8RewindEncode(&rewind->image, NULL, rewind->encoded);
+        offset = Chip8RewindMakeRoom(rewind, length);
+    }
+
+    //a frame bigger than the whole block is not stored
+    if (length > rewind->size)
+    {
+        Chip8RewindClear(rewind);
+        return;
+    }
+
+    memcpy(rewind->block + offset, rewind->encoded, length);
+
+    Chip8RewindFrame *frame = &rewind->frames[(rewind->first + rewind->count) % rewind->capacity];
+    frame->offset = offset;
+    frame->length = length;
+    frame->key = keyframe ? number : rewind->keyNumber;
+    rewind->count++;
+
+    if (keyframe)
+    {
+        memcpy(&rewind->keyImage, &rewind->image, sizeof(Chip8RewindImage));
+        rewind->keyNumber = number;
+        rewind->keyValid = true;
+    }
+}
+
+/**
+* Puts the machine back to the newest stored frame and drops it, so calling it once per frame plays the game backwards
+* The keys, backend, quirks and speed of the machine are not changed.
+*
+* @param rewind Address of the Chip8Rewind object
+* @param Chip8 Address of the Chip8CPU object
+* @return false if there are no frames left.
+*/
+bool Chip8RewindStep(Chip8Rewind *rewind, Chip8CPU *Chip8)
+{
+    if (rewind->count == 0)
+        return false;
+
+    Chip8RewindFrame *frame = Chip8RewindAt(rewind, rewind->count - 1);
+
+    if (frame->key == rewind->pushed - 1)
+    {
+        //a keyframe is stored against zeros
+        memset(&rewind->image, 0, sizeof(Chip8RewindImage));
+    }
+    else
+    {
+        //the keyframe is the newest frame with its own number, at most CHIP8_REWIND_KEYFRAME_INTERVAL frames back
+        int index = rewind->count - 1 - (int)(rewind->pushed - 1 - frame->key);
+        Chip8RewindLoadKey(rewind, index);
+        memcpy(&rewind->image, &rewind->keyImage, sizeof(Chip8RewindImage));
+    }
+
+    Chip8RewindDecode(&rewind->image, rewind->block + frame->offset, frame->length);
+    Chip8RewindRestore(&rewind->image, Chip8);
+
+    rewind->count--;
+    rewind->pushed--;
+
+    //the keyframe of the frames left is the one of the new newest frame
+    if (rewind->count > 0)
+    {
+        Chip8RewindFrame *newest = Chip8RewindAt(rewind, rewind->count - 1);
+        Chip8RewindLoadKey(rewind, rewind->count - 1 - (int)(rewind->pushed - 1 - newest->key));
+    }
+    else
+        rewind->keyValid = false;
+
+    return true;
+}
+
+/**
+* Returns the number of stored frames
+*
+* @param rewind Address of the Chip8Rewind object
+* @return number of frames that can be stepped back.
+*/
+int Chip8RewindCount(Chip8Rewind *rewind)
+{
+    return rewind->count;
+}
+
+/**
+* Returns the number of bytes the stored frames take up in the snapshot block
+*
+* @param rewind Address of the Chip8Rewind object
+* @return number of bytes used.
+*/
+size_t Chip8RewindBytesUsed(Chip8Rewind *rewind)
+{
+    size_t used = 0;
+
+    for (int i = 0; i < rewind->count; i++)
+        used += Chip8RewindAt(rewind, i)->length;
+
+    return used;
+}
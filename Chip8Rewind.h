@@ -0,0 +1,103 @@
+/**
+* Chip-8 Rewind
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_REWIND_H
+#define CHIP8_REWIND_H
+
+#include "Chip8.h"
+#include <stddef.h>
+
+//default number of frames between the full snapshots the other frames are stored against
+#define CHIP8_REWIND_KEYFRAME_INTERVAL  60
+
+//default number of bytes kept per frame of the rewind window, used when Chip8RewindCreate is given 0 bytes
+#define CHIP8_REWIND_BYTES_PER_FRAME    512
+
+//a ring buffer of per-frame snapshots of one Chip8CPU, see Chip8Rewind.c
+typedef struct Chip8Rewind Chip8Rewind;
+
+/**
+* Creates a rewind buffer that holds up to a number of frames in a fixed block of memory
+* All memory is allocated here, pushing and stepping back never allocate.
+* When the block is full the oldest frames are dropped, so the window may be shorter than frames.
+*
+* @param frames number of frames to keep (60 per second)
+* @param bytes size of the snapshot block, 0 for frames * CHIP8_REWIND_BYTES_PER_FRAME
+* @return the rewind buffer, or NULL if it could not be created.
+*/
+Chip8Rewind *Chip8RewindCreate(int frames, size_t bytes);
+
+/**
+* Frees a rewind buffer
+*
+* @param rewind Address of the Chip8Rewind object
+* @return Nothing.
+*/
+void Chip8RewindFree(Chip8Rewind *rewind);
+
+/**
+* Drops every stored frame, call it after a reset, a new ROM or a loaded state
+*
+* @param rewind Address of the Chip8Rewind object
+* @return Nothing.
+*/
+void Chip8RewindClear(Chip8Rewind *rewind);
+
+/**
+* Stores a snapshot of the machine, call it once per frame before the frame is run
+* Every CHIP8_REWIND_KEYFRAME_INTERVAL frames a full snapshot is stored, the frames in between only store
+* what changed since that snapshot.
+*
+* @param rewind Address of the Chip8Rewind object
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8RewindPush(Chip8Rewind *rewind, Chip8CPU *Chip8);
+
+/**
+* Puts the machine back to the newest stored frame and drops it, so calling it once per frame plays the game backwards
+* The keys, backend, quirks and speed of the machine are not changed.
+*
+* @param rewind Address of the Chip8Rewind object
+* @param Chip8 Address of the Chip8CPU object
+* @return false if there are no frames left.
+*/
+bool Chip8RewindStep(Chip8Rewind *rewind, Chip8CPU *Chip8);
+
+/**
+* Returns the number of stored frames
+*
+* @param rewind Address of the Chip8Rewind object
+* @return number of frames that can be stepped back.
+*/
+int Chip8RewindCount(Chip8Rewind *rewind);
+
+/**
+* Returns the number of bytes the stored frames take up in the snapshot block
+*
+* @param rewind Address of the Chip8Rewind object
+* @return number of bytes used.
+*/
+size_t Chip8RewindBytesUsed(Chip8Rewind *rewind);
+
+#endif //header guard CHIP8_REWIND_H
@@ -0,0 +1,149 @@
+/**
+* Chip-8 Opcode Statistics
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Stats.h"
+#include "Chip8Jit.h"
+#include "Chip8Disassembler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//name of each CHIP8_OP_* class, the idle handlers are counted as the opcodes they run
+static const char *Chip8StatsClassNames[CHIP8_OP_COUNT] =
+{
+    "", "invalid",
+    "00CN", "00E0", "00EE", "00FB", "00FC", "00FD", "00FE", "00FF",
+    "1NNN", "2NNN", "3XNN", "4XNN", "5XY0", "6XNN", "7XNN",
+    "8XY0", "8XY1", "8XY2", "8XY3", "8XY4", "8XY5", "8XY6", "8XY7", "8XYE",
+    "9XY0", "ANNN", "BNNN", "CXKK", "DXYN", "EX9E", "EXA1",
+    "FX07", "FX0A", "FX15", "FX18", "FX1E", "FX29", "FX30",
+    "FX33", "FX55", "FX65", "FX75", "FX85",
+    "", ""
+};
+
+/**
+* Returns the opcode counts of a instance, with the classes and total added up
+* The counts are kept from the first Chip8Reset until Chip8ClearStats or Chip8Free.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return the counts, NULL if the emulator was built without CHIP8_STATS.
+*/
+Chip8Stats *Chip8GetStats(Chip8CPU *Chip8)
+{
+    Chip8Stats *stats = Chip8->stats;
+
+    if (stats == NULL)
+        return NULL;
+
+    //the JIT counts whole blocks and adds them up here
+    Chip8JitCountStats(Chip8);
+
+    memset(stats->classes, 0, sizeof(stats->classes));
+    stats->total = 0;
+
+    for (int opcode = 0; opcode < 65536; opcode++)
+    {
+        stats->classes[Chip8DecodeOpcode(opcode)] += stats->opcodes[opcode];
+        stats->total += stats->opcodes[opcode];
+    }
+
+    return stats;
+}
+
+/**
+* Sets all of the opcode counts of a instance back to 0
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8ClearStats(Chip8CPU *Chip8)
+{
+    if (Chip8->stats == NULL)
+        return;
+
+    Chip8JitCountStats(Chip8);
+    memset(Chip8->stats, 0, sizeof(Chip8Stats));
+}
+
+/**
+* Writes the opcode counts of a instance to a text file: the count of each class of opcode and how often
+* the skips skipped, then the CHIP8_STATS_TOP_OPCODES most run opcodes with their disassembly
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write
+* @return false if there are no counts (built without CHIP8_STATS) or the file could not be written.
+*/
+bool Chip8WriteStats(Chip8CPU *Chip8, char *filename)
+{
+    Chip8Stats *stats = Chip8GetStats(Chip8);
+
+    if (stats == NULL)
+        return false;
+
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+        return false;
+
+    double total = stats->total > 0 ? (double)stats->total : 1;
+
+    fprintf(file, "opcodes run: %llu\n\n", (unsigned long long)stats->total);
+    fprintf(file, "%-8s %16s %8s %8s\n", "class", "count", "share", "skipped");
+
+    for (int op = CHIP8_OP_NULL; op < CHIP8_OP_COUNT; op++)
+    {
+        if (stats->classes[op] == 0)
+            continue;
+
+        fprintf(file, "%-8s %16llu %7.2f%%", Chip8StatsClassNames[op], (unsigned long long)stats->classes[op], stats->classes[op] * 100 / total);
+        if (op == CHIP8_OP_3XNN || op == CHIP8_OP_4XNN || op == CHIP8_OP_5XY0 || op == CHIP8_OP_9XY0 || op == CHIP8_OP_EX9E || op == CHIP8_OP_EXA1)
+            fprintf(file, " %7.2f%%", stats->skips[op] * 100.0 / stats->classes[op]);
+        fprintf(file, "\n");
+    }
+
+    //pick the most run opcodes, the list is short so a insertion into a sorted list will do
+    unsigned short top[CHIP8_STATS_TOP_OPCODES];
+    int count = 0;
+
+    for (int opcode = 0; opcode < 65536; opcode++)
+    {
+        uint64_t runs = stats->opcodes[opcode];
+        if (runs == 0 || (count == CHIP8_STATS_TOP_OPCODES && runs <= stats->opcodes[top[count - 1]]))
+            continue;
+
+        int i = count < CHIP8_STATS_TOP_OPCODES ? count++ : count - 1;
+        for (; i > 0 && stats->opcodes[top[i - 1]] < runs; i--)
+            top[i] = top[i - 1];
+        top[i] = opcode;
+    }
+
+    fprintf(file, "\n%-6s %-20s %16s %8s\n", "opcode", "disassembly", "count", "share");
+
+    for (int i = 0; i < count; i++)
+    {
+        char name[50];
+        Chip8Disassemble(top[i], name);
+        fprintf(file, "%04X   %-20s %16llu %7.2f%%\n", top[i], name, (unsigned long long)stats->opcodes[top[i]], stats->opcodes[top[i]] * 100 / total);
+    }
+
+    return fclose(file) == 0;
+}
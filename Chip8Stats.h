@@ -0,0 +1,93 @@
+/**
+* Chip-8 Opcode Statistics
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_STATS_H
+#define CHIP8_STATS_H
+
+#include "Chip8.h"
+
+//most run opcodes listed by Chip8WriteStats
+#define CHIP8_STATS_TOP_OPCODES     100
+
+//counts of the opcodes a instance has run, kept in Chip8->stats when built with CHIP8_STATS
+typedef struct Chip8Stats
+{
+    //times each opcode was run
+    uint64_t opcodes[65536];
+
+    //times each skip opcode (3XNN, 4XNN, 5XY0, 9XY0, EX9E, EXA1) skipped the next opcode, by CHIP8_OP_*
+    uint64_t skips[CHIP8_OP_COUNT];
+
+    //times the opcodes of each CHIP8_OP_* were run and all opcodes run, added up from opcodes by Chip8GetStats
+    //total is less than Chip8->cycles once a game has halted (00FD) or waited for a key (FX0A), as no opcodes run then
+    uint64_t classes[CHIP8_OP_COUNT];
+    uint64_t total;
+} Chip8Stats;
+
+//the counters are only compiled in when built with -DCHIP8_STATS, otherwise these are empty
+#ifdef CHIP8_STATS
+#define CHIP8_STATS_COUNT(Chip8, opcode, n)                                     \
+    do                                                                          \
+    {                                                                           \
+        if ((Chip8)->stats != NULL)                                             \
+            (Chip8)->stats->opcodes[(opcode)] += (n);                           \
+    } while (0)
+#define CHIP8_STATS_SKIP(Chip8, op)                                             \
+    do                                                                          \
+    {                                                                           \
+        if ((Chip8)->stats != NULL)                                             \
+            (Chip8)->stats->skips[(op)]++;                                      \
+    } while (0)
+#else
+#define CHIP8_STATS_COUNT(Chip8, opcode, n)     do { } while (0)
+#define CHIP8_STATS_SKIP(Chip8, op)             do { } while (0)
+#endif
+
+/**
+* Returns the opcode counts of a instance, with the classes and total added up
+* The counts are kept from the first Chip8Reset until Chip8ClearStats or Chip8Free.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return the counts, NULL if the emulator was built without CHIP8_STATS.
+*/
+Chip8Stats *Chip8GetStats(Chip8CPU *Chip8);
+
+/**
+* Sets all of the opcode counts of a instance back to 0
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return Nothing.
+*/
+void Chip8ClearStats(Chip8CPU *Chip8);
+
+/**
+* Writes the opcode counts of a instance to a text file: the count of each class of opcode and how often
+* the skips skipped, then the CHIP8_STATS_TOP_OPCODES most run opcodes with their disassembly
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write
+* @return false if there are no counts (built without CHIP8_STATS) or the file could not be written.
+*/
+bool Chip8WriteStats(Chip8CPU *Chip8, char *filename);
+
+#endif //header guard CHIP8_STATS_H
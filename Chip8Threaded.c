@@ -0,0 +1,165 @@
+/**
+* Chip-8 Threaded Interpreter
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Threaded.h"
+#include "Chip8Stats.h"
+#include "Chip8Profile.h"
+#include "Chip8CallGraph.h"
+#include "Chip8Trace.h"
+#include <string.h>
+
+#if defined(__GNUC__) && !defined(CHIP8_NO_THREADED)
+
+//opcode fields of the opcode being run
+#define CHIP8_X     ((opcode & 0x0F00) >> 8)
+#define CHIP8_Y     ((opcode & 0x00F0) >> 4)
+#define CHIP8_N     (opcode & 0x000F)
+#define CHIP8_KK    (opcode & 0x00FF)
+#define CHIP8_NNN   (opcode & 0x0FFF)
+
+//fetch the next opcode and jump to its code, leaving the loop once the cycles are used up
+#define CHIP8_FETCH()                                                           \
+    do                                                                          \
+    {                                                                           \
+        if (cycles-- == 0)                                                      \
+            goto done;                                                          \
+        fetch = pc & 0x0FFF;                                                    \
+        opcode = Chip8ReadOpcode(Chip8, fetch);                                 \
+        pc += 2;                                                                \
+        CHIP8_STATS_COUNT(Chip8, opcode, 1);                                    \
+        CHIP8_PROFILE_RUN(Chip8, fetch);                                        \
+        goto *labels[decodeCache[fetch]];                                       \
+    } while (0)
+
+//the end of every opcode: the opcode that ran is traced, then the next one is fetched
+#define CHIP8_DISPATCH()                                                        \
+    do                                                                          \
+    {                                                                           \
+        CHIP8_TRACE_RUN(Chip8, end - cycles - 1, fetch, opcode, I, V);          \
+        CHIP8_FETCH();                                                          \
+    } while (0)
+
+//run a handler from Chip8.c, the locals are written back first and reloaded after
+#define CHIP8_CALL(handler)                                                     \
+    do                                                                          \
+    {                                                                           \
+        Chip8->pc = pc;                                                         \
+        Chip8->I = I;                                                           \
+        Chip8->opcode = opcode;                                                 \
+        Chip8->cycles = end - cycles - 1;                                       \
+        memcpy(Chip8->V, V, 16);                                                \
+        handler(Chip8);                                                         \
+        pc = Chip8->pc;                                                         \
+        I = Chip8->I;                                                           \
+        memcpy(V, Chip8->V, 16);                                                \
+    } while (0)
+
+//run a idle handler from Chip8.c, it can move Chip8->cycles forward so the cycles left are reloaded
+#define CHIP8_CALL_IDLE(handler)                                                \
+    do                                                                          \
+    {                                                                           \
+        CHIP8_CALL(handler);                                                    \
+        cycles = end - Chip8->cycles - 1;                                       \
+    } while (0)
+
+//one copy of the loop for each quirk profile
+#define CHIP8_THREADED_QUIRKS       CHIP8_QUIRKS_MODERN
+#define CHIP8_THREADED_FUNCTION     Chip8RunThreadedModern
+#include "Chip8ThreadedLoop.h"
+
+#define CHIP8_THREADED_QUIRKS       CHIP8_QUIRKS_VIP
+#define CHIP8_THREADED_FUNCTION     Chip8RunThreadedVIP
+#include "Chip8ThreadedLoop.h"
+
+#define CHIP8_THREADED_QUIRKS       CHIP8_QUIRKS_CHIP48
+#define CHIP8_THREADED_FUNCTION     Chip8RunThreadedCHIP48
+#include "Chip8ThreadedLoop.h"
+
+#define CHIP8_THREADED_QUIRKS       CHIP8_QUIRKS_SCHIP
+#define CHIP8_THREADED_FUNCTION     Chip8RunThreadedSCHIP
+#include "Chip8ThreadedLoop.h"
+
+/**
+* Runs opcodes with a direct threaded interpreter loop
+* Each predecoded opcode jumps straight to the code for the next one (GCC labels as values),
+* and pc, I and V are kept in locals until the loop exits or has to call a handler.
+* Built without GCC, or with CHIP8_NO_THREADED defined, this runs the handler tables instead.
+* There is a copy of the loop for each quirk profile, the one for Chip8->quirks is picked once per call.
+* Chip8->cycles is counted up for each opcode, the timers are brought up to date by Chip8RunCycles.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+void Chip8RunThreaded(Chip8CPU *Chip8, unsigned long cycles)
+{
+    switch (Chip8->quirks)
+    {
+        case CHIP8_QUIRKS_VIP:
+            Chip8RunThreadedVIP(Chip8, cycles);
+            break;
+        case CHIP8_QUIRKS_CHIP48:
+            Chip8RunThreadedCHIP48(Chip8, cycles);
+            break;
+        case CHIP8_QUIRKS_SCHIP:
+            Chip8RunThreadedSCHIP(Chip8, cycles);
+            break;
+        default:
+            Chip8RunThreadedModern(Chip8, cycles);
+            break;
+    }
+}
+
+#else
+
+/**
+* Runs opcodes through the handler tables, used when labels as values are not available
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+void Chip8RunThreaded(Chip8CPU *Chip8, unsigned long cycles)
+{
+    void (**handlers)(Chip8CPU *Chip8) = Chip8DecodedOpcodeTable[Chip8->quirks];
+
+    Chip8->runUntil = Chip8->cycles + cycles;
+
+    while (Chip8->cycles < Chip8->runUntil)
+    {
+        unsigned short pc = Chip8->pc & 0x0FFF;
+        Chip8->opcode = Chip8ReadOpcode(Chip8, pc);
+        Chip8->pc += 2;
+        CHIP8_STATS_COUNT(Chip8, Chip8->opcode, 1);
+        CHIP8_PROFILE_RUN(Chip8, pc);
+
+        if (Chip8->decodeCache[pc] == CHIP8_OP_UNDECODED)
+            Chip8->decodeCache[pc] = Chip8DecodeAddress(Chip8, pc);
+
+        (*handlers[Chip8->decodeCache[pc]])(Chip8);
+        CHIP8_TRACE_RUN(Chip8, Chip8->cycles, pc, Chip8->opcode, Chip8->I, Chip8->V);
+        Chip8->cycles++;
+    }
+}
+
+#endif
@@ -0,0 +1,43 @@
+/**
+* Chip-8 Threaded Interpreter
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_THREADED_H
+#define CHIP8_THREADED_H
+
+#include "Chip8.h"
+
+/**
+* Runs opcodes with a direct threaded interpreter loop
+* Each predecoded opcode jumps straight to the code for the next one (GCC labels as values),
+* and pc, I and V are kept in locals until the loop exits or has to call a handler.
+* Built without GCC, or with CHIP8_NO_THREADED defined, this runs the handler tables instead.
+* There is a copy of the loop for each quirk profile, the one for Chip8->quirks is picked once per call.
+* Chip8->cycles is counted up for each opcode, the timers are brought up to date by Chip8RunCycles.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+void Chip8RunThreaded(Chip8CPU *Chip8, unsigned long cycles);
+
+#endif //header guard CHIP8_THREADED_H
@@ -0,0 +1,313 @@
+/**
+* Chip-8 Threaded Interpreter Loop
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+/**
+* Runs opcodes with a direct threaded interpreter loop for one quirk profile
+* This file is included by Chip8Threaded.c once for each profile, with these defined:
+*   CHIP8_THREADED_QUIRKS       the CHIP8_QUIRKS_* profile, a constant so the quirk tests are compiled out
+*   CHIP8_THREADED_FUNCTION     the name of the function
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param cycles number of opcodes to run
+* @return Nothing.
+*/
+static void CHIP8_THREADED_FUNCTION(Chip8CPU *Chip8, unsigned long cycles)
+{
+    //one label per CHIP8_OP_* index
+    static void *labels[CHIP8_OP_COUNT] = 
+    {
+        &&op_undecoded, &&op_null,
+        &&op_00CN, &&op_00E0, &&op_00EE, &&op_00FB, &&op_00FC, &&op_00FD, &&op_00FE, &&op_00FF,
+        &&op_1NNN, &&op_2NNN, &&op_3XNN, &&op_4XNN, &&op_5XY0, &&op_6XNN, &&op_7XNN,
+        &&op_8XY0, &&op_8XY1, &&op_8XY2, &&op_8XY3, &&op_8XY4, &&op_8XY5, &&op_8XY6, &&op_8XY7, &&op_8XYE,
+        &&op_9XY0, &&op_ANNN, &&op_BNNN, &&op_CXKK, &&op_DXYN, &&op_EX9E, &&op_EXA1,
+        &&op_FX07, &&op_FX0A, &&op_FX15, &&op_FX18, &&op_FX1E, &&op_FX29, &&op_FX30,
+        &&op_FX33, &&op_FX55, &&op_FX65, &&op_FX75, &&op_FX85,
+        &&op_FX07_idle, &&op_1NNN_idle
+    };
+
+    unsigned char *decodeCache = Chip8->decodeCache;
+    unsigned short pc = Chip8->pc;
+    unsigned short I = Chip8->I;
+    unsigned short opcode = Chip8->opcode;
+    unsigned short fetch;
+    unsigned char V[16];
+    uint64_t end = Chip8->cycles + cycles;
+
+    memcpy(V, Chip8->V, 16);
+    Chip8->runUntil = end;
+
+    CHIP8_FETCH();
+
+op_undecoded:
+    decodeCache[fetch] = Chip8DecodeAddress(Chip8, fetch);
+    goto *labels[decodeCache[fetch]];
+
+op_null:
+    CHIP8_CALL(Chip8CPUNULL);
+    CHIP8_DISPATCH();
+
+op_00CN:
+    CHIP8_CALL(Chip8OpCode00CN);
+    CHIP8_DISPATCH();
+
+op_00E0:
+    CHIP8_CALL(Chip8OpCode00E0);
+    CHIP8_DISPATCH();
+
+op_00EE:
+    CHIP8_CALLGRAPH_RETURN(Chip8, end - cycles - 1);
+    pc = Chip8->stack[--Chip8->sp & 0x0F];
+    CHIP8_DISPATCH();
+
+op_00FB:
+    CHIP8_CALL(Chip8OpCode00FB);
+    CHIP8_DISPATCH();
+
+op_00FC:
+    CHIP8_CALL(Chip8OpCode00FC);
+    CHIP8_DISPATCH();
+
+op_00FD:
+    CHIP8_CALL_IDLE(Chip8OpCode00FD);
+    CHIP8_DISPATCH();
+
+op_00FE:
+    CHIP8_CALL(Chip8OpCode00FE);
+    CHIP8_DISPATCH();
+
+op_00FF:
+    CHIP8_CALL(Chip8OpCode00FF);
+    CHIP8_DISPATCH();
+
+op_1NNN:
+    pc = CHIP8_NNN;
+    CHIP8_DISPATCH();
+
+op_2NNN:
+    CHIP8_CALLGRAPH_CALL(Chip8, CHIP8_NNN, end - cycles - 1);
+    Chip8->stack[Chip8->sp++ & 0x0F] = pc;
+    pc = CHIP8_NNN;
+    CHIP8_DISPATCH();
+
+op_3XNN:
+    if (V[CHIP8_X] == CHIP8_KK)
+    {
+        pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_3XNN);
+    }
+    CHIP8_DISPATCH();
+
+op_4XNN:
+    if (V[CHIP8_X] != CHIP8_KK)
+    {
+        pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_4XNN);
+    }
+    CHIP8_DISPATCH();
+
+op_5XY0:
+    if (V[CHIP8_X] == V[CHIP8_Y])
+    {
+        pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_5XY0);
+    }
+    CHIP8_DISPATCH();
+
+op_6XNN:
+    V[CHIP8_X] = CHIP8_KK;
+    CHIP8_DISPATCH();
+
+op_7XNN:
+    V[CHIP8_X] += CHIP8_KK;
+    CHIP8_DISPATCH();
+
+op_8XY0:
+    V[CHIP8_X] = V[CHIP8_Y];
+    CHIP8_DISPATCH();
+
+op_8XY1:
+    V[CHIP8_X] |= V[CHIP8_Y];
+    if (CHIP8_QUIRK_VF_RESET(CHIP8_THREADED_QUIRKS))
+        V[0xF] = 0;
+    CHIP8_DISPATCH();
+
+op_8XY2:
+    V[CHIP8_X] &= V[CHIP8_Y];
+    if (CHIP8_QUIRK_VF_RESET(CHIP8_THREADED_QUIRKS))
+        V[0xF] = 0;
+    CHIP8_DISPATCH();
+
+op_8XY3:
+    V[CHIP8_X] ^= V[CHIP8_Y];
+    if (CHIP8_QUIRK_VF_RESET(CHIP8_THREADED_QUIRKS))
+        V[0xF] = 0;
+    CHIP8_DISPATCH();
+
+op_8XY4:
+    //VF is written before the add, the same as Chip8OpCode8XY4
+    V[0xF] = V[CHIP8_Y] > (0xFF - V[CHIP8_X]);
+    V[CHIP8_X] += V[CHIP8_Y];
+    CHIP8_DISPATCH();
+
+op_8XY5:
+    V[0xF] = !(V[CHIP8_Y] > V[CHIP8_X]);
+    V[CHIP8_X] -= V[CHIP8_Y];
+    CHIP8_DISPATCH();
+
+op_8XY6:
+    if (CHIP8_QUIRK_SHIFT_VY(CHIP8_THREADED_QUIRKS))
+        V[CHIP8_X] = V[CHIP8_Y];
+    V[0xF] = V[CHIP8_X] & 0x1;
+    V[CHIP8_X] >>= 1;
+    CHIP8_DISPATCH();
+
+op_8XY7:
+    V[0xF] = !(V[CHIP8_X] > V[CHIP8_Y]);
+    V[CHIP8_X] = V[CHIP8_Y] - V[CHIP8_X];
+    CHIP8_DISPATCH();
+
+op_8XYE:
+    if (CHIP8_QUIRK_SHIFT_VY(CHIP8_THREADED_QUIRKS))
+        V[CHIP8_X] = V[CHIP8_Y];
+    V[0xF] = V[CHIP8_X] >> 7;
+    V[CHIP8_X] <<= 1;
+    CHIP8_DISPATCH();
+
+op_9XY0:
+    if (V[CHIP8_X] != V[CHIP8_Y])
+    {
+        pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_9XY0);
+    }
+    CHIP8_DISPATCH();
+
+op_ANNN:
+    I = CHIP8_NNN;
+    CHIP8_DISPATCH();
+
+op_BNNN:
+    if (CHIP8_QUIRK_JUMP_VX(CHIP8_THREADED_QUIRKS))
+        pc = CHIP8_NNN + V[CHIP8_X];
+    else
+        pc = CHIP8_NNN + V[0];
+    CHIP8_DISPATCH();
+
+op_CXKK:
+    CHIP8_CALL(Chip8OpCodeCXKK);
+    CHIP8_DISPATCH();
+
+op_DXYN:
+    CHIP8_CALL(Chip8DecodedOpcodeTable[CHIP8_THREADED_QUIRKS][CHIP8_OP_DXYN]);
+    CHIP8_DISPATCH();
+
+op_EX9E:
+    if (Chip8->key[V[CHIP8_X]] != 0)
+    {
+        pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_EX9E);
+    }
+    CHIP8_DISPATCH();
+
+op_EXA1:
+    if (Chip8->key[V[CHIP8_X]] == 0)
+    {
+        pc += 2;
+        CHIP8_STATS_SKIP(Chip8, CHIP8_OP_EXA1);
+    }
+    CHIP8_DISPATCH();
+
+op_FX07:
+    CHIP8_CALL(Chip8OpCodeFX07);
+    CHIP8_DISPATCH();
+
+op_FX0A:
+    CHIP8_CALL_IDLE(Chip8OpCodeFX0A);
+    CHIP8_DISPATCH();
+
+op_FX15:
+    CHIP8_CALL(Chip8OpCodeFX15);
+    CHIP8_DISPATCH();
+
+op_FX18:
+    CHIP8_CALL(Chip8OpCodeFX18);
+    CHIP8_DISPATCH();
+
+op_FX1E:
+    V[0xF] = I + V[CHIP8_X] > 0xFFF;
+    I += V[CHIP8_X];
+    CHIP8_DISPATCH();
+
+op_FX29:
+op_FX30:
+    I = V[CHIP8_X] * 0x5;
+    CHIP8_DISPATCH();
+
+op_FX33:
+    Chip8Write(Chip8, I,     V[CHIP8_X] / 100);
+    Chip8Write(Chip8, I + 1, (V[CHIP8_X] / 10) % 10);
+    Chip8Write(Chip8, I + 2, (V[CHIP8_X] % 100) % 10);
+    Chip8InvalidateDecodeCache(Chip8, I, 3);
+    CHIP8_DISPATCH();
+
+op_FX55:
+    for (int i = 0; i <= CHIP8_X; ++i)
+        Chip8Write(Chip8, I + i, V[i]);
+    Chip8InvalidateDecodeCache(Chip8, I, CHIP8_X + 1);
+    I += CHIP8_QUIRK_I_STEP(CHIP8_THREADED_QUIRKS, CHIP8_X);
+    CHIP8_DISPATCH();
+
+op_FX65:
+    for (int i = 0; i <= CHIP8_X; ++i)
+        V[i] = Chip8Read(Chip8, I + i);
+    I += CHIP8_QUIRK_I_STEP(CHIP8_THREADED_QUIRKS, CHIP8_X);
+    CHIP8_DISPATCH();
+
+op_FX75:
+    for (int i = 0; i <= CHIP8_X; ++i)
+        Chip8->R[i] = V[i];
+    CHIP8_DISPATCH();
+
+op_FX85:
+    for (int i = 0; i <= CHIP8_X; ++i)
+        V[i] = Chip8->R[i];
+    CHIP8_DISPATCH();
+
+op_FX07_idle:
+    CHIP8_CALL_IDLE(Chip8OpCodeFX07Idle);
+    CHIP8_DISPATCH();
+
+op_1NNN_idle:
+    CHIP8_CALL_IDLE(Chip8OpCode1NNNIdle);
+    CHIP8_DISPATCH();
+
+done:
+    Chip8->pc = pc;
+    Chip8->I = I;
+    Chip8->opcode = opcode;
+    Chip8->cycles = end;
+    memcpy(Chip8->V, V, 16);
+}
+
+#undef CHIP8_THREADED_QUIRKS
+#undef CHIP8_THREADED_FUNCTION
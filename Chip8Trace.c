@@ -0,0 +1,393 @@
+/**
+* Chip-8 Instruction Trace
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#include "Chip8Trace.h"
+#include "Chip8Disassembler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+//most records the writer thread copies out of the ring and writes at once
+#define CHIP8_TRACE_CHUNK   4096
+
+//how long the writer thread sleeps when the ring is empty, in nanoseconds
+#define CHIP8_TRACE_SLEEP   1000000
+
+//the thread streaming a trace to a file
+struct Chip8TraceWriter
+{
+    Chip8Trace *trace;
+    FILE *file;
+    pthread_t thread;
+
+    //set by Chip8TraceStop, the thread writes what is left and ends
+    bool stop;
+
+    //records written or lost so far, the next record to write is tail & mask
+    uint64_t tail;
+
+    //false once a write to the file failed
+    bool written;
+
+    Chip8TraceRecord chunk[CHIP8_TRACE_CHUNK];
+};
+
+/**
+* Writes the start of a trace file
+*
+* @param file the file
+* @return Nothing.
+*/
+static void Chip8TraceWriteHeader(FILE *file)
+{
+    fwrite(CHIP8_TRACE_MAGIC, 1, 4, file);
+    fputc(CHIP8_TRACE_VERSION, file);
+}
+
+/**
+* Writes records to a trace file
+*
+* @param file the file
+* @param records the records
+* @param count number of records
+* @return false if the file could not be written.
+*/
+static bool Chip8TraceWriteRecords(FILE *file, const Chip8TraceRecord *records, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned char data[CHIP8_TRACE_RECORD_SIZE];
+
+        for (int b = 0; b < 8; b++)
+            data[b] = records[i].cycle >> (b * 8);
+        data[8] = records[i].pc & 0xFF;
+        data[9] = records[i].pc >> 8;
+        data[10] = records[i].opcode & 0xFF;
+        data[11] = records[i].opcode >> 8;
+        data[12] = records[i].I & 0xFF;
+        data[13] = records[i].I >> 8;
+        data[14] = records[i].vx;
+        data[15] = records[i].vf;
+
+        if (fwrite(data, 1, CHIP8_TRACE_RECORD_SIZE, file) != CHIP8_TRACE_RECORD_SIZE)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+* Writes a record that marks records which were overwritten before they were written
+*
+* @param writer the writer
+* @param lost number of records lost
+* @return Nothing.
+*/
+static void Chip8TraceWriteLost(struct Chip8TraceWriter *writer, uint64_t lost)
+{
+    Chip8TraceRecord record = {lost, CHIP8_TRACE_LOST, 0, 0, 0, 0};
+
+    if (!Chip8TraceWriteRecords(writer->file, &record, 1))
+        writer->written = false;
+}
+
+/**
+* Copies the records between tail and head out of the ring and writes them, at most a chunk at a time
+* The machine keeps adding records while they are copied, the ones it wrote over are dropped afterwards.
+*
+* @param writer the writer
+* @param stopped true once the machine has stopped adding records, so none of them is being written
+* @return true if there were records to write.
+*/
+static bool Chip8TraceWriteChunk(struct Chip8TraceWriter *writer, bool stopped)
+{
+    Chip8Trace *trace = writer->trace;
+    uint64_t size = trace->mask + 1;
+    uint64_t head = __atomic_load_n(&trace->head, __ATOMIC_ACQUIRE);
+
+    //while the machine runs it may be writing record head into the slot of record head - size
+    uint64_t writing = stopped ? 0 : 1;
+
+    if (head == writer->tail)
+        return false;
+
+    //the ring came round past the records not written yet, go on from half a ring back so it does not happen again at once
+    if (head + writing - writer->tail > size)
+    {
+        uint64_t from = head - size / 2;
+        Chip8TraceWriteLost(writer, from - writer->tail);
+        writer->tail = from;
+    }
+
+    uint64_t count = head - writer->tail;
+    if (count > CHIP8_TRACE_CHUNK)
+        count = CHIP8_TRACE_CHUNK;
+
+    for (uint64_t i = 0; i < count; i++)
+        writer->chunk[i] = trace->records[(writer->tail + i) & trace->mask];
+
+    //records the machine added while copying may have overwritten the first ones copied,
+    //every record below head + writing - size is lost
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    head = __atomic_load_n(&trace->head, __ATOMIC_RELAXED);
+
+    uint64_t skip = 0;
+    if (head + writing - writer->tail > size)
+    {
+        skip = head + writing - size - writer->tail;
+        if (skip > count)
+            skip = count;
+        Chip8TraceWriteLost(writer, skip);
+    }
+
+    if (!Chip8TraceWriteRecords(writer->file, writer->chunk + skip, count - skip))
+        writer->written = false;
+    writer->tail += count;
+
+    return true;
+}
+
+/**
+* The writer thread, writes the records as the machine adds them until Chip8TraceStop
+*
+* @param data the Chip8TraceWriter
+* @return NULL.
+*/
+static void *Chip8TraceWriterMain(void *data)
+{
+    struct Chip8TraceWriter *writer = (struct Chip8TraceWriter *)data;
+    struct timespec sleep = {0, CHIP8_TRACE_SLEEP};
+
+    while (!__atomic_load_n(&writer->stop, __ATOMIC_ACQUIRE))
+    {
+        if (!Chip8TraceWriteChunk(writer, false))
+            nanosleep(&sleep, NULL);
+    }
+
+    //the machine has stopped adding records, write the rest
+    while (Chip8TraceWriteChunk(writer, true))
+        ;
+
+    return NULL;
+}
+
+/**
+* Starts tracing every opcode a machine runs into a ring of the last records opcodes
+* With a file name a thread writes the records to the file as they come, otherwise they are only kept in memory
+* and Chip8TraceDump writes the last of them. The JIT runs the threaded backend while tracing.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to stream the trace to, or NULL
+* @param records size of the ring, rounded up to a power of 2, 0 for CHIP8_TRACE_DEFAULT_RECORDS
+* @return false if the machine is already traced, there was no memory, the file or thread could not be made,
+*         or the emulator was built without CHIP8_TRACE.
+*/
+bool Chip8TraceStart(Chip8CPU *Chip8, char *filename, size_t records)
+{
+#ifndef CHIP8_TRACE
+    return false;
+#endif
+
+    if (Chip8->trace != NULL)
+        return false;
+
+    size_t size = CHIP8_TRACE_CHUNK;
+    if (records == 0)
+        records = CHIP8_TRACE_DEFAULT_RECORDS;
+    while (size < records)
+        size *= 2;
+
+    Chip8Trace *trace = (Chip8Trace *)calloc(1, sizeof(Chip8Trace));
+    if (trace == NULL)
+        return false;
+
+    trace->records = (Chip8TraceRecord *)malloc(size * sizeof(Chip8TraceRecord));
+    trace->mask = size - 1;
+    if (trace->records == NULL)
+    {
+        free(trace);
+        return false;
+    }
+
+    if (filename != NULL)
+    {
+        struct Chip8TraceWriter *writer = (struct Chip8TraceWriter *)calloc(1, sizeof(struct Chip8TraceWriter));
+        FILE *file = writer != NULL ? fopen(filename, "wb") : NULL;
+
+        if (file == NULL)
+        {
+            free(writer);
+            free(trace->records);
+            free(trace);
+            return false;
+        }
+
+        Chip8TraceWriteHeader(file);
+        writer->trace = trace;
+        writer->file = file;
+        writer->written = true;
+
+        if (pthread_create(&writer->thread, NULL, Chip8TraceWriterMain, writer) != 0)
+        {
+            fclose(file);
+            free(writer);
+            free(trace->records);
+            free(trace);
+            return false;
+        }
+
+        trace->writer = writer;
+    }
+
+    Chip8->trace = trace;
+
+    return true;
+}
+
+/**
+* Writes the records still in the ring to a trace file, the last opcodes the machine ran
+* Call it from the thread running the machine.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write
+* @return false if the machine is not traced or the file could not be written.
+*/
+bool Chip8TraceDump(Chip8CPU *Chip8, char *filename)
+{
+    Chip8Trace *trace = Chip8->trace;
+
+    if (trace == NULL)
+        return false;
+
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+        return false;
+
+    Chip8TraceWriteHeader(file);
+
+    uint64_t size = trace->mask + 1;
+    uint64_t start = trace->head > size ? trace->head - size : 0;
+    bool written;
+
+    //the ring is written in up to 2 pieces, from the oldest record to the end of the buffer then from its start
+    uint64_t first = start & trace->mask;
+    uint64_t count = trace->head - start;
+    uint64_t piece = first + count > size ? size - first : count;
+
+    written = Chip8TraceWriteRecords(file, trace->records + first, piece);
+    if (written && count > piece)
+        written = Chip8TraceWriteRecords(file, trace->records, count - piece);
+
+    return fclose(file) == 0 && written;
+}
+
+/**
+* Stops tracing a machine, waits for the writer thread to write the rest of the records and frees the ring
+* Must be called before Chip8Free on a machine that is traced.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return false if the streamed file could not be written.
+*/
+bool Chip8TraceStop(Chip8CPU *Chip8)
+{
+    Chip8Trace *trace = Chip8->trace;
+    bool written = true;
+
+    if (trace == NULL)
+        return true;
+
+    if (trace->writer != NULL)
+    {
+        __atomic_store_n(&trace->writer->stop, true, __ATOMIC_RELEASE);
+        pthread_join(trace->writer->thread, NULL);
+
+        written = trace->writer->written;
+        if (fclose(trace->writer->file) != 0)
+            written = false;
+        free(trace->writer);
+    }
+
+    free(trace->records);
+    free(trace);
+    Chip8->trace = NULL;
+
+    return written;
+}
+
+/**
+* Decodes a trace file to text, one line for each opcode with its cycle, address, disassembly and the registers it left
+*
+* @param filenamein trace file written by Chip8TraceStart or Chip8TraceDump
+* @param filenameout text file to write
+* @return false if the trace could not be read or the text could not be written.
+*/
+bool Chip8TraceDecode(char *filenamein, char *filenameout)
+{
+    FILE *in = fopen(filenamein, "rb");
+    if (in == NULL)
+        return false;
+
+    unsigned char header[5];
+    if (fread(header, 1, 5, in) != 5 || memcmp(header, CHIP8_TRACE_MAGIC, 4) != 0 || header[4] != CHIP8_TRACE_VERSION)
+    {
+        fclose(in);
+        return false;
+    }
+
+    FILE *out = fopen(filenameout, "w");
+    if (out == NULL)
+    {
+        fclose(in);
+        return false;
+    }
+
+    fprintf(out, "%-20s %-4s %-4s  %-20s %-5s %-6s %s\n", "cycle", "pc", "op", "", "I", "Vx", "VF");
+
+    unsigned char data[CHIP8_TRACE_RECORD_SIZE];
+    while (fread(data, 1, CHIP8_TRACE_RECORD_SIZE, in) == CHIP8_TRACE_RECORD_SIZE)
+    {
+        uint64_t cycle = 0;
+        for (int b = 7; b >= 0; b--)
+            cycle = (cycle << 8) | data[b];
+        unsigned short pc = data[8] | (data[9] << 8);
+        unsigned short opcode = data[10] | (data[11] << 8);
+        unsigned short I = data[12] | (data[13] << 8);
+
+        if (pc == CHIP8_TRACE_LOST)
+        {
+            fprintf(out, "... %llu records lost\n", (unsigned long long)cycle);
+            continue;
+        }
+
+        char name[50];
+        Chip8Disassemble(opcode, name);
+
+        fprintf(out, "%-20llu %03X  %04X  %-20s I=%03X V%X=%02X VF=%02X\n", (unsigned long long)cycle, pc, opcode, name, I,
+            (opcode >> 8) & 0x0F, data[14], data[15]);
+    }
+
+    fclose(in);
+    return fclose(out) == 0;
+}
@@ -0,0 +1,149 @@
+/**
+* Chip-8 Instruction Trace
+* 
+* Chip-8 is a simple, interpreted, programming language which was first used on some do-it-yourself computer systems 
+* in the late 1970s and early 1980s. The COSMAC VIP, DREAM 6800, and ETI 660 computers are a few examples. 
+* These computers typically were designed to use a television as a display, had between 1 and 4K of RAM, and used a 16-key hexadecimal keypad for input. 
+* The interpreter took up only 512 bytes of memory, and programs, which were entered into the computer in hexadecimal, were even smaller.
+*
+* In the early 1990s, the Chip-8 language was revived by a man named Andreas Gustafsson. He created a Chip-8 interpreter for the HP48 graphing calculator, 
+* called Chip-48. The HP48 was lacking a way to easily make fast games at the time, and Chip-8 was the answer. Chip-48 later begat Super Chip-48, 
+* a modification of Chip-48 which allowed higher resolution graphics, as well as other graphical enhancements.
+*
+* Chip-48 inspired a whole new crop of Chip-8 interpreters for various platforms, including MS-DOS, Windows 3.1, Amiga, HP48, MSX, Adam, and ColecoVision.
+*
+* Technical Reference(used for this emulator): http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
+*
+* More information: https://en.wikipedia.org/wiki/CHIP-8
+* 
+* @author  James Kozlowski
+* @version April 2, 2017
+*/
+
+
+#ifndef CHIP8_TRACE_H
+#define CHIP8_TRACE_H
+
+#include "Chip8.h"
+
+/*
+ Trace files start with CHIP8_TRACE_MAGIC and a version byte, followed by CHIP8_TRACE_RECORD_SIZE byte records:
+ 8 byte cycle, 2 byte pc, 2 byte opcode, then I, Vx (x from the opcode) and VF as they were after the opcode ran.
+ A record with pc CHIP8_TRACE_LOST marks records that were overwritten before they were written, its cycle is how many.
+ Numbers are little endian.
+*/
+#define CHIP8_TRACE_MAGIC           "C8TR"
+#define CHIP8_TRACE_VERSION         1
+#define CHIP8_TRACE_RECORD_SIZE     16
+#define CHIP8_TRACE_LOST            0xFFFF
+
+//records kept in memory by default, 4M records (64MB) is about 70 minutes of play at 16 opcodes a frame
+#define CHIP8_TRACE_DEFAULT_RECORDS (4 * 1024 * 1024)
+
+//one opcode that ran, the layout is the layout of the file on little endian hosts
+typedef struct
+{
+    uint64_t cycle;
+    unsigned short pc;
+    unsigned short opcode;
+    unsigned short I;
+    unsigned char vx;
+    unsigned char vf;
+} Chip8TraceRecord;
+
+//a ring of the last opcodes that ran, kept in Chip8->trace while tracing
+//Only the thread running the machine writes to it, the writer thread reads behind it and never holds it up:
+//records it has not written when the ring comes round again are overwritten and counted as lost.
+typedef struct Chip8Trace
+{
+    Chip8TraceRecord *records;
+    uint64_t mask;
+
+    //records added since the trace started, the next one goes at head & mask
+    uint64_t head __attribute__((aligned(64)));
+
+    //the thread writing the records to a file and its state, see Chip8Trace.c, NULL when only keeping them in memory
+    struct Chip8TraceWriter *writer __attribute__((aligned(64)));
+} Chip8Trace;
+
+/**
+* Adds a opcode that has just run to the ring
+*
+* @param trace the trace
+* @param cycle the number of the opcode, Chip8->cycles while it ran
+* @param pc address of the opcode
+* @param opcode the opcode
+* @param I value of I after the opcode
+* @param V the registers after the opcode
+* @return Nothing.
+*/
+static inline void Chip8TraceAdd(Chip8Trace *trace, uint64_t cycle, unsigned short pc, unsigned short opcode, unsigned short I, const unsigned char *V)
+{
+    uint64_t head = trace->head;
+    Chip8TraceRecord *record = &trace->records[head & trace->mask];
+
+    record->cycle = cycle;
+    record->pc = pc;
+    record->opcode = opcode;
+    record->I = I;
+    record->vx = V[(opcode >> 8) & 0x0F];
+    record->vf = V[0xF];
+
+    //the record is written before the writer thread can see it
+    __atomic_store_n(&trace->head, head + 1, __ATOMIC_RELEASE);
+}
+
+//tracing is only compiled in when built with -DCHIP8_TRACE, and only runs after Chip8TraceStart
+#ifdef CHIP8_TRACE
+#define CHIP8_TRACE_RUN(Chip8, cycle, pc, opcode, I, V)                         \
+    do                                                                          \
+    {                                                                           \
+        if ((Chip8)->trace != NULL)                                             \
+            Chip8TraceAdd((Chip8)->trace, (cycle), (pc), (opcode), (I), (V));   \
+    } while (0)
+#else
+#define CHIP8_TRACE_RUN(Chip8, cycle, pc, opcode, I, V)     do { } while (0)
+#endif
+
+/**
+* Starts tracing every opcode a machine runs into a ring of the last records opcodes
+* With a file name a thread writes the records to the file as they come, otherwise they are only kept in memory
+* and Chip8TraceDump writes the last of them. The JIT runs the threaded backend while tracing.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to stream the trace to, or NULL
+* @param records size of the ring, rounded up to a power of 2, 0 for CHIP8_TRACE_DEFAULT_RECORDS
+* @return false if the machine is already traced, there was no memory, the file or thread could not be made,
+*         or the emulator was built without CHIP8_TRACE.
+*/
+bool Chip8TraceStart(Chip8CPU *Chip8, char *filename, size_t records);
+
+/**
+* Writes the records still in the ring to a trace file, the last opcodes the machine ran
+* Call it from the thread running the machine.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @param filename file to write
+* @return false if the machine is not traced or the file could not be written.
+*/
+bool Chip8TraceDump(Chip8CPU *Chip8, char *filename);
+
+/**
+* Stops tracing a machine, waits for the writer thread to write the rest of the records and frees the ring
+* Must be called before Chip8Free on a machine that is traced.
+*
+* @param Chip8 Address of the Chip8CPU object
+* @return false if the streamed file could not be written.
+*/
+bool Chip8TraceStop(Chip8CPU *Chip8);
+
+/**
+* Decodes a trace file to text, one line for each opcode with its cycle, address, disassembly and the registers it left
+*
+* @param filenamein trace file written by Chip8TraceStart or Chip8TraceDump
+* @param filenameout text file to write
+* @return false if the trace could not be read or the text could not be written.
+*/
+bool Chip8TraceDecode(char *filenamein, char *filenameout);
+
+#endif //header guard CHIP8_TRACE_H
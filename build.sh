@@ -1,2 +1,3 @@
-g++ -c Chip8Emulator.cpp  Chip8.c Chip8Disassembler.c Chip8Assembler.c
-g++ Chip8.o Chip8Emulator.o Chip8Disassembler.o Chip8Assembler.o -o Chip8Emu -lsfml-graphics -lsfml-window -lsfml-system
\ No newline at end of file
+g++ -O2 -c Chip8Emulator.cpp  Chip8.c Chip8Threaded.c Chip8Jit.c Chip8Pool.c Chip8Lanes.c Chip8Batch.c Chip8Rewind.c Chip8Movie.c Chip8Stats.c Chip8Profile.c Chip8CallGraph.c Chip8Trace.c Chip8Metrics.c Chip8Disassembler.c Chip8Assembler.c Chip8Bench.c
+g++ Chip8.o Chip8Threaded.o Chip8Jit.o Chip8Pool.o Chip8Lanes.o Chip8Batch.o Chip8Rewind.o Chip8Movie.o Chip8Stats.o Chip8Profile.o Chip8CallGraph.o Chip8Trace.o Chip8Metrics.o Chip8Emulator.o Chip8Disassembler.o Chip8Assembler.o -o Chip8Emu -lsfml-graphics -lsfml-window -lsfml-system -lpthread
+g++ Chip8Bench.o Chip8.o Chip8Threaded.o Chip8Jit.o Chip8Batch.o Chip8Metrics.o Chip8Disassembler.o Chip8Assembler.o -o Chip8Bench -lpthread
\ No newline at end of file